@@ -0,0 +1,61 @@
+// Microbenchmark harness, for the device and the native build
+//
+// runBench() calls the kernel in batches, doubling the batch until one takes at least
+// BENCH_MIN_US, and prints the last batch as one JSON line:
+//
+//   {"bench":"zone_parse","platform":"esp32","iterations":4096,"ns_per_op":38250,
+//    "bytes_per_op":1000,"allocs_per_op":1,"heap_high_water":1000}
+//
+// bytes_per_op and allocs_per_op count every malloc, calloc and realloc the kernel makes;
+// heap_high_water is the most it ever had allocated at once. They come from the heap
+// profile's --wrap'ed allocator in src/HeapProfile.cpp, so they mean the same on both
+// platforms.
+
+#pragma once
+
+#include <Arduino.h>
+#include <HeapProfile.h>
+
+#define BENCH_MIN_US 200000 // Shortest batch that counts
+#define BENCH_MAX_ITERATIONS (1UL << 22)
+
+#if defined(ARDUINO_ARCH_ESP32)
+#define BENCH_PLATFORM "esp32"
+#else
+#define BENCH_PLATFORM "native"
+#endif
+
+// Keeps the compiler from optimising a result away
+template <typename T>
+inline void benchKeep(const T &value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+template <typename Kernel>
+void runBench(const char *name, Kernel kernel)
+{
+    kernel(); // Warm up: first-use allocations and caches
+
+    uint32_t iterations = 1;
+    for (;;)
+    {
+        HeapTotals before = heapTotals();
+        heapResetPeak();
+        uint32_t start = micros();
+        for (uint32_t i = 0; i < iterations; i++) { kernel(); }
+        uint32_t elapsed = micros() - start;
+        HeapTotals after = heapTotals();
+
+        if ((elapsed >= BENCH_MIN_US) || (iterations >= BENCH_MAX_ITERATIONS))
+        {
+            Serial.printf("{\"bench\":\"%s\",\"platform\":\"%s\",\"iterations\":%u,\"ns_per_op\":%.1f,"
+                          "\"bytes_per_op\":%.1f,\"allocs_per_op\":%.2f,\"heap_high_water\":%ld}\n",
+                          name, BENCH_PLATFORM, (unsigned)iterations, elapsed * 1000.0 / iterations,
+                          (double)(after.bytes - before.bytes) / iterations, (double)(after.allocs - before.allocs) / iterations,
+                          (long)(after.peak - before.live));
+            return;
+        }
+        iterations *= 2;
+    }
+}
@@ -0,0 +1,83 @@
+// Microbenchmarks of the keypad's hot paths
+//
+//   pio run -e bench_native && .pio/build/bench_native/program --run-ms 1
+//   pio run -e bench_esp32 -t upload && pio device monitor -e bench_esp32
+//
+// Each kernel prints one JSON line (see Bench.h), then a summary line with the heap.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ApiCodec.h>
+#include <ApiText.h>
+#include <BmpRow.h>
+#include "Bench.h"
+#include "Payloads.h"
+
+// Parse a response the way the keypad does, into a document of the size it uses
+template <size_t Capacity>
+static void benchParse(const char *name, const char *payload)
+{
+    String body(payload);
+    DynamicJsonDocument probe(Capacity);
+    DeserializationError error = ApiCodec::deserialize(probe, body);
+    if (error)
+    {
+        Serial.printf("{\"bench\":\"%s\",\"error\":\"%s\"}\n", name, error.c_str());
+        return;
+    }
+
+    runBench(name, [&body]() {
+        DynamicJsonDocument doc(Capacity);
+        ApiCodec::deserialize(doc, body);
+        benchKeep(doc);
+    });
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(100);
+
+    benchParse<API_STATUS_DOC_SIZE>("status_parse", STATUS_PAYLOAD);
+    benchParse<API_ZONE_DOC_SIZE>("zone_parse", ZONE_PAYLOAD);
+    benchParse<API_SOURCE_DOC_SIZE>("source_parse", SOURCE_PAYLOAD);
+    benchParse<API_STREAM_DOC_SIZE>("stream_parse", STREAM_PAYLOAD);
+
+    // One row of a full width BMP, converted in place as drawBmp() does
+    static uint8_t row[240 * 3];
+    for (size_t i = 0; i < sizeof(row); i++) { row[i] = (uint8_t)(i * 7); }
+    runBench("bmp_row_240", []() {
+        bmpRowToRgb565(row, 240);
+        benchKeep(row);
+    });
+
+    String sourceInput("stream=1004");
+    runBench("get_value", [&sourceInput]() {
+        String streamID = getValue(sourceInput, '=', 1);
+        benchKeep(streamID);
+    });
+
+    String zone("1");
+    runBench("api_url", [&zone]() {
+        String url = apiUrl("amplipi.local", "zones/" + zone);
+        benchKeep(url);
+    });
+
+    runBench("volume_payload", []() {
+        String payload = volumePayload(-38);
+        benchKeep(payload);
+    });
+
+    runBench("mute_payload", []() {
+        String payload = mutePayload(true);
+        benchKeep(payload);
+    });
+
+    Serial.printf("{\"summary\":true,\"platform\":\"%s\",\"free_heap\":%u,\"min_free_heap\":%u}\n",
+                  BENCH_PLATFORM, (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMinFreeHeap());
+}
+
+void loop()
+{
+    delay(1000);
+}
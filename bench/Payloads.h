@@ -0,0 +1,15 @@
+// AmpliPi responses recorded from a four source, six zone install, for the benchmarks
+
+#pragma once
+
+// GET /api/zones/1
+static const char ZONE_PAYLOAD[] = R"json({"id":1,"name":"Kitchen","source_id":0,"mute":false,"disabled":false,"vol":-38,"vol_f":0.5189873,"vol_min":-79,"vol_max":0})json";
+
+// GET /api/sources/0
+static const char SOURCE_PAYLOAD[] = R"json({"id":0,"name":"Input 1","input":"stream=1004","info":{"name":"Groove Salad - internet radio","state":"playing","artist":"Bonobo","album":"Migration","song":"Kerala","station":"Groove Salad: a nicely chilled plate of ambient beats and grooves","img_url":"static/imgs/internet_radio.png","supported_cmds":["play","stop"]}})json";
+
+// GET /api/streams/1004
+static const char STREAM_PAYLOAD[] = R"json({"id":1004,"name":"Groove Salad","type":"internetradio","url":"http://ice2.somafm.com/groovesalad-128-mp3","logo":"https://somafm.com/img3/groovesalad-400.jpg","status":"playing","info":{"name":"Groove Salad - internet radio","state":"playing","artist":"Bonobo","album":"Migration","song":"Kerala","station":"Groove Salad: a nicely chilled plate of ambient beats and grooves","img_url":"https://somafm.com/img3/groovesalad-400.jpg","supported_cmds":["play","stop"]},"browsable":false})json";
+
+// GET /api/
+static const char STATUS_PAYLOAD[] = R"json({"sources":[{"id":0,"name":"Input 1","input":"stream=1004","info":{"name":"Groove Salad - internet radio","state":"playing","img_url":"static/imgs/internet_radio.png"}},{"id":1,"name":"Input 2","input":"local","info":{"name":"Input 2","state":"unknown","img_url":"static/imgs/rca_inputs.svg"}},{"id":2,"name":"Input 3","input":"stream=1001","info":{"name":"Kitchen Pandora - pandora","state":"stopped","img_url":"static/imgs/pandora.png"}},{"id":3,"name":"Input 4","input":"","info":{"name":"None","state":"stopped","img_url":"static/imgs/disconnected.png"}}],"zones":[{"id":0,"name":"Living Room","source_id":0,"mute":false,"disabled":false,"vol":-40,"vol_f":0.4936709,"vol_min":-79,"vol_max":0},{"id":1,"name":"Kitchen","source_id":0,"mute":false,"disabled":false,"vol":-38,"vol_f":0.5189873,"vol_min":-79,"vol_max":0},{"id":2,"name":"Dining Room","source_id":0,"mute":true,"disabled":false,"vol":-50,"vol_f":0.3670886,"vol_min":-79,"vol_max":0},{"id":3,"name":"Patio","source_id":2,"mute":true,"disabled":false,"vol":-79,"vol_f":0.0,"vol_min":-79,"vol_max":0},{"id":4,"name":"Office","source_id":1,"mute":false,"disabled":false,"vol":-45,"vol_f":0.4303797,"vol_min":-79,"vol_max":0},{"id":5,"name":"Garage","source_id":3,"mute":true,"disabled":true,"vol":-79,"vol_f":0.0,"vol_min":-79,"vol_max":0}],"groups":[{"id":100,"name":"Downstairs","zones":[0,1,2],"source_id":0,"mute":false,"vol_delta":-38,"vol_f":0.5189873}],"streams":[{"id":1000,"name":"Kitchen AirPlay","type":"airplay","status":"connected","info":{"name":"Kitchen AirPlay - airplay","state":"connected"}},{"id":1001,"name":"Kitchen Pandora","type":"pandora","status":"stopped","info":{"name":"Kitchen Pandora - pandora","state":"stopped"}},{"id":1002,"name":"Spotify","type":"spotify","status":"disconnected","info":{"name":"Spotify - spotify","state":"disconnected"}},{"id":1003,"name":"DLNA","type":"dlna","status":"disconnected","info":{"name":"DLNA - dlna","state":"disconnected"}},{"id":1004,"name":"Groove Salad","type":"internetradio","status":"playing","info":{"name":"Groove Salad - internet radio","state":"playing"}},{"id":1005,"name":"Patio Bluetooth","type":"bluetooth","status":"disconnected","info":{"name":"Patio Bluetooth - bluetooth","state":"disconnected"}}],"presets":[{"id":10000,"name":"Mute All","state":{"zones":[{"id":0,"mute":true},{"id":1,"mute":true},{"id":2,"mute":true},{"id":3,"mute":true},{"id":4,"mute":true},{"id":5,"mute":true}]}}],"info":{"version":"0.4.0","config_file":"house.json","mock_ctrl":false,"mock_streams":false,"is_streamer":false,"online":true,"latest_release":"0.4.0"}})json";
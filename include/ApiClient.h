@@ -0,0 +1,143 @@
+// Requests to AmpliPi as the keypad makes them, shared with the fleet load generator
+//
+// The tuning here and the helpers below are used by the firmware and by tools/fleet, so a
+// simulated fleet sends exactly the requests real keypads do. Each caller wraps them in
+// its own bookkeeping: the firmware's timings and warning, the fleet's statistics.
+//
+// A blocking request is begun on an HTTPClient by the caller, then apiPrepareGet() or
+// apiPreparePatch() adds the headers and timeouts. A polled GET runs on an AsyncHttpGet,
+// started with apiStartPoll() and collected with apiTakePoll(). followSource() is the
+// refresh flow's step from a source poll to the stream poll.
+
+#pragma once
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <ApiCodec.h>
+#include <AsyncHttp.h>
+#include <GzipInflate.h>
+#include <PollScheduler.h>
+#include <ResponseFingerprint.h>
+
+// Largest API response the keypad will accept once inflated (in bytes)
+#define API_MAX_RESPONSE 16384
+#define API_TIMEOUT 5000 // Connecting, and then waiting for the response (in milliseconds)
+
+// Talk MessagePack to AmpliPi where it supports it, JSON otherwise
+#define API_MSGPACK true
+#define API_PACKED_MAX 128 // Largest MessagePack payload sent (in bytes)
+
+// How quickly does the metadata refresh while playing (in milliseconds). The default for
+// the stored setting.
+#define REFRESH_INTERVAL 5000
+
+// How quickly the other resources are polled (in milliseconds)
+#define POLL_ACTIVE_INTERVAL 2000   // Anything, shortly after a touch or track change
+#define POLL_SETTLED_INTERVAL 15000 // Zones and source while playing
+#define POLL_IDLE_INTERVAL 60000    // Anything while paused, stopped or on local input
+
+// Volume and source rarely change from elsewhere, the song does
+inline void configurePolling(PollScheduler &scheduler, uint32_t refreshMs)
+{
+    scheduler.configure(POLL_ZONES, PollIntervals{POLL_ACTIVE_INTERVAL, POLL_SETTLED_INTERVAL, POLL_IDLE_INTERVAL});
+    scheduler.configure(POLL_SOURCE, PollIntervals{POLL_ACTIVE_INTERVAL, POLL_SETTLED_INTERVAL, POLL_IDLE_INTERVAL});
+    scheduler.configure(POLL_STREAM, PollIntervals{POLL_ACTIVE_INTERVAL, refreshMs, POLL_IDLE_INTERVAL});
+}
+
+// Headers and timeouts for a GET, once http has been begun
+inline void apiPrepareGet(HTTPClient &http, const ApiCodec &codec)
+{
+    static const char *responseHeaders[] = {"Content-Encoding"};
+    http.setConnectTimeout(API_TIMEOUT);
+    http.setTimeout(API_TIMEOUT);
+    http.useHTTP10(true); // No chunked encoding, so a gzip body can be inflated straight off the connection
+    http.addHeader("Accept", codec.accept());
+    http.addHeader("Accept-Encoding", "gzip");
+    http.collectHeaders(responseHeaders, 1);
+}
+
+// Read the body of a 200 response into payload. Returns false, with payload empty, if a
+// gzip body wouldn't inflate.
+inline bool apiReadBody(HTTPClient &http, ApiCodec &codec, String &payload)
+{
+    payload = "";
+    // Servers that ignore Accept-Encoding send the body as it is
+    if (http.header("Content-Encoding") == "gzip")
+    {
+        GzipInflater gzip;
+        if (!gzip.inflate(*http.getStreamPtr(), payload, API_MAX_RESPONSE))
+        {
+            payload = "";
+            return false;
+        }
+    }
+    else
+    {
+        payload = http.getString();
+    }
+    codec.received(payload);
+    return true;
+}
+
+// Headers and timeouts for a PATCH of payload, once http has been begun. Packs payload
+// into packed, which holds API_PACKED_MAX bytes, if AmpliPi takes MessagePack. Returns
+// the packed size, or 0 to send it as JSON.
+inline size_t apiPreparePatch(HTTPClient &http, const ApiCodec &codec, const String &payload, uint8_t *packed)
+{
+    size_t packedSize = codec.pack(payload, packed, API_PACKED_MAX);
+    http.setConnectTimeout(API_TIMEOUT);
+    http.setTimeout(API_TIMEOUT);
+    http.addHeader("Accept", codec.accept());
+    http.addHeader("Content-Type", packedSize ? API_TYPE_MSGPACK : API_TYPE_JSON);
+    return packedSize;
+}
+
+inline int apiSendPatch(HTTPClient &http, const String &payload, uint8_t *packed, size_t packedSize)
+{
+    return packedSize ? http.PATCH(packed, packedSize) : http.PATCH(payload);
+}
+
+// Start polling request, asking for a 304 if the last response seen still stands and
+// conditional is set
+inline bool apiStartPoll(AsyncHttpGet &get, const char *host, const ApiCodec &codec, const ResponseFingerprint &seen,
+                         const String &request, bool conditional = true)
+{
+    return get.start(host, "/api/" + request, codec.accept(), conditional ? seen.ifNoneMatch(request) : nullptr);
+}
+
+// Collect a poll and compare it with the last response seen. take(get, request, json)
+// takes the response and does the caller's bookkeeping, returning false if it failed.
+template <typename Take>
+ResponseChange apiTakePoll(AsyncHttpGet &get, ResponseFingerprint &seen, const String &request, String &json, Take take)
+{
+    String etag = get.header("ETag");
+    bool notModified = get.notModified();
+    if (!take(get, request, json))
+        return RESPONSE_FAILED;
+    return seen.compare(request, json, notModified, etag);
+}
+
+// After the zones and source polls: fetched is whether the source was polled, and
+// streamID the stream it plays ("" if the poll failed or the source is idle). Follows a
+// change of stream into current. Returns false if there is no stream to poll, in which
+// case the stream waits for the next source poll rather than coming straight back.
+inline bool followSource(PollScheduler &scheduler, uint32_t nowMs, bool fetched, const String &streamID, String &current)
+{
+    if (fetched)
+    {
+        bool changed = (streamID != "") && (streamID != current);
+        scheduler.polled(POLL_SOURCE, nowMs, changed);
+        if (changed)
+        {
+            current = streamID;
+            scheduler.trackChanged(nowMs);
+        }
+    }
+
+    if ((fetched && (streamID == "")) || (current == ""))
+    {
+        scheduler.reschedule(POLL_STREAM, nowMs);
+        return false;
+    }
+    return true;
+}
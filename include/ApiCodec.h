@@ -0,0 +1,85 @@
+// Wire format of AmpliPi API bodies: JSON, or MessagePack when the server speaks it
+//
+// Requests ask for MessagePack with JSON as the fallback, and a response is told apart by
+// its first byte, since every API body is an object: JSON starts with '{' and a
+// MessagePack map with 0x80-0x8F, 0xDE or 0xDF. Payloads are built as JSON on the UI
+// task and go out as JSON until AmpliPi has answered a request in MessagePack; from then
+// on the network task packs them just before sending. Stock AmpliPi only reads JSON and
+// answers anything else with 400, 415 or 422, after which payloads stay JSON for good.
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Trace.h>
+#include <atomic>
+
+#define API_TYPE_JSON "application/json"
+#define API_TYPE_MSGPACK "application/msgpack"
+#define API_ACCEPT_ANY "application/msgpack, application/json;q=0.5"
+#define API_PACK_DOC_SIZE 256 // Room to re-encode a payload, which is only ever a field or two
+
+class ApiCodec
+{
+public:
+    explicit ApiCodec(bool useMsgPack) : msgPack(useMsgPack), sendMsgPack(false), refusedMsgPack(false) {}
+
+    // Accept header for requests
+    const char *accept() const { return msgPack ? API_ACCEPT_ANY : API_TYPE_JSON; }
+
+    // Pack a JSON payload as MessagePack into buffer. Returns the packed size, or 0 if the
+    // payload should go out as JSON.
+    size_t pack(const String &json, uint8_t *buffer, size_t size) const
+    {
+        if (!sendMsgPack.load(std::memory_order_relaxed))
+            return 0;
+
+        DynamicJsonDocument doc(API_PACK_DOC_SIZE);
+        if (deserializeJson(doc, json))
+            return 0;
+        // Into a buffer rather than a String: MessagePack has zero bytes in it
+        return serializeMsgPack(doc, (char *)buffer, size);
+    }
+
+    // A response body arrived. One in MessagePack shows AmpliPi speaks it, so payloads
+    // can be packed too.
+    void received(const String &body)
+    {
+        if (msgPack && isMsgPack(body) && !refusedMsgPack.load(std::memory_order_relaxed))
+            sendMsgPack.store(true, std::memory_order_relaxed);
+    }
+
+    // AmpliPi answered a MessagePack payload with httpCode. Returns true if that refused
+    // it, in which case the payload should be sent again as JSON.
+    bool refused(int httpCode)
+    {
+        if ((httpCode != 400) && (httpCode != 415) && (httpCode != 422))
+            return false;
+        refusedMsgPack.store(true, std::memory_order_relaxed);
+        if (sendMsgPack.exchange(false))
+            Serial.println("AmpliPi doesn't accept MessagePack, sending JSON");
+        return true;
+    }
+
+    static bool isMsgPack(const String &body)
+    {
+        if (body.length() == 0)
+            return false;
+        uint8_t first = (uint8_t)body[0];
+        return ((first & 0xF0) == 0x80) || (first == 0xDE) || (first == 0xDF);
+    }
+
+    // Deserialize a response body in whichever format it came in
+    static DeserializationError deserialize(JsonDocument &doc, const String &body)
+    {
+        TRACE_SCOPE("json parse");
+        if (isMsgPack(body))
+            return deserializeMsgPack(doc, body.c_str(), body.length());
+        return deserializeJson(doc, body);
+    }
+
+private:
+    const bool msgPack;                // Ask for MessagePack responses
+    std::atomic<bool> sendMsgPack;     // Send MessagePack payloads, once AmpliPi has answered in it
+    std::atomic<bool> refusedMsgPack;  // AmpliPi refused a MessagePack payload
+};
@@ -0,0 +1,303 @@
+// Queue of AmpliPi API requests run by background network tasks
+//
+// The UI submits a request and gets an ApiCall handle back straight away. A worker task
+// runs the request and leaves the response in the job's slot, where a flow picks it up
+// with finished() and take(). A call can be cancelled at any point: if it hasn't started
+// it never runs, otherwise its result is thrown away when it completes.
+//
+// Requests are prioritized so a tap never waits behind a refresh:
+//  - Interactive requests (mute, volume, source changes) have a worker of their own.
+//  - Visible state GETs and background transfers (album art) share the main worker,
+//    which always takes the visible work first.
+//  - A background transfer that checks preempted() gives up as soon as anything more
+//    important is waiting, and is retried on the next refresh.
+//
+// submit(), finished(), take() and cancel() must all be called from the UI task.
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#define API_JOB_SLOTS 8
+#define API_WORKER_STACK 8192
+#define API_WORKER_PRIORITY 1 // Both workers share a priority so neither can starve the other on the state store's spin lock
+#define API_WORKER_CORE 0
+
+enum ApiMethod : uint8_t
+{
+    API_GET,      // Response body ends up in ApiJob::body
+    API_PATCH,    // ApiJob::body is sent as the JSON payload
+    API_DOWNLOAD, // Album art download, ApiJob::path is the stream ID
+};
+
+enum ApiPriority : uint8_t
+{
+    API_INTERACTIVE, // Commands from a touch, run on their own worker
+    API_VISIBLE,     // State that is on screen
+    API_BACKGROUND,  // Album art and anything else that can wait
+    API_PRIORITIES
+};
+
+enum ApiJobState : uint8_t
+{
+    JOB_FREE,
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE,
+    JOB_CANCELLED,
+};
+
+struct ApiJob
+{
+    std::atomic<uint8_t> state;
+    uint8_t generation; // Bumped every time the slot is reused, so stale handles can be spotted
+    bool detached;      // Nobody waits for the result, the worker frees the slot itself
+    bool ok;
+    ApiMethod method;
+    ApiPriority priority;
+    String path;
+    String body; // Request payload going in, response payload coming out
+};
+
+struct ApiCall
+{
+    uint8_t slot;
+    uint8_t generation;
+};
+
+#define API_CALL_NONE (ApiCall{0xFF, 0})
+
+// Runs one job on a worker task. Returns true on success.
+typedef bool (*ApiJobRunner)(ApiJob &job);
+
+class ApiJobQueue
+{
+public:
+    ApiJobQueue() : mainWork(nullptr), runner(nullptr), nextGeneration(0)
+    {
+        for (uint8_t p = 0; p < API_PRIORITIES; p++)
+        {
+            queues[p] = nullptr;
+            outstanding[p].store(0);
+        }
+    }
+
+    void begin(ApiJobRunner jobRunner)
+    {
+        runner = jobRunner;
+        for (uint8_t p = 0; p < API_PRIORITIES; p++)
+        {
+            queues[p] = xQueueCreate(API_JOB_SLOTS, sizeof(uint8_t));
+        }
+        mainWork = xSemaphoreCreateCounting(API_JOB_SLOTS, 0);
+        xTaskCreatePinnedToCore(interactiveTask, "apiInteractive", API_WORKER_STACK, this, API_WORKER_PRIORITY, nullptr, API_WORKER_CORE);
+        xTaskCreatePinnedToCore(mainTask, "apiWorker", API_WORKER_STACK, this, API_WORKER_PRIORITY, nullptr, API_WORKER_CORE);
+    }
+
+    // Queue a request. PATCHes default to interactive, GETs to visible and downloads to
+    // background. Returns API_CALL_NONE if every slot is busy.
+    ApiCall submit(ApiMethod method, const String &path, const String &body = String(), bool detached = false)
+    {
+        return submit(method, defaultPriority(method), path, body, detached, nullptr);
+    }
+
+    ApiCall submit(ApiMethod method, ApiPriority priority, const String &path, const String &body, bool detached, const char *coalesceKey)
+    {
+        for (uint8_t i = 0; i < API_JOB_SLOTS; i++)
+        {
+            ApiJob &job = jobs[i];
+            if (job.state.load(std::memory_order_acquire) != JOB_FREE)
+                continue;
+
+            job.generation = ++nextGeneration;
+            job.detached = detached;
+            job.ok = false;
+            job.method = method;
+            job.priority = priority;
+            coalesceHash[i] = coalesceKey ? hashKey(path, coalesceKey) : 0;
+            job.path = path;
+            job.body = body;
+            job.state.store(JOB_QUEUED, std::memory_order_release);
+            outstanding[priority].fetch_add(1);
+            xQueueSend(queues[priority], &i, 0);
+            if (priority != API_INTERACTIVE) { xSemaphoreGive(mainWork); }
+            return ApiCall{i, job.generation};
+        }
+
+        Serial.println("API queue full, dropping request: " + path);
+        return API_CALL_NONE;
+    }
+
+    // Fire-and-forget interactive request that replaces any queued one with the same path
+    // and key, so dragging the volume slider sends the latest level rather than every step
+    // on the way.
+    void submitLatest(ApiMethod method, const String &path, const String &body, const char *key)
+    {
+        uint32_t hash = hashKey(path, key);
+        for (uint8_t i = 0; i < API_JOB_SLOTS; i++)
+        {
+            if (coalesceHash[i] == hash)
+            {
+                uint8_t state = JOB_QUEUED;
+                jobs[i].state.compare_exchange_strong(state, JOB_CANCELLED); // The worker drops it when it comes up
+            }
+        }
+        submit(method, API_INTERACTIVE, path, body, true, key);
+    }
+
+    // True once the call has completed. A dropped or stale call counts as finished.
+    bool finished(const ApiCall &call) const
+    {
+        if (!valid(call))
+            return true;
+        return jobs[call.slot].state.load(std::memory_order_acquire) == JOB_DONE;
+    }
+
+    // Collect a finished call's response and free its slot. Returns false if the
+    // request failed or the call was dropped.
+    bool take(ApiCall &call, String &response)
+    {
+        bool ok = false;
+        if (valid(call) && jobs[call.slot].state.load(std::memory_order_acquire) == JOB_DONE)
+        {
+            ApiJob &job = jobs[call.slot];
+            ok = job.ok;
+            response = job.body;
+            release(job);
+        }
+        call = API_CALL_NONE;
+        return ok;
+    }
+
+    // Give up on a call, whatever stage it is at
+    void cancel(ApiCall &call)
+    {
+        if (valid(call))
+        {
+            ApiJob &job = jobs[call.slot];
+            uint8_t state = JOB_QUEUED;
+            if (!job.state.compare_exchange_strong(state, JOB_CANCELLED))
+            {
+                state = JOB_RUNNING;
+                if (!job.state.compare_exchange_strong(state, JOB_CANCELLED) && state == JOB_DONE)
+                {
+                    release(job);
+                }
+            }
+        }
+        call = API_CALL_NONE;
+    }
+
+    bool pending(const ApiCall &call) const { return valid(call) && !finished(call); }
+
+    // True if anything more important than priority is queued or running. Long transfers
+    // poll this from the worker and stop early.
+    bool preempted(ApiPriority priority) const
+    {
+        for (uint8_t p = 0; p < priority; p++)
+        {
+            if (outstanding[p].load(std::memory_order_acquire) > 0)
+                return true;
+        }
+        return false;
+    }
+
+private:
+    // FNV-1a of path and key, never 0
+    static uint32_t hashKey(const String &path, const char *key)
+    {
+        uint32_t hash = 2166136261u;
+        for (const char *c = path.c_str(); *c; c++) { hash = (hash ^ (uint8_t)*c) * 16777619u; }
+        hash = (hash ^ '|') * 16777619u;
+        for (const char *c = key; *c; c++) { hash = (hash ^ (uint8_t)*c) * 16777619u; }
+        return hash ? hash : 1;
+    }
+
+    static ApiPriority defaultPriority(ApiMethod method)
+    {
+        switch (method)
+        {
+        case API_PATCH: return API_INTERACTIVE;
+        case API_DOWNLOAD: return API_BACKGROUND;
+        default: return API_VISIBLE;
+        }
+    }
+
+    bool valid(const ApiCall &call) const
+    {
+        return (call.slot < API_JOB_SLOTS) && (jobs[call.slot].generation == call.generation);
+    }
+
+    static void release(ApiJob &job)
+    {
+        job.path = "";
+        job.body = "";
+        job.state.store(JOB_FREE, std::memory_order_release);
+    }
+
+    void run(uint8_t slot)
+    {
+        ApiJob &job = jobs[slot];
+        ApiPriority priority = job.priority;
+        uint8_t state = JOB_QUEUED;
+        if (!job.state.compare_exchange_strong(state, JOB_RUNNING))
+        {
+            release(job); // Cancelled or replaced before it started
+            outstanding[priority].fetch_sub(1);
+            return;
+        }
+
+        job.ok = runner(job);
+
+        state = JOB_RUNNING;
+        if (job.detached || !job.state.compare_exchange_strong(state, JOB_DONE))
+        {
+            release(job); // Nobody is waiting for it
+        }
+        outstanding[priority].fetch_sub(1);
+    }
+
+    static void interactiveTask(void *arg)
+    {
+        ApiJobQueue *self = static_cast<ApiJobQueue *>(arg);
+        uint8_t slot;
+        for (;;)
+        {
+            if (xQueueReceive(self->queues[API_INTERACTIVE], &slot, portMAX_DELAY) == pdTRUE)
+                self->run(slot);
+        }
+    }
+
+    // Runs visible work first, background work only when there is nothing else
+    static void mainTask(void *arg)
+    {
+        ApiJobQueue *self = static_cast<ApiJobQueue *>(arg);
+        uint8_t slot;
+        for (;;)
+        {
+            if (xSemaphoreTake(self->mainWork, portMAX_DELAY) != pdTRUE)
+                continue;
+            for (uint8_t p = API_VISIBLE; p < API_PRIORITIES; p++)
+            {
+                if (xQueueReceive(self->queues[p], &slot, 0) == pdTRUE)
+                {
+                    self->run(slot);
+                    break;
+                }
+            }
+        }
+    }
+
+    ApiJob jobs[API_JOB_SLOTS];
+    QueueHandle_t queues[API_PRIORITIES];
+    SemaphoreHandle_t mainWork; // Counts jobs waiting in the visible and background queues
+    uint32_t coalesceHash[API_JOB_SLOTS] = {}; // Only touched by the UI task
+    ApiJobRunner runner;
+    uint8_t nextGeneration;
+    std::atomic<uint8_t> outstanding[API_PRIORITIES]; // Queued or running, per priority
+};
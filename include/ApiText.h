@@ -0,0 +1,60 @@
+// Strings the keypad builds and takes apart for every API call
+//
+// Kept apart from the sketch so the benchmarks in bench/ time exactly the code the keypad
+// runs: the request URL, the PATCH payloads, the split of "local=N" stream IDs, and the
+// document sizes each response is parsed into.
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define API_STATUS_DOC_SIZE 6144 // The whole /api/ status, for the source list
+#define API_ZONE_DOC_SIZE 1000
+#define API_SOURCE_DOC_SIZE 1000
+#define API_STREAM_DOC_SIZE 2000
+
+// URL of an API resource, such as "zones/1", on host
+inline String apiUrl(const char *host, const String &resource)
+{
+    return "http://" + String(host) + "/api/" + resource;
+}
+
+// PATCH body setting a zone's volume, in dB
+inline String volumePayload(int volDb)
+{
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> doc;
+    doc["vol"] = volDb;
+    String payload;
+    serializeJson(doc, payload);
+    return payload;
+}
+
+// PATCH body muting or unmuting a zone
+inline String mutePayload(bool mute)
+{
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> doc;
+    doc["mute"] = mute;
+    String payload;
+    serializeJson(doc, payload);
+    return payload;
+}
+
+// Split a string by a separator
+inline String getValue(String data, char separator, int index)
+{
+    int found = 0;
+    int strIndex[] = {0, -1};
+    int maxIndex = data.length() - 1;
+
+    for (int i = 0; i <= maxIndex && found <= index; i++)
+    {
+        if (data.charAt(i) == separator || i == maxIndex)
+        {
+            found++;
+            strIndex[0] = strIndex[1] + 1;
+            strIndex[1] = (i == maxIndex) ? i + 1 : i;
+        }
+    }
+    return found > index ? data.substring(strIndex[0], strIndex[1]) : "";
+}
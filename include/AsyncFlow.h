@@ -0,0 +1,59 @@
+// Stackless cooperative flows for multi-step interactions
+//
+// A flow is a function that is called again and again from loop() and picks up where
+// it left off, in the style of protothreads. FLOW_AWAIT() returns to the caller until
+// its condition holds, so a flow can wait on a network result without blocking the UI.
+//
+// Locals do not survive an await; anything needed across one lives in the flow's struct.
+// Declare other locals before FLOW_BEGIN() so no case label jumps over an initialization.
+//
+//   FlowStatus runExample(ExampleFlow &f)
+//   {
+//       String json;
+//       FLOW_BEGIN(f.flow);
+//       f.call = apiJobs.submit(API_GET, "zones/0");
+//       FLOW_AWAIT(f.flow, apiJobs.finished(f.call));
+//       if (!apiJobs.take(f.call, json)) { FLOW_EXIT(f.flow); }
+//       ...
+//       FLOW_END(f.flow);
+//   }
+
+#pragma once
+
+#include <stdint.h>
+
+enum FlowStatus : uint8_t
+{
+    FLOW_WAITING,
+    FLOW_DONE
+};
+
+struct Flow
+{
+    uint16_t line; // Where to resume, 0 to start from the top
+    bool active;   // Set by FLOW_START(), cleared when the flow ends or is stopped
+};
+
+// Start (or restart) a flow from the top
+#define FLOW_START(flow) do { (flow).line = 0; (flow).active = true; } while (0)
+
+// Stop a flow without running the rest of it
+#define FLOW_STOP(flow) do { (flow).line = 0; (flow).active = false; } while (0)
+
+#define FLOW_BEGIN(flow) switch ((flow).line) { case 0:
+
+// Return to the caller until cond is true, then carry on from here
+#define FLOW_AWAIT(flow, cond)          \
+    do                                  \
+    {                                   \
+        (flow).line = __LINE__;         \
+        [[fallthrough]];                \
+    case __LINE__:                      \
+        if (!(cond))                    \
+            return FLOW_WAITING;        \
+    } while (0)
+
+// Finish the flow early
+#define FLOW_EXIT(flow) do { FLOW_STOP(flow); return FLOW_DONE; } while (0)
+
+#define FLOW_END(flow) } FLOW_STOP(flow); return FLOW_DONE
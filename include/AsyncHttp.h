@@ -0,0 +1,288 @@
+// HTTP GETs on AsyncTCP, several at once without a task each
+//
+// An AsyncHttpGet is one request on its own connection. start() returns straight away;
+// AsyncTCP's callbacks connect, send the request and collect the response on the
+// async_tcp task while the UI carries on, and a flow awaits finished(). Independent
+// requests are started together and awaited together, so they take as long as the
+// slowest one rather than the sum of them.
+//
+// Requests are HTTP/1.0 with Connection: close, so the response is everything the server
+// sends before it closes the connection and there is no chunked encoding to undo.
+//
+// start(), finished(), take() and abort() must all be called from the UI task.
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <AsyncTCP.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <HeapProfile.h>
+
+#define ASYNC_HTTP_PORT 80
+#define ASYNC_HTTP_TIMEOUT 5000        // Whole request, in milliseconds
+#define ASYNC_HTTP_MAX_RESPONSE 16384  // Responses larger than this are dropped
+#define ASYNC_HTTP_RESERVE 2048        // Initial response buffer, enough for a zone or source
+
+enum AsyncHttpState : uint8_t
+{
+    HTTP_IDLE,
+    HTTP_RUNNING,
+    HTTP_DONE,   // Response complete, see status()
+    HTTP_FAILED, // Connection failed, timed out or was aborted
+};
+
+class AsyncHttpGet
+{
+public:
+    AsyncHttpGet()
+        : client(nullptr), lock(nullptr), state(HTTP_IDLE), open(false), statusCode(0), bodyStart(0), startedAt(0),
+          startedUs(0), connectedUs(0), firstByteUs(0), doneUs(0) {}
+
+    // Start a GET of path (such as "/api/zones/0") from host, which may name a port as in
+    // "amplipi.local:8080". With ifNoneMatch set the server may answer 304 instead of
+    // resending an unchanged body. Returns false if the request could not be started, in
+    // which case it counts as finished and failed.
+    bool start(const char *host, const String &path, const char *accept = "application/json", const char *ifNoneMatch = nullptr)
+    {
+        if (open.load(std::memory_order_acquire))
+        {
+            // The last request on this connection is still closing
+            state.store(HTTP_FAILED, std::memory_order_release);
+            return false;
+        }
+
+        if (client == nullptr)
+        {
+            lock = xSemaphoreCreateMutex();
+            client = new AsyncClient();
+            client->onConnect(onConnect, this);
+            client->onData(onData, this);
+            client->onDisconnect(onDisconnect, this);
+            client->onError(onError, this);
+            client->onTimeout(onTimeout, this);
+        }
+
+        request = "GET " + path + " HTTP/1.0\r\nHost: " + String(host) + "\r\nAccept: " + String(accept) + "\r\n";
+        if (ifNoneMatch) { request += "If-None-Match: " + String(ifNoneMatch) + "\r\n"; }
+        request += "Connection: close\r\n\r\n";
+        response = "";
+        response.reserve(ASYNC_HTTP_RESERVE);
+        statusCode = 0;
+        bodyStart = 0;
+        startedAt = millis();
+        startedUs = micros();
+        connectedUs = 0;
+        firstByteUs = 0;
+        doneUs = 0;
+        client->setRxTimeout(ASYNC_HTTP_TIMEOUT / 1000);
+
+        String name(host);
+        uint16_t port = ASYNC_HTTP_PORT;
+        int colon = name.indexOf(':');
+        if (colon > 0)
+        {
+            port = name.substring(colon + 1).toInt();
+            name.remove(colon);
+        }
+
+        open.store(true, std::memory_order_release);
+        state.store(HTTP_RUNNING, std::memory_order_release);
+        if (!client->connect(name.c_str(), port))
+        {
+            open.store(false, std::memory_order_release);
+            state.store(HTTP_FAILED, std::memory_order_release);
+            return false;
+        }
+        return true;
+    }
+
+    // True once the response is in or the request has failed. A request that runs past
+    // ASYNC_HTTP_TIMEOUT is aborted here.
+    bool finished()
+    {
+        uint8_t current = state.load(std::memory_order_acquire);
+        if (current != HTTP_RUNNING)
+            return true;
+        if (millis() - startedAt >= ASYNC_HTTP_TIMEOUT)
+        {
+            abort();
+            return true;
+        }
+        return false;
+    }
+
+    // Value of a response header of a finished request, or "" if it wasn't sent. Only
+    // available until take().
+    String header(const char *name) const
+    {
+        ResponseLock locked(lock);
+        if (state.load(std::memory_order_acquire) != HTTP_DONE)
+            return String();
+
+        size_t nameLen = strlen(name);
+        int line = response.indexOf("\r\n") + 2; // Skip the status line
+        while ((line > 1) && (line < bodyStart - 2))
+        {
+            int end = response.indexOf("\r\n", line);
+            const char *text = response.c_str() + line;
+            if ((end - line > (int)nameLen) && (strncasecmp(text, name, nameLen) == 0) && (text[nameLen] == ':'))
+            {
+                String value = response.substring(line + nameLen + 1, end);
+                value.trim();
+                return value;
+            }
+            line = end + 2;
+        }
+        return String();
+    }
+
+    // Collect the body of a finished request. Returns false unless the server answered 200,
+    // or 304 to a conditional request, which leaves body empty.
+    bool take(String &body)
+    {
+        ResponseLock locked(lock);
+        bool ok = ok200() || notModified();
+        body = ok200() ? response.substring(bodyStart) : String();
+        response = "";
+        state.store(HTTP_IDLE, std::memory_order_release);
+        return ok;
+    }
+
+    // Give up on the request, whatever stage it is at
+    void abort()
+    {
+        uint8_t running = HTTP_RUNNING;
+        if (state.compare_exchange_strong(running, HTTP_FAILED) && client)
+            client->close(true);
+    }
+
+    // True if the request got no complete response, so the server is probably unreachable
+    bool unreachable() const { return state.load(std::memory_order_acquire) == HTTP_FAILED; }
+
+    int status() const { return statusCode; }
+
+    bool notModified() const { return (state.load(std::memory_order_acquire) == HTTP_DONE) && (statusCode == 304); }
+
+    uint32_t elapsed() const { return millis() - startedAt; }
+
+    // Microseconds a finished request spent connecting (name lookup included), waiting for
+    // the first byte of the response and receiving the rest. 0 for phases it never finished.
+    uint32_t connectUs() const { return connectedUs ? connectedUs - startedUs : 0; }
+    uint32_t ttfbUs() const { return (connectedUs && firstByteUs) ? firstByteUs - connectedUs : 0; }
+    uint32_t bodyUs() const { return (firstByteUs && doneUs) ? doneUs - firstByteUs : 0; }
+
+private:
+    // Holds the response lock for a scope. The state check and the response change after
+    // it must happen together, or a request aborted by finished() on the UI task could
+    // have take() clear the response while onData() is still appending to it.
+    class ResponseLock
+    {
+    public:
+        explicit ResponseLock(SemaphoreHandle_t responseLock) : held(responseLock)
+        {
+            if (held) { xSemaphoreTake(held, portMAX_DELAY); }
+        }
+        ~ResponseLock()
+        {
+            if (held) { xSemaphoreGive(held); }
+        }
+
+    private:
+        SemaphoreHandle_t held;
+    };
+
+    bool ok200() const { return (state.load(std::memory_order_acquire) == HTTP_DONE) && (statusCode == 200); }
+
+    // Mark the request failed, if it is still running
+    void fail()
+    {
+        uint8_t running = HTTP_RUNNING;
+        state.compare_exchange_strong(running, HTTP_FAILED);
+    }
+
+    // Split the status line and headers off the response once the server has closed
+    void complete()
+    {
+        int headerEnd = response.indexOf("\r\n\r\n");
+        if (!response.startsWith("HTTP/") || (headerEnd < 0))
+        {
+            fail();
+            return;
+        }
+        int space = response.indexOf(' ');
+        statusCode = (space > 0) ? response.substring(space + 1, space + 4).toInt() : 0;
+        bodyStart = headerEnd + 4;
+        doneUs = micros();
+
+        uint8_t running = HTTP_RUNNING;
+        state.compare_exchange_strong(running, HTTP_DONE);
+    }
+
+    static void onConnect(void *arg, AsyncClient *c)
+    {
+        AsyncHttpGet *self = static_cast<AsyncHttpGet *>(arg);
+        self->connectedUs = micros();
+        if (c->write(self->request.c_str(), self->request.length()) != self->request.length())
+        {
+            self->fail();
+            c->close(true);
+        }
+    }
+
+    static void onData(void *arg, AsyncClient *c, void *data, size_t len)
+    {
+        HEAP_SCOPE(HEAP_API);
+        AsyncHttpGet *self = static_cast<AsyncHttpGet *>(arg);
+        ResponseLock locked(self->lock);
+        if (self->state.load(std::memory_order_acquire) != HTTP_RUNNING)
+            return;
+        if (self->response.length() + len > ASYNC_HTTP_MAX_RESPONSE)
+        {
+            Serial.println("Response too large, dropping it");
+            self->fail();
+            c->close(true);
+            return;
+        }
+        if (self->firstByteUs == 0) { self->firstByteUs = micros(); }
+        self->response.concat((const char *)data, len);
+    }
+
+    // Always the last callback of a connection, whether it closed cleanly or not
+    static void onDisconnect(void *arg, AsyncClient * /*c*/)
+    {
+        AsyncHttpGet *self = static_cast<AsyncHttpGet *>(arg);
+        {
+            ResponseLock locked(self->lock);
+            if (self->state.load(std::memory_order_acquire) == HTTP_RUNNING)
+                self->complete();
+        }
+        self->open.store(false, std::memory_order_release);
+    }
+
+    static void onError(void *arg, AsyncClient * /*c*/, int8_t /*error*/)
+    {
+        static_cast<AsyncHttpGet *>(arg)->fail();
+    }
+
+    static void onTimeout(void *arg, AsyncClient *c, uint32_t /*time*/)
+    {
+        static_cast<AsyncHttpGet *>(arg)->fail();
+        c->close(true);
+    }
+
+    AsyncClient *client; // Made on first use and reused for every request after
+    SemaphoreHandle_t lock; // Guards response between the callbacks and take()
+    std::atomic<uint8_t> state;
+    std::atomic<bool> open; // Connection not yet closed, so its callbacks may still run
+    String request;
+    String response; // Written by the callbacks while HTTP_RUNNING, only under lock
+    int statusCode;
+    int bodyStart;
+    uint32_t startedAt;
+    uint32_t startedUs; // Phase timestamps, written by the callbacks while the request runs
+    uint32_t connectedUs;
+    uint32_t firstByteUs;
+    uint32_t doneUs;
+};
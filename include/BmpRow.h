@@ -0,0 +1,21 @@
+// Pixel conversion for the 24 bit BMPs the icons and album art are stored as
+
+#pragma once
+
+#include <stdint.h>
+
+// Convert a row of w BGR pixels to 16 bit colour, in place. The result fills the first
+// w * 2 bytes of the row.
+inline void bmpRowToRgb565(uint8_t *row, uint16_t w)
+{
+    uint8_t *bptr = row;
+    uint16_t *tptr = (uint16_t *)row;
+    uint8_t r, g, b;
+    for (uint16_t col = 0; col < w; col++)
+    {
+        b = *bptr++;
+        g = *bptr++;
+        r = *bptr++;
+        *tptr++ = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    }
+}
@@ -0,0 +1,98 @@
+// Startup phases that run side by side
+//
+// Each phase has an event bit. start() runs a phase on its own FreeRTOS task once the
+// phases it depends on have finished; run() does the same on the calling task, for work
+// that has to stay there (anything that draws on the screen). Every phase is timed in
+// the BootTiming report.
+//
+//   bootPipeline.start(BOOT_STORAGE, "storage", loadStorage);
+//   bootPipeline.run(BOOT_DISPLAY, "display", initDisplay);
+//   bootPipeline.run(BOOT_CALIBRATE, "calibrate", touch_calibrate, BOOT_STORAGE | BOOT_DISPLAY);
+
+#pragma once
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include <BootTiming.h>
+
+#define BOOT_PIPELINE_MAX_TASKS 6
+#define BOOT_TASK_STACK 8192
+#define BOOT_TASK_PRIORITY 1
+
+typedef void (*BootStep)();
+
+class BootPipeline
+{
+public:
+    BootPipeline(BootTiming &timing) : timing(timing), events(nullptr), taskCount(0) {}
+
+    void begin()
+    {
+        events = xEventGroupCreate();
+    }
+
+    // Run step on a task of its own once every phase in after has finished
+    void start(EventBits_t phase, const char *name, BootStep step, EventBits_t after = 0)
+    {
+        if (taskCount >= BOOT_PIPELINE_MAX_TASKS)
+        {
+            run(phase, name, step, after); // Out of task slots, run it here instead
+            return;
+        }
+
+        BootTask &task = tasks[taskCount++];
+        task = BootTask{this, step, phase, after, timing.add(name)};
+        xTaskCreate(taskMain, name, BOOT_TASK_STACK, &task, BOOT_TASK_PRIORITY, nullptr);
+    }
+
+    // Run step on this task once every phase in after has finished
+    void run(EventBits_t phase, const char *name, BootStep step, EventBits_t after = 0)
+    {
+        wait(after);
+        uint8_t slot = timing.begin(name);
+        step();
+        timing.end(slot);
+        xEventGroupSetBits(events, phase);
+    }
+
+    // Block until every phase in phases has finished
+    void wait(EventBits_t phases)
+    {
+        if (phases)
+            xEventGroupWaitBits(events, phases, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    bool finished(EventBits_t phases) const
+    {
+        return (xEventGroupGetBits(events) & phases) == phases;
+    }
+
+private:
+    struct BootTask
+    {
+        BootPipeline *pipeline;
+        BootStep step;
+        EventBits_t phase;
+        EventBits_t after;
+        uint8_t timingSlot;
+    };
+
+    static void taskMain(void *arg)
+    {
+        BootTask *task = static_cast<BootTask *>(arg);
+        BootPipeline *self = task->pipeline;
+        self->wait(task->after);
+        self->timing.begin(task->timingSlot);
+        task->step();
+        self->timing.end(task->timingSlot);
+        xEventGroupSetBits(self->events, task->phase);
+        vTaskDelete(nullptr);
+    }
+
+    BootTiming &timing;
+    EventGroupHandle_t events;
+    BootTask tasks[BOOT_PIPELINE_MAX_TASKS];
+    uint8_t taskCount;
+};
@@ -0,0 +1,88 @@
+// Boot phase timing for the keypad
+//
+// Each startup phase records when it started and finished, counted from power-on. Phases
+// may overlap when they run on different tasks; add() must be called from the setup task,
+// begin() and end() from whichever task runs the phase. finish() stamps the first live
+// metadata frame and prints the report.
+
+#pragma once
+
+#include <Arduino.h>
+
+#define BOOT_TIMING_MAX_PHASES 12
+
+struct BootPhase
+{
+    const char *name;
+    uint32_t startUs; // Microseconds since power-on
+    uint32_t endUs;   // 0 while the phase is still running
+};
+
+class BootTiming
+{
+public:
+    BootTiming() : phaseCount(0), finishedUs(0), done(false) {}
+
+    // Reserve a phase. Returns BOOT_TIMING_MAX_PHASES if the table is full.
+    uint8_t add(const char *name)
+    {
+        if (phaseCount >= BOOT_TIMING_MAX_PHASES)
+            return BOOT_TIMING_MAX_PHASES;
+        phases[phaseCount] = BootPhase{name, 0, 0};
+        return phaseCount++;
+    }
+
+    void begin(uint8_t phase)
+    {
+        if (phase < phaseCount) { phases[phase].startUs = micros(); }
+    }
+
+    void end(uint8_t phase)
+    {
+        if (phase < phaseCount) { phases[phase].endUs = micros(); }
+    }
+
+    // Reserve a phase and start it straight away
+    uint8_t begin(const char *name)
+    {
+        uint8_t phase = add(name);
+        begin(phase);
+        return phase;
+    }
+
+    // The first live metadata is on screen. Only the first call does anything.
+    void finish()
+    {
+        if (done)
+            return;
+        finishedUs = micros();
+        done = true;
+        report(Serial);
+    }
+
+    bool finished() const { return done; }
+    uint8_t count() const { return phaseCount; }
+    const BootPhase &phase(uint8_t i) const { return phases[i]; }
+    uint32_t finishedAtUs() const { return finishedUs; }
+
+    void report(Print &out) const
+    {
+        out.println("Boot timing (ms)        start   took");
+        for (uint8_t i = 0; i < phaseCount; i++)
+        {
+            const BootPhase &p = phases[i];
+            if (p.endUs == 0)
+                out.printf("  %-20s %6u running\n", p.name, (unsigned)(p.startUs / 1000));
+            else
+                out.printf("  %-20s %6u %6u\n", p.name, (unsigned)(p.startUs / 1000), (unsigned)((p.endUs - p.startUs) / 1000));
+        }
+        if (done)
+            out.printf("  %-20s %6u\n", "first metadata", (unsigned)(finishedUs / 1000));
+    }
+
+private:
+    BootPhase phases[BOOT_TIMING_MAX_PHASES];
+    uint8_t phaseCount;
+    uint32_t finishedUs;
+    bool done;
+};
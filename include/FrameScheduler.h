@@ -0,0 +1,78 @@
+// Fixed-rate frame scheduler for the keypad UI
+//
+// Rendering runs once per tick. Inside a frame the renderer draws the must-have
+// elements first and asks withinBudget() before starting anything that can wait
+// for the next frame.
+
+#pragma once
+
+#include <stdint.h>
+
+struct FrameStats
+{
+    uint32_t frames;     // Frames rendered
+    uint32_t overBudget; // Frames that ran past the budget
+    uint32_t deferred;   // Draws pushed to a later frame because the budget ran out
+    uint32_t lastUs;     // Duration of the most recent frame
+    uint32_t maxUs;      // Longest frame since the last resetPeak()
+    uint64_t totalUs;    // Sum of all frame durations
+};
+
+class FrameScheduler
+{
+public:
+    FrameScheduler(uint32_t intervalMs, uint32_t budgetUs)
+        : intervalMs(intervalMs), budgetUs(budgetUs), nextFrameMs(0), frameStartUs(0), stats_() {}
+
+    // True once per tick. If we fall behind, skip the missed ticks instead of bursting.
+    bool frameDue(uint32_t nowMs)
+    {
+        if ((int32_t)(nowMs - nextFrameMs) < 0)
+            return false;
+
+        nextFrameMs += intervalMs;
+        if ((int32_t)(nowMs - nextFrameMs) >= 0)
+            nextFrameMs = nowMs + intervalMs;
+        return true;
+    }
+
+    void beginFrame(uint32_t nowUs) { frameStartUs = nowUs; }
+
+    bool withinBudget(uint32_t nowUs) const { return (nowUs - frameStartUs) < budgetUs; }
+
+    // Record a draw that was left for a later frame
+    void defer() { ++stats_.deferred; }
+
+    void endFrame(uint32_t nowUs)
+    {
+        uint32_t elapsed = nowUs - frameStartUs;
+        ++stats_.frames;
+        stats_.lastUs = elapsed;
+        stats_.totalUs += elapsed;
+        if (elapsed > stats_.maxUs) { stats_.maxUs = elapsed; }
+        if (elapsed > budgetUs) { ++stats_.overBudget; }
+    }
+
+    const FrameStats &stats() const { return stats_; }
+
+    uint32_t averageUs() const { return stats_.frames ? (uint32_t)(stats_.totalUs / stats_.frames) : 0; }
+
+    void resetPeak() { stats_.maxUs = 0; }
+
+    // Change the frame rate or budget, for example from stored settings
+    void setTiming(uint32_t newIntervalMs, uint32_t newBudgetUs)
+    {
+        intervalMs = newIntervalMs;
+        budgetUs = newBudgetUs;
+    }
+
+    uint32_t interval() const { return intervalMs; }
+    uint32_t budget() const { return budgetUs; }
+
+private:
+    uint32_t intervalMs;
+    uint32_t budgetUs;
+    uint32_t nextFrameMs;
+    uint32_t frameStartUs;
+    FrameStats stats_;
+};
@@ -0,0 +1,204 @@
+// Streaming gunzip of an HTTP response body, using the inflater in the ESP32 ROM
+//
+// The compressed body is read from the connection a small block at a time and inflated
+// straight into the response String, so the compressed copy is never held in full. The
+// String is reserved up front for the largest body allowed, and is itself the window the
+// ROM inflater looks back into, so no separate 32 KB window is needed. Only the
+// decompressor state is allocated while a response is being inflated.
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include "rom/miniz.h"
+#include "rom/crc.h"
+
+#define GZIP_INPUT_BLOCK 512
+#define GZIP_TIMEOUT 5000 // Longest wait for more of the body, in milliseconds
+
+class GzipInflater
+{
+public:
+    // Inflate a gzip body from in and append it to out. Stops with false on a malformed
+    // body, a body that inflates to more than maxOut bytes or a stalled connection.
+    bool inflate(WiFiClient &in, String &out, size_t maxOut)
+    {
+        tinfl_decompressor *inflater = (tinfl_decompressor *)malloc(sizeof(tinfl_decompressor));
+        bool ok = (inflater != nullptr) && out.reserve(out.length() + maxOut);
+        if (!ok) { Serial.println("Not enough memory to inflate response"); }
+
+        source = &in;
+        inPos = 0;
+        inEnd = 0;
+        ended = false;
+        held = 0;
+        if (ok) { ok = skipHeader() && inflateBody(*inflater, out, maxOut) && checkTrailer(); }
+
+        free(inflater);
+        return ok;
+    }
+
+private:
+    // Fill the input block. Returns false once the body has ended or stalled.
+    bool refill()
+    {
+        uint32_t start = millis();
+        while (!ended)
+        {
+            int available = source->available();
+            if (available > 0)
+            {
+                int read = source->read(input, (available < GZIP_INPUT_BLOCK) ? available : GZIP_INPUT_BLOCK);
+                if (read > 0)
+                {
+                    inPos = 0;
+                    inEnd = read;
+                    return true;
+                }
+            }
+            else if (!source->connected() || (millis() - start > GZIP_TIMEOUT))
+            {
+                ended = true;
+            }
+            else
+            {
+                delay(1);
+            }
+        }
+        return false;
+    }
+
+    int nextByte()
+    {
+        if (held > 0)
+        {
+            held--;
+            int c = heldBits & 0xFF;
+            heldBits >>= 8;
+            return c;
+        }
+        if ((inPos == inEnd) && !refill())
+            return -1;
+        return input[inPos++];
+    }
+
+    bool skipBytes(size_t count)
+    {
+        while (count--)
+        {
+            if (nextByte() < 0)
+                return false;
+        }
+        return true;
+    }
+
+    bool skipString()
+    {
+        int c;
+        while ((c = nextByte()) > 0) {}
+        return c == 0;
+    }
+
+    // The fixed ten bytes, then whichever optional fields the flags say are present
+    bool skipHeader()
+    {
+        if ((nextByte() != 0x1F) || (nextByte() != 0x8B) || (nextByte() != 8))
+        {
+            Serial.println("Response is not gzip");
+            return false;
+        }
+        int flags = nextByte();
+        if ((flags < 0) || !skipBytes(6))
+            return false;
+        if (flags & 0x04) // FEXTRA
+        {
+            int lo = nextByte();
+            int hi = nextByte();
+            if ((lo < 0) || (hi < 0) || !skipBytes(lo | (hi << 8)))
+                return false;
+        }
+        if ((flags & 0x08) && !skipString()) // FNAME
+            return false;
+        if ((flags & 0x10) && !skipString()) // FCOMMENT
+            return false;
+        if ((flags & 0x02) && !skipBytes(2)) // FHCRC
+            return false;
+        return true;
+    }
+
+    // Inflates into the reserved space past the end of out, then appends what landed there.
+    // String has no way to just take a new length, but as the bytes are already in place,
+    // with the space reserved concat() copies them onto themselves without reallocating.
+    bool inflateBody(tinfl_decompressor &inflater, String &out, size_t maxOut)
+    {
+        uint8_t *start = (uint8_t *)out.begin() + out.length();
+        crc = 0;
+        outSize = 0;
+        tinfl_init(&inflater);
+
+        for (;;)
+        {
+            if ((inPos == inEnd) && !ended) { refill(); }
+
+            size_t inBytes = inEnd - inPos;
+            size_t outBytes = maxOut - outSize;
+            tinfl_status status = tinfl_decompress(&inflater, input + inPos, &inBytes, start, start + outSize, &outBytes,
+                                                   TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF | (ended ? 0 : TINFL_FLAG_HAS_MORE_INPUT));
+            inPos += inBytes;
+            crc = crc32_le(crc, start + outSize, outBytes);
+            outSize += outBytes;
+
+            if (status == TINFL_STATUS_DONE)
+            {
+                out.concat((const char *)start, outSize);
+                // The inflater reads ahead into its bit buffer, so the trailer may start there
+                // rather than in input. Bits short of a whole byte are the end of the stream.
+                heldBits = inflater.m_bit_buf >> (inflater.m_num_bits & 7);
+                held = inflater.m_num_bits / 8;
+                return true;
+            }
+            if (status == TINFL_STATUS_HAS_MORE_OUTPUT)
+            {
+                Serial.println("Inflated response too large");
+                return false;
+            }
+            if (status < TINFL_STATUS_DONE)
+            {
+                Serial.printf("Inflating response failed: %d\n", (int)status);
+                return false;
+            }
+        }
+    }
+
+    // CRC32 and length of the inflated body, little endian
+    bool checkTrailer()
+    {
+        uint32_t fields[2] = {0, 0};
+        for (uint8_t f = 0; f < 2; f++)
+        {
+            for (uint8_t b = 0; b < 4; b++)
+            {
+                int c = nextByte();
+                if (c < 0)
+                    return false;
+                fields[f] |= (uint32_t)c << (8 * b);
+            }
+        }
+        if ((fields[0] != crc) || (fields[1] != (uint32_t)outSize))
+        {
+            Serial.println("Inflated response failed its CRC check");
+            return false;
+        }
+        return true;
+    }
+
+    WiFiClient *source;
+    uint8_t input[GZIP_INPUT_BLOCK];
+    size_t inPos;
+    size_t inEnd;
+    bool ended;
+    uint64_t heldBits; // Bytes after the stream that the inflater had already read
+    uint8_t held;
+    uint32_t crc;
+    size_t outSize;
+};
@@ -0,0 +1,137 @@
+// Heap health over time for the keypad
+//
+// sample() is given the free heap and the largest block it can allocate whenever due()
+// says a sampling interval has passed, and the last HEAP_SAMPLES samples are kept.
+// Fragmentation is how much of the free heap can't be had in one piece: 1 - largest
+// block / free. Once the window is full, the trend of each is fitted by least squares,
+// and a warning is printed if either is below its floor, or falling fast enough to reach
+// it within the horizon. Each warning is printed once, unless it gets worse or clears.
+
+#pragma once
+
+#include <Arduino.h>
+
+#define HEAP_SAMPLES 60
+
+struct HeapSample
+{
+    uint32_t atMs;
+    uint32_t freeBytes;
+    uint32_t largestBytes;
+};
+
+struct HeapTrend
+{
+    bool valid;           // Enough samples to fit a trend
+    float bytesPerHour;   // Negative while shrinking
+    float hoursToFloor;   // How long until the floor at this rate, or 0 if it isn't falling
+};
+
+class HeapMonitor
+{
+public:
+    HeapMonitor(uint32_t sampleIntervalMs, uint32_t freeFloorBytes, uint32_t blockFloorBytes, float horizonHours)
+        : intervalMs(sampleIntervalMs), freeFloor(freeFloorBytes), blockFloor(blockFloorBytes), horizon(horizonHours),
+          count(0), next(0), lastSampleMs(0), leakWarned(0), fragmentWarned(0) {}
+
+    // Finding the largest free block walks the heap, so only read it when a sample is due
+    bool due(uint32_t nowMs) const { return (count == 0) || (nowMs - lastSampleMs >= intervalMs); }
+
+    // Keep a sample and print any warning it brings
+    void sample(uint32_t nowMs, uint32_t freeBytes, uint32_t largestBytes, Print &out)
+    {
+        lastSampleMs = nowMs;
+        samples[next] = HeapSample{nowMs, freeBytes, largestBytes};
+        next = (next + 1) % HEAP_SAMPLES;
+        if (count < HEAP_SAMPLES) { ++count; }
+
+        check(out, leakWarned, "free heap", freeBytes, freeFloor, trend(false));
+        check(out, fragmentWarned, "largest free block", largestBytes, blockFloor, trend(true));
+    }
+
+    const HeapSample *latest() const { return count ? &samples[(next + HEAP_SAMPLES - 1) % HEAP_SAMPLES] : nullptr; }
+
+    float fragmentation() const
+    {
+        const HeapSample *sample = latest();
+        if ((sample == nullptr) || (sample->largestBytes >= sample->freeBytes))
+            return 0;
+        return 1.0f - (float)sample->largestBytes / sample->freeBytes;
+    }
+
+    // Trend of the free heap, or with largest set of the largest free block
+    HeapTrend trend(bool largest) const
+    {
+        HeapTrend result = {false, 0, 0};
+        if (count < HEAP_SAMPLES)
+            return result;
+
+        // Least squares over hours since the oldest sample, which keeps the sums small
+        const HeapSample &oldest = samples[next];
+        double n = count, sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            const HeapSample &s = samples[i];
+            double x = (s.atMs - oldest.atMs) / 3600000.0;
+            double y = largest ? s.largestBytes : s.freeBytes;
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+        }
+        double spread = n * sumXX - sumX * sumX;
+        if (spread <= 0)
+            return result;
+
+        result.valid = true;
+        result.bytesPerHour = (float)((n * sumXY - sumX * sumY) / spread);
+        const HeapSample *now = latest();
+        uint32_t current = largest ? now->largestBytes : now->freeBytes;
+        uint32_t floor = largest ? blockFloor : freeFloor;
+        if ((result.bytesPerHour < 0) && (current > floor)) { result.hoursToFloor = (current - floor) / -result.bytesPerHour; }
+        return result;
+    }
+
+    void report(Print &out) const
+    {
+        const HeapSample *sample = latest();
+        if (sample == nullptr)
+            return;
+        out.printf("Heap: %u free, %u largest block, %.0f%% fragmented", (unsigned)sample->freeBytes,
+                   (unsigned)sample->largestBytes, fragmentation() * 100);
+        HeapTrend freeTrend = trend(false);
+        HeapTrend blockTrend = trend(true);
+        if (freeTrend.valid) { out.printf(", free %+.0f bytes/h, largest block %+.0f bytes/h", freeTrend.bytesPerHour, blockTrend.bytesPerHour); }
+        out.println();
+    }
+
+private:
+    // warned is what was last warned of: 0 nothing, 1 falling, 2 below the floor
+    void check(Print &out, uint8_t &warned, const char *what, uint32_t current, uint32_t floor, const HeapTrend &t)
+    {
+        bool low = current < floor;
+        bool falling = t.valid && (t.hoursToFloor > 0) && (t.hoursToFloor < horizon);
+        uint8_t level = low ? 2 : falling ? 1 : 0;
+        bool worse = level > warned;
+        warned = level;
+        if (!worse)
+            return;
+        if (low) { out.printf("Warning: %s is down to %u bytes, below %u\n", what, (unsigned)current, (unsigned)floor); }
+        else
+        {
+            out.printf("Warning: %s is falling by %.0f bytes/h, and will be below %u bytes in %.1f hours\n", what,
+                       -t.bytesPerHour, (unsigned)floor, t.hoursToFloor);
+        }
+    }
+
+    uint32_t intervalMs;
+    uint32_t freeFloor;
+    uint32_t blockFloor;
+    float horizon;
+    HeapSample samples[HEAP_SAMPLES];
+    uint8_t count;
+    uint8_t next; // Where the next sample goes; the oldest once the window is full
+    uint32_t lastSampleMs;
+    uint8_t leakWarned;
+    uint8_t fragmentWarned;
+};
@@ -0,0 +1,129 @@
+// Allocation profiling for the keypad
+//
+// Built with HEAP_PROFILE set, and linked with the allocator wrapped (pio run -e
+// esp32dev_heap), every allocation is counted against the subsystem the allocating task
+// is working for. HEAP_SCOPE(subsystem) sets that until its scope closes, and scopes
+// nest. Anything outside a scope counts as HEAP_OTHER. The counters live in
+// src/HeapProfile.cpp, and the benchmarks in bench/ read their totals too. Without
+// HEAP_PROFILE HEAP_SCOPE compiles to nothing.
+//
+// Subsystems are counted rather than call sites because the return address of nearly
+// every allocation is in String, ArduinoJson or libstdc++, which says nothing about who
+// asked for the memory.
+//
+// The live and peak bytes in HeapTotals are only reported on the host. On the ESP32, IDF
+// components allocate some blocks with heap_caps_malloc(), which bypasses the wrapped
+// malloc, but release them through the wrapped free, so live would be taken down by
+// memory it never counted. The per-subsystem counts only count allocations and are
+// reported on both.
+
+#pragma once
+
+#ifndef HEAP_PROFILE
+#define HEAP_PROFILE 0
+#endif
+
+#include <stdint.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#define HEAP_PROFILE_LIVE 0
+#else
+#define HEAP_PROFILE_LIVE 1
+#endif
+
+enum HeapSubsystem : uint8_t
+{
+    HEAP_OTHER, // Anything not in a HEAP_SCOPE
+    HEAP_API,   // Requests to AmpliPi and their responses
+    HEAP_JSON,  // Parsing responses into the state
+    HEAP_ART,   // Album art downloads
+    HEAP_DRAW,  // Rendering frames
+    HEAP_FLOWS, // The refresh and interaction flows
+    HEAP_WEB,   // The metrics server
+    HEAP_SUBSYSTEMS
+};
+
+inline const char *heapSubsystemName(HeapSubsystem subsystem)
+{
+    static const char *const names[HEAP_SUBSYSTEMS] = {"other", "api", "json", "art", "draw", "flows", "web"};
+    return (subsystem < HEAP_SUBSYSTEMS) ? names[subsystem] : "?";
+}
+
+#if HEAP_PROFILE
+
+#include <Arduino.h>
+
+struct HeapSubsystemStats
+{
+    uint32_t allocs;
+    uint64_t bytes;
+    uint32_t failures; // Allocations the heap couldn't satisfy
+};
+
+struct HeapTotals
+{
+    uint32_t allocs;
+    uint64_t bytes; // Allocated in all, counting blocks since freed
+    uint32_t frees;
+    int64_t live;
+    int64_t peak;
+};
+
+extern thread_local HeapSubsystem heapSubsystem;
+
+// Counters kept by the wrapped allocator
+HeapSubsystemStats heapSubsystemStats(HeapSubsystem subsystem);
+HeapTotals heapTotals();
+void heapResetPeak(); // Start the peak again from what is live now
+
+class HeapScope
+{
+public:
+    explicit HeapScope(HeapSubsystem subsystem) : saved(heapSubsystem) { heapSubsystem = subsystem; }
+    ~HeapScope() { heapSubsystem = saved; }
+
+private:
+    HeapSubsystem saved;
+};
+
+// What each subsystem allocated since the last report, and what is live now
+class HeapProfileReport
+{
+public:
+    void print(Print &out)
+    {
+        HeapTotals totals = heapTotals();
+#if HEAP_PROFILE_LIVE
+        out.printf("Heap profile: %lld live, %lld peak, %u allocs and %u frees since boot\n", (long long)totals.live,
+                   (long long)totals.peak, (unsigned)totals.allocs, (unsigned)totals.frees);
+#else
+        out.printf("Heap profile: %u allocs and %u frees since boot\n", (unsigned)totals.allocs, (unsigned)totals.frees);
+#endif
+        for (uint8_t s = 0; s < HEAP_SUBSYSTEMS; s++)
+        {
+            HeapSubsystemStats now = heapSubsystemStats((HeapSubsystem)s);
+            HeapSubsystemStats &before = last[s];
+            if (now.allocs != before.allocs)
+            {
+                out.printf("  %-6s %6u allocs, %8llu bytes", heapSubsystemName((HeapSubsystem)s),
+                           (unsigned)(now.allocs - before.allocs), (unsigned long long)(now.bytes - before.bytes));
+                if (now.failures != before.failures) { out.printf(", %u FAILED", (unsigned)(now.failures - before.failures)); }
+                out.println();
+            }
+            before = now;
+        }
+    }
+
+private:
+    HeapSubsystemStats last[HEAP_SUBSYSTEMS] = {};
+};
+
+#define HEAP_JOIN2(a, b) a##b
+#define HEAP_JOIN(a, b) HEAP_JOIN2(a, b)
+#define HEAP_SCOPE(subsystem) HeapScope HEAP_JOIN(heapScope, __LINE__)(subsystem)
+
+#else
+
+#define HEAP_SCOPE(subsystem)
+
+#endif
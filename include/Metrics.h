@@ -0,0 +1,185 @@
+// Prometheus text format for the keypad's /metrics endpoint
+//
+// MetricsWriter prints metrics in the Prometheus exposition format (version 0.0.4), so a
+// central Prometheus can scrape every keypad. Counters only ever grow until the keypad
+// restarts; gauges are the value at the time of the scrape. LoopStats times loop()
+// passes for it, the same way FrameScheduler times frames. Builds with HEAP_PROFILE add
+// the allocation counters from include/HeapProfile.h.
+
+#pragma once
+
+#include <Arduino.h>
+#include <NetTiming.h>
+#include <BootTiming.h>
+#include <HeapProfile.h>
+
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4"
+
+struct LoopStats
+{
+    uint32_t iterations;
+    uint64_t totalUs;
+    uint32_t maxUs; // Longest pass since the last resetPeak()
+
+    void add(uint32_t us)
+    {
+        ++iterations;
+        totalUs += us;
+        if (us > maxUs) { maxUs = us; }
+    }
+
+    void resetPeak() { maxUs = 0; }
+};
+
+class MetricsWriter
+{
+public:
+    explicit MetricsWriter(Print &output) : out(output) {}
+
+    void gauge(const char *name, const char *help, double value)
+    {
+        describe(name, "gauge", help);
+        sample(name, nullptr, value);
+    }
+
+    void counter(const char *name, const char *help, double value)
+    {
+        describe(name, "counter", help);
+        sample(name, nullptr, value);
+    }
+
+    void describe(const char *name, const char *type, const char *help)
+    {
+        out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+
+    // labels is the inside of the braces, such as endpoint="zones", or null for none
+    void sample(const char *name, const char *labels, double value)
+    {
+        if (labels) { out.printf("%s{%s} %.9g\n", name, labels, value); }
+        else { out.printf("%s %.9g\n", name, value); }
+    }
+
+    // Requests and failures per endpoint, and a histogram per endpoint and phase for the
+    // phases that have been timed
+    void network(const char *prefix, const NetTimings &timings)
+    {
+        char name[64];
+        char labels[96];
+
+        snprintf(name, sizeof(name), "%s_requests_total", prefix);
+        describe(name, "counter", "Requests to AmpliPi by endpoint");
+        for (uint8_t e = 0; e < NET_ENDPOINTS; e++)
+        {
+            snprintf(labels, sizeof(labels), "endpoint=\"%s\"", NetTimings::endpointName((NetEndpoint)e));
+            sample(name, labels, timings.stats((NetEndpoint)e).requests.load());
+        }
+
+        snprintf(name, sizeof(name), "%s_failures_total", prefix);
+        describe(name, "counter", "Requests to AmpliPi that got no response or an error status");
+        for (uint8_t e = 0; e < NET_ENDPOINTS; e++)
+        {
+            snprintf(labels, sizeof(labels), "endpoint=\"%s\"", NetTimings::endpointName((NetEndpoint)e));
+            sample(name, labels, timings.stats((NetEndpoint)e).failures.load());
+        }
+
+        snprintf(name, sizeof(name), "%s_phase_seconds", prefix);
+        describe(name, "histogram", "Time in each phase of a request: resolve, connect, ttfb and body");
+        for (uint8_t e = 0; e < NET_ENDPOINTS; e++)
+        {
+            for (uint8_t p = 0; p < NET_PHASES; p++)
+            {
+                const NetHistogram &histogram = timings.stats((NetEndpoint)e).phases[p];
+                uint32_t count = histogram.count.load();
+                if (count == 0)
+                    continue;
+                int base = snprintf(labels, sizeof(labels), "endpoint=\"%s\",phase=\"%s\"",
+                                    NetTimings::endpointName((NetEndpoint)e), NetTimings::phaseName((NetPhase)p));
+
+                snprintf(name, sizeof(name), "%s_phase_seconds_bucket", prefix);
+                uint32_t cumulative = 0;
+                for (uint8_t b = 0; b < NET_BUCKETS - 1; b++)
+                {
+                    cumulative += histogram.buckets[b].load();
+                    snprintf(labels + base, sizeof(labels) - base, ",le=\"%g\"", netBucketMs[b] / 1000.0);
+                    sample(name, labels, cumulative);
+                }
+                snprintf(labels + base, sizeof(labels) - base, ",le=\"+Inf\"");
+                sample(name, labels, count);
+                labels[base] = '\0';
+
+                snprintf(name, sizeof(name), "%s_phase_seconds_sum", prefix);
+                sample(name, labels, histogram.totalUs.load() / 1e6);
+                snprintf(name, sizeof(name), "%s_phase_seconds_count", prefix);
+                sample(name, labels, count);
+            }
+        }
+    }
+
+    // When each boot phase started and how long it took, and when the first live metadata
+    // was on screen. Phases still running have no duration yet.
+    void boot(const char *prefix, const BootTiming &timing)
+    {
+        char name[64];
+        char labels[64];
+
+        snprintf(name, sizeof(name), "%s_phase_start_ms", prefix);
+        describe(name, "gauge", "When each boot phase started, in milliseconds since power-on");
+        for (uint8_t i = 0; i < timing.count(); i++)
+        {
+            snprintf(labels, sizeof(labels), "phase=\"%s\"", timing.phase(i).name);
+            sample(name, labels, timing.phase(i).startUs / 1000.0);
+        }
+
+        snprintf(name, sizeof(name), "%s_phase_ms", prefix);
+        describe(name, "gauge", "How long each finished boot phase took, in milliseconds");
+        for (uint8_t i = 0; i < timing.count(); i++)
+        {
+            const BootPhase &phase = timing.phase(i);
+            if (phase.endUs == 0)
+                continue;
+            snprintf(labels, sizeof(labels), "phase=\"%s\"", phase.name);
+            sample(name, labels, (phase.endUs - phase.startUs) / 1000.0);
+        }
+
+        if (timing.finished())
+        {
+            snprintf(name, sizeof(name), "%s_first_metadata_ms", prefix);
+            gauge(name, "When the first live metadata was on screen, in milliseconds since power-on", timing.finishedAtUs() / 1000.0);
+        }
+    }
+
+#if HEAP_PROFILE
+    // Allocations, bytes and failures per subsystem, and on the host the bytes live now and at the peak
+    void heapProfile(const char *prefix)
+    {
+        char name[64];
+        char labels[32];
+        static const char *const counters[] = {"allocations_total", "allocated_bytes_total", "failed_allocations_total"};
+        static const char *const helps[] = {"Allocations by subsystem", "Bytes allocated by subsystem",
+                                            "Allocations the heap could not satisfy, by subsystem"};
+        for (uint8_t c = 0; c < 3; c++)
+        {
+            snprintf(name, sizeof(name), "%s_%s", prefix, counters[c]);
+            describe(name, "counter", helps[c]);
+            for (uint8_t s = 0; s < HEAP_SUBSYSTEMS; s++)
+            {
+                HeapSubsystemStats stats = heapSubsystemStats((HeapSubsystem)s);
+                snprintf(labels, sizeof(labels), "subsystem=\"%s\"", heapSubsystemName((HeapSubsystem)s));
+                sample(name, labels, (c == 0) ? stats.allocs : (c == 1) ? (double)stats.bytes : stats.failures);
+            }
+        }
+
+#if HEAP_PROFILE_LIVE
+        HeapTotals totals = heapTotals();
+        snprintf(name, sizeof(name), "%s_live_bytes", prefix);
+        gauge(name, "Bytes allocated and not yet freed", totals.live);
+        snprintf(name, sizeof(name), "%s_peak_live_bytes", prefix);
+        gauge(name, "Most bytes allocated at once since the keypad started", totals.peak);
+#endif
+    }
+#endif
+
+private:
+    Print &out;
+};
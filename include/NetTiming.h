@@ -0,0 +1,165 @@
+// Network latency histograms for the keypad's requests to AmpliPi
+//
+// Each request is split into the time to resolve AmpliPi's name, to connect, from
+// sending the request to the first byte of the response (TTFB) and to read the body.
+// Each phase goes into a fixed-bucket histogram for the kind of endpoint it was for.
+// Requests made with AsyncHttpGet have no resolve phase of their own: AsyncTCP looks the
+// name up as part of connecting, so it counts as connect time. add() and request()
+// may be called from any task.
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+enum NetEndpoint : uint8_t
+{
+    NET_ZONES,
+    NET_SOURCES,
+    NET_STREAMS,
+    NET_IMAGE,  // Album art
+    NET_STATUS, // Everything else, such as the whole /api/ status
+    NET_ENDPOINTS
+};
+
+enum NetPhase : uint8_t
+{
+    NET_RESOLVE,
+    NET_CONNECT,
+    NET_TTFB,
+    NET_BODY,
+    NET_PHASES
+};
+
+// Upper bounds of the buckets in milliseconds; the last bucket takes everything slower
+#define NET_BUCKETS 13
+static const uint16_t netBucketMs[NET_BUCKETS - 1] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+
+// The endpoint class of an API resource, such as "zones/1" or "streams/image/1000"
+inline NetEndpoint netEndpoint(const String &resource)
+{
+    if (resource.startsWith("zones")) { return NET_ZONES; }
+    if (resource.startsWith("sources")) { return NET_SOURCES; }
+    if (resource.startsWith("streams/image")) { return NET_IMAGE; }
+    if (resource.startsWith("streams")) { return NET_STREAMS; }
+    return NET_STATUS;
+}
+
+struct NetHistogram
+{
+    std::atomic<uint32_t> buckets[NET_BUCKETS];
+    std::atomic<uint32_t> count;
+    std::atomic<uint64_t> totalUs;
+
+    void add(uint32_t us)
+    {
+        uint8_t bucket = 0;
+        while ((bucket < NET_BUCKETS - 1) && (us > netBucketMs[bucket] * 1000UL)) { ++bucket; }
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        totalUs.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    // Upper bound in milliseconds of the bucket holding the given fraction of samples,
+    // or 0 with no samples. The overflow bucket reports as twice the last bound.
+    uint32_t percentileMs(float fraction) const
+    {
+        uint32_t total = count.load(std::memory_order_relaxed);
+        if (total == 0)
+            return 0;
+        uint32_t seen = 0;
+        for (uint8_t bucket = 0; bucket < NET_BUCKETS - 1; bucket++)
+        {
+            seen += buckets[bucket].load(std::memory_order_relaxed);
+            if (seen >= fraction * total)
+                return netBucketMs[bucket];
+        }
+        return netBucketMs[NET_BUCKETS - 2] * 2;
+    }
+};
+
+struct NetEndpointStats
+{
+    std::atomic<uint32_t> requests;
+    std::atomic<uint32_t> failures; // No response, or not a 2xx or 304
+    NetHistogram phases[NET_PHASES];
+};
+
+class NetTimings
+{
+public:
+    NetTimings() : endpoints() {}
+
+    static const char *endpointName(NetEndpoint endpoint)
+    {
+        static const char *const names[NET_ENDPOINTS] = {"zones", "sources", "streams", "image", "status"};
+        return (endpoint < NET_ENDPOINTS) ? names[endpoint] : "?";
+    }
+
+    static const char *phaseName(NetPhase phase)
+    {
+        static const char *const names[NET_PHASES] = {"resolve", "connect", "ttfb", "body"};
+        return (phase < NET_PHASES) ? names[phase] : "?";
+    }
+
+    void add(NetEndpoint endpoint, NetPhase phase, uint32_t us) { endpoints[endpoint].phases[phase].add(us); }
+
+    void request(NetEndpoint endpoint, bool ok)
+    {
+        endpoints[endpoint].requests.fetch_add(1, std::memory_order_relaxed);
+        if (!ok) { endpoints[endpoint].failures.fetch_add(1, std::memory_order_relaxed); }
+    }
+
+    const NetEndpointStats &stats(NetEndpoint endpoint) const { return endpoints[endpoint]; }
+
+    // One line per endpoint that has seen requests, with the median and 90th percentile
+    // of each phase
+    void report(Print &out) const
+    {
+        for (uint8_t e = 0; e < NET_ENDPOINTS; e++)
+        {
+            const NetEndpointStats &stats = endpoints[e];
+            if (stats.requests.load() == 0)
+                continue;
+            out.printf("Net %s: %u requests, %u failed, p50/p90 ms:", endpointName((NetEndpoint)e),
+                       (unsigned)stats.requests.load(), (unsigned)stats.failures.load());
+            for (uint8_t p = 0; p < NET_PHASES; p++)
+            {
+                const NetHistogram &phase = stats.phases[p];
+                if (phase.count.load() == 0)
+                    continue;
+                out.printf(" %s %u/%u", phaseName((NetPhase)p), (unsigned)phase.percentileMs(0.5f), (unsigned)phase.percentileMs(0.9f));
+            }
+            out.println();
+        }
+    }
+
+private:
+    NetEndpointStats endpoints[NET_ENDPOINTS];
+};
+
+// Times the phases of one request in turn: each mark() ends the phase given, which is
+// taken to have started at the previous mark()
+class NetRequestTimer
+{
+public:
+    NetRequestTimer(NetTimings &netTimings, NetEndpoint requestEndpoint)
+        : timings(netTimings), endpoint(requestEndpoint), lastUs(micros()) {}
+
+    void mark(NetPhase phase)
+    {
+        uint32_t now = micros();
+        timings.add(endpoint, phase, now - lastUs);
+        lastUs = now;
+    }
+
+    // Skip over time that belongs to no phase, such as opening a file
+    void restart() { lastUs = micros(); }
+
+    void done(bool ok) { timings.request(endpoint, ok); }
+
+private:
+    NetTimings &timings;
+    NetEndpoint endpoint;
+    uint32_t lastUs;
+};
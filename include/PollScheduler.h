@@ -0,0 +1,165 @@
+// Adaptive polling of AmpliPi resources
+//
+// Each resource has its own interval, picked by what the keypad is doing: the active
+// interval for a while after someone touches the screen (or, for the stream, after the
+// track changes), the playing interval while the stream is playing, and the idle interval
+// otherwise. Every interval is jittered by a per-device random amount so a houseful of
+// keypads drifts apart instead of polling in lockstep.
+//
+// No Arduino dependencies, so the same scheduler can drive a simulated fleet on a PC.
+
+#pragma once
+
+#include <stdint.h>
+
+#define POLL_ACTIVE_WINDOW 30000 // How long polling stays fast after a touch (in milliseconds)
+#define POLL_TRACK_WINDOW 10000  // How long stream polling stays fast after a track change (in milliseconds)
+#define POLL_JITTER_PERCENT 10   // Each interval is randomly lengthened or shortened by up to this much
+
+enum PollResource : uint8_t
+{
+    POLL_ZONES,  // Mute and volume of the configured zones
+    POLL_SOURCE, // Which stream the source is playing
+    POLL_STREAM, // Song, artist, album art and play status
+    POLL_RESOURCES
+};
+
+struct PollIntervals
+{
+    uint32_t activeMs;  // Shortly after an interaction
+    uint32_t playingMs; // While the stream is playing
+    uint32_t idleMs;    // Paused, stopped or local input
+};
+
+struct PollCounters
+{
+    uint32_t requests; // Polls made
+    uint32_t changes;  // Polls that found something new
+};
+
+class PollScheduler
+{
+public:
+    PollScheduler() : rng(1), playing(false)
+    {
+        for (uint8_t r = 0; r < POLL_RESOURCES; r++)
+        {
+            intervals[r] = PollIntervals{2000, 5000, 60000};
+            nextDue[r] = 0;
+            activeUntil[r] = 0;
+            counters[r] = PollCounters{0, 0};
+        }
+    }
+
+    void configure(PollResource r, const PollIntervals &i) { intervals[r] = i; }
+
+    // Seed the jitter with something unique to this device, such as its MAC address
+    void seed(uint32_t deviceSeed) { rng = deviceSeed ? deviceSeed : 1; }
+
+    bool due(PollResource r, uint32_t nowMs) const { return (int32_t)(nowMs - nextDue[r]) >= 0; }
+
+    bool anyDue(uint32_t nowMs) const
+    {
+        for (uint8_t r = 0; r < POLL_RESOURCES; r++)
+        {
+            if (due((PollResource)r, nowMs))
+                return true;
+        }
+        return false;
+    }
+
+    // Make every resource due straight away, for example on returning to the metadata screen
+    void pollNow(uint32_t nowMs)
+    {
+        for (uint8_t r = 0; r < POLL_RESOURCES; r++)
+        {
+            nextDue[r] = nowMs;
+        }
+    }
+
+    // A poll of r completed. changed is true if it found something new.
+    void polled(PollResource r, uint32_t nowMs, bool changed)
+    {
+        ++counters[r].requests;
+        if (changed) { ++counters[r].changes; }
+        reschedule(r, nowMs);
+    }
+
+    // Schedule the next poll of r without counting a request, when there was nothing to fetch
+    void reschedule(PollResource r, uint32_t nowMs)
+    {
+        nextDue[r] = nowMs + jitter(interval(r, nowMs));
+    }
+
+    // Someone used the keypad: poll everything quickly for a while
+    void interaction(uint32_t nowMs)
+    {
+        for (uint8_t r = 0; r < POLL_RESOURCES; r++)
+        {
+            boost((PollResource)r, nowMs, POLL_ACTIVE_WINDOW);
+        }
+    }
+
+    // The stream moved to another track or another stream: poll it quickly for a while
+    void trackChanged(uint32_t nowMs)
+    {
+        boost(POLL_STREAM, nowMs, POLL_TRACK_WINDOW);
+        nextDue[POLL_STREAM] = nowMs;
+    }
+
+    void setPlaying(bool isPlaying) { playing = isPlaying; }
+    bool isPlaying() const { return playing; }
+
+    // Interval r is currently polled at, before jitter
+    uint32_t interval(PollResource r, uint32_t nowMs) const
+    {
+        if ((int32_t)(activeUntil[r] - nowMs) > 0)
+            return intervals[r].activeMs;
+        return playing ? intervals[r].playingMs : intervals[r].idleMs;
+    }
+
+    const PollCounters &stats(PollResource r) const { return counters[r]; }
+
+    static const char *name(PollResource r)
+    {
+        switch (r)
+        {
+        case POLL_ZONES: return "zones";
+        case POLL_SOURCE: return "source";
+        case POLL_STREAM: return "stream";
+        default: return "?";
+        }
+    }
+
+private:
+    void boost(PollResource r, uint32_t nowMs, uint32_t windowMs)
+    {
+        if ((int32_t)(nowMs + windowMs - activeUntil[r]) > 0)
+            activeUntil[r] = nowMs + windowMs;
+
+        // Don't leave a slow poll scheduled far in the future
+        uint32_t soon = nowMs + intervals[r].activeMs;
+        if ((int32_t)(nextDue[r] - soon) > 0)
+            nextDue[r] = soon;
+    }
+
+    uint32_t jitter(uint32_t intervalMs)
+    {
+        uint32_t spread = intervalMs * POLL_JITTER_PERCENT / 100;
+        if (spread == 0)
+            return intervalMs;
+
+        // xorshift32
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return intervalMs - spread + (rng % (2 * spread + 1));
+    }
+
+    PollIntervals intervals[POLL_RESOURCES];
+    uint32_t nextDue[POLL_RESOURCES];
+    uint32_t activeUntil[POLL_RESOURCES];
+    PollCounters counters[POLL_RESOURCES];
+    uint32_t rng;
+    bool playing;
+};
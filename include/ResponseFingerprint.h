@@ -0,0 +1,86 @@
+// Fingerprints of polled API responses, so an unchanged response is never parsed
+//
+// Each polled resource remembers the last response it handed on for parsing: the ETag
+// the server sent with it, if any, and an FNV-1a hash of the request path and body. A
+// request sent with If-None-Match comes back 304 when nothing has changed. A server
+// without ETags still sends the body, but hashing it costs far less than deserializing it
+// and comparing every field. Either way an unchanged poll stops before the JSON parser.
+//
+// A fingerprint must be forgotten whenever the keypad's own copy of the resource moves
+// away from the server's, such as an optimistic volume change, so the next poll is parsed.
+// A 304 to a request sent before the forget() then has nothing to stand for, so it counts
+// as a failed poll and the next one asks for the whole body.
+
+#pragma once
+
+#include <Arduino.h>
+
+enum ResponseChange : uint8_t
+{
+    RESPONSE_FAILED,
+    RESPONSE_UNCHANGED, // Same as the last response, nothing to parse
+    RESPONSE_NEW,
+};
+
+class ResponseFingerprint
+{
+public:
+    ResponseFingerprint() : hash(0), pathHash(0) {}
+
+    // ETag to send as If-None-Match when polling path, or nullptr if there is none
+    const char *ifNoneMatch(const String &path) const
+    {
+        if ((hash == 0) || (etag.length() == 0) || (pathHash != fnv(path)))
+            return nullptr;
+        return etag.c_str();
+    }
+
+    // Compare a polled response with the last one seen for path. notModified is a 304,
+    // which is only unchanged if there is still a response for it to stand for. A new
+    // body becomes the response to compare against next time, along with its ETag.
+    ResponseChange compare(const String &path, const String &body, bool notModified, const String &newEtag)
+    {
+        if (notModified)
+        {
+            if ((hash != 0) && (fnv(path) == pathHash))
+                return RESPONSE_UNCHANGED;
+            forget();
+            return RESPONSE_FAILED;
+        }
+        return same(path, body, newEtag) ? RESPONSE_UNCHANGED : RESPONSE_NEW;
+    }
+
+    // True if body is the response last seen for path. Otherwise it becomes the response
+    // to compare against next time.
+    bool same(const String &path, const String &body, const String &newEtag = String())
+    {
+        uint32_t newPathHash = fnv(path);
+        uint32_t newHash = fnv(body, newPathHash);
+        if (newHash == 0) { newHash = 1; } // 0 means nothing seen yet
+        if ((newHash == hash) && (newPathHash == pathHash))
+            return true;
+
+        hash = newHash;
+        pathHash = newPathHash;
+        etag = newEtag;
+        return false;
+    }
+
+    void forget()
+    {
+        hash = 0;
+        etag = "";
+    }
+
+private:
+    static uint32_t fnv(const String &data, uint32_t hash = 2166136261u)
+    {
+        const uint8_t *bytes = (const uint8_t *)data.c_str();
+        for (size_t i = 0; i < data.length(); i++) { hash = (hash ^ bytes[i]) * 16777619u; } // Bodies may be MessagePack, so no strlen
+        return hash;
+    }
+
+    uint32_t hash;     // Of the path and body last handed on, 0 for none
+    uint32_t pathHash; // Of the path alone
+    String etag;
+};
@@ -0,0 +1,107 @@
+// Keypad settings, kept as one binary record in NVS
+//
+// Everything the keypad needs to remember lives in a single KeypadSettings record: the
+// AmpliPi host, zones and source, the touch calibration, WiFi credentials and tuning
+// values. It is read with one NVS fetch at boot and written as one blob, which NVS
+// replaces atomically, so a power cut mid-save leaves the previous record in place. A
+// magic number, version and CRC32 guard against reading a record from another firmware.
+
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "rom/crc.h"
+
+#define SETTINGS_MAGIC 0x4B505354 // "KPST"
+#define SETTINGS_VERSION 1
+#define SETTINGS_NVS_NAMESPACE "settings"
+
+#define SETTINGS_HOST_LEN 64
+#define SETTINGS_ZONE_LEN 6
+#define SETTINGS_SSID_LEN 32
+#define SETTINGS_PASS_LEN 64
+#define SETTINGS_WIFI_CREDENTIALS 2
+
+struct SettingsWiFiCredential
+{
+    char ssid[SETTINGS_SSID_LEN];
+    char pass[SETTINGS_PASS_LEN];
+};
+
+struct KeypadSettings
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size; // sizeof(KeypadSettings) when written
+
+    // AmpliPi
+    char amplipiHost[SETTINGS_HOST_LEN];
+    char amplipiZone1[SETTINGS_ZONE_LEN];
+    char amplipiZone2[SETTINGS_ZONE_LEN];
+    char amplipiSource[SETTINGS_ZONE_LEN];
+
+    // Touch screen
+    uint16_t touchCal[5];
+    bool touchCalValid;
+
+    // WiFi networks added through the config portal
+    SettingsWiFiCredential wifi[SETTINGS_WIFI_CREDENTIALS];
+
+    // Tuning
+    uint32_t refreshInterval; // Stream poll while playing, in milliseconds
+    uint32_t frameInterval;   // UI frame interval, in milliseconds
+    uint32_t frameBudget;     // Drawing time per frame, in microseconds
+    uint32_t touchDebounce;   // Minimum time between touches, in milliseconds
+
+    uint32_t crc; // CRC32 of everything above
+};
+
+class SettingsStore
+{
+public:
+    // Read the record. Returns false if there is none or it doesn't check out.
+    bool load(KeypadSettings &settings)
+    {
+        Preferences prefs;
+        if (!prefs.begin(SETTINGS_NVS_NAMESPACE, true))
+            return false;
+        size_t read = prefs.getBytes("record", &settings, sizeof(settings));
+        prefs.end();
+
+        if (read != sizeof(settings))
+            return false;
+        if ((settings.magic != SETTINGS_MAGIC) || (settings.version != SETTINGS_VERSION) || (settings.size != sizeof(settings)))
+        {
+            Serial.println("Stored settings are from another version");
+            return false;
+        }
+        if (settings.crc != checksum(settings))
+        {
+            Serial.println("Stored settings failed their CRC check");
+            return false;
+        }
+        return true;
+    }
+
+    bool save(KeypadSettings &settings)
+    {
+        settings.magic = SETTINGS_MAGIC;
+        settings.version = SETTINGS_VERSION;
+        settings.size = sizeof(settings);
+        settings.crc = checksum(settings);
+
+        Preferences prefs;
+        if (!prefs.begin(SETTINGS_NVS_NAMESPACE, false))
+            return false;
+        bool ok = prefs.putBytes("record", &settings, sizeof(settings)) == sizeof(settings);
+        prefs.end();
+
+        if (!ok) { Serial.println("Failed to save settings"); }
+        return ok;
+    }
+
+    static uint32_t checksum(const KeypadSettings &settings)
+    {
+        return crc32_le(0, (const uint8_t *)&settings, offsetof(KeypadSettings, crc));
+    }
+};
@@ -0,0 +1,79 @@
+// Last known UI state, kept in NVS so the keypad has something to show straight after boot
+//
+// The renderer hands every batch of state changes to changed(). Once the state has been
+// quiet for SNAPSHOT_SAVE_DELAY, tick() writes it out, so dragging a volume slider costs
+// one flash write rather than dozens. restore() reads it back at boot, marked stale.
+
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <StateStore.h>
+
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_SAVE_DELAY 5000 // Quiet time before a changed state is written (in milliseconds)
+#define SNAPSHOT_NVS_NAMESPACE "snapshot"
+
+// Changes worth a flash write. Link status and art downloads in progress are not.
+#define SNAPSHOT_CHANGES (STATE_ZONE1_MUTE | STATE_ZONE1_VOL | STATE_ZONE2_MUTE | STATE_ZONE2_VOL | \
+                          STATE_SOURCE_NAME | STATE_STREAM_META | STATE_ART)
+
+class StateSnapshot
+{
+public:
+    StateSnapshot() : dirty(false), saveAt(0) {}
+
+    // Read the saved state. Returns false if there is none, or it is from another firmware layout.
+    bool restore(KeypadState &state)
+    {
+        Preferences prefs;
+        if (!prefs.begin(SNAPSHOT_NVS_NAMESPACE, true))
+            return false;
+
+        bool ok = (prefs.getUInt("version") == SNAPSHOT_VERSION) &&
+                  (prefs.getBytesLength("state") == sizeof(KeypadState)) &&
+                  (prefs.getBytes("state", &state, sizeof(KeypadState)) == sizeof(KeypadState));
+        prefs.end();
+        if (!ok)
+            return false;
+
+        // Only the data is trusted, not the link status at the time it was saved
+        state.apiUnreachable = false;
+        state.wifiConnected = false;
+        state.stale = true;
+        return true;
+    }
+
+    void changed(uint32_t bits, uint32_t nowMs)
+    {
+        if (bits & SNAPSHOT_CHANGES)
+        {
+            dirty = true;
+            saveAt = nowMs + SNAPSHOT_SAVE_DELAY;
+        }
+    }
+
+    // Save the state if it changed and has since been quiet for long enough
+    void tick(uint32_t nowMs, const KeypadState &state)
+    {
+        if (!dirty || ((int32_t)(nowMs - saveAt) < 0))
+            return;
+        dirty = false;
+
+        // Nothing confirmed by AmpliPi yet, keep the snapshot we have
+        if (state.stale || !state.stream.valid)
+            return;
+
+        Preferences prefs;
+        if (!prefs.begin(SNAPSHOT_NVS_NAMESPACE, false))
+            return;
+        prefs.putUInt("version", SNAPSHOT_VERSION);
+        prefs.putBytes("state", &state, sizeof(KeypadState));
+        prefs.end();
+        Serial.println("Saved state snapshot");
+    }
+
+private:
+    bool dirty;
+    uint32_t saveAt;
+};
@@ -0,0 +1,131 @@
+// Shared AmpliPi state for the keypad
+//
+// The network side publishes zones, source and stream data into a StateStore and the
+// UI reads it. The store is triple buffered: publishers fill a back buffer and swap it
+// in, the reader swaps the newest buffer out, and neither ever waits on the other or
+// sees a half written update. Each publish also ORs in a bitmask of what changed so
+// the UI only redraws the parts that need it.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+#define STATE_NAME_LEN 64
+#define STATE_TEXT_LEN 96
+#define STATE_STATUS_LEN 16
+#define STATE_URL_LEN 160
+#define STATE_ZONES 2
+
+// Change bits, returned by publish() and acquire()
+#define STATE_ZONE1_MUTE   (1u << 0)
+#define STATE_ZONE1_VOL    (1u << 1)
+#define STATE_ZONE2_MUTE   (1u << 2)
+#define STATE_ZONE2_VOL    (1u << 3)
+#define STATE_SOURCE_NAME  (1u << 4) // Name shown in the source bar
+#define STATE_STREAM_META  (1u << 5) // Song, artist or play status
+#define STATE_ART_REF      (1u << 6) // Album art URL changed, new art needs downloading
+#define STATE_ART          (1u << 7) // New album art is ready to draw
+#define STATE_LINK         (1u << 8) // WiFi or AmpliPi became reachable or unreachable, or stale data was confirmed
+
+#define STATE_ZONE_MUTE(i) (STATE_ZONE1_MUTE << ((i) * 2))
+#define STATE_ZONE_VOL(i)  (STATE_ZONE1_VOL << ((i) * 2))
+
+struct ZoneState
+{
+    bool valid; // Set once the zone has been read from AmpliPi
+    bool mute;
+    float volPercent;
+};
+
+struct StreamState
+{
+    bool valid; // Set once the stream has been read from AmpliPi
+    char name[STATE_NAME_LEN];
+    char artist[STATE_TEXT_LEN];
+    char album[STATE_TEXT_LEN];
+    char song[STATE_TEXT_LEN];
+    char status[STATE_STATUS_LEN];
+    char albumArt[STATE_URL_LEN];
+    uint16_t artVersion; // Bumped each time new album art has been downloaded
+};
+
+struct KeypadState
+{
+    ZoneState zones[STATE_ZONES];
+    StreamState stream;
+    bool apiUnreachable; // Last request to AmpliPi failed
+    bool wifiConnected;  // WiFi is up; while it is down the rest is the last known state
+    bool stale;          // Restored from the boot snapshot and not yet confirmed by AmpliPi
+};
+
+// Copy a possibly null string into a fixed size field. Returns true if the field changed.
+inline bool copyText(char *dst, size_t size, const char *src)
+{
+    if (src == nullptr) { src = ""; }
+    if (strncmp(dst, src, size - 1) == 0) { return false; }
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+    return true;
+}
+
+template <typename T>
+class StateStore
+{
+    static_assert(std::is_trivially_copyable<T>::value, "StateStore needs a plain data type");
+
+public:
+    StateStore() : buffers(), latest(), back(0), front(1), middle(2), changes(0)
+    {
+        writeLock.clear();
+    }
+
+    // Apply an update on the publisher side. apply(T &) edits the state and returns the
+    // change bits; nothing is published if it returns 0. Publishers are serialized with
+    // a spin lock, the reader never takes it.
+    template <typename Fn>
+    uint32_t publish(Fn apply)
+    {
+        while (writeLock.test_and_set(std::memory_order_acquire)) {}
+
+        uint32_t changed = apply(latest);
+        if (changed)
+        {
+            buffers[back] = latest;
+            back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+            changes.fetch_or(changed, std::memory_order_release);
+        }
+
+        writeLock.clear(std::memory_order_release);
+        return changed;
+    }
+
+    // Reader side: pick up the newest published state and return what changed since the
+    // last call. Only one context may read.
+    uint32_t acquire()
+    {
+        uint32_t changed = changes.exchange(0, std::memory_order_acq_rel);
+        if (middle.load(std::memory_order_acquire) & FRESH)
+        {
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        }
+        return changed;
+    }
+
+    // State as of the last acquire()
+    const T &current() const { return buffers[front]; }
+
+private:
+    static const uint8_t INDEX = 0x03;
+    static const uint8_t FRESH = 0x04;
+
+    T buffers[3];
+    T latest; // Publisher's working copy
+    uint8_t back;
+    uint8_t front;
+    std::atomic<uint8_t> middle;
+    std::atomic<uint32_t> changes;
+    std::atomic_flag writeLock;
+};
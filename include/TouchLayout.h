@@ -0,0 +1,107 @@
+// Touch hit-test tables for the keypad screens
+//
+// Each screen describes its buttons as a constexpr table of HitRegions. A coarse grid
+// (HITGRID_CELL pixels square) is built from that table at compile time, so a touch only
+// has to look up one cell and check the few regions that overlap it.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+
+#define HITGRID_SCREEN_W 240
+#define HITGRID_SCREEN_H 320
+#define HITGRID_CELL 20
+#define HITGRID_COLS (HITGRID_SCREEN_W / HITGRID_CELL)
+#define HITGRID_ROWS (HITGRID_SCREEN_H / HITGRID_CELL)
+
+// Each grid cell is a bitmask of region indexes, so a screen can have up to 16 regions
+typedef uint16_t HitMask;
+#define HITGRID_MAX_REGIONS (sizeof(HitMask) * 8)
+
+typedef std::array<HitMask, HITGRID_COLS * HITGRID_ROWS> HitGrid;
+typedef void (*TouchHandler)(uint16_t x, uint16_t y);
+
+// Half-open bounds: a point is inside when x0 <= x < x1 and y0 <= y < y1
+struct HitRegion
+{
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1;
+    uint16_t y1;
+    TouchHandler handler;
+};
+
+// Region for a button drawn at X/Y/W/H. Matches the (x > X) && (x < X + W) and
+// (y > Y) && (y <= Y + H) tests the buttons have always used.
+constexpr HitRegion hitButton(int x, int y, int w, int h, TouchHandler handler)
+{
+    return HitRegion{(uint16_t)(x + 1), (uint16_t)(y + 1), (uint16_t)(x + w), (uint16_t)(y + h + 1), handler};
+}
+
+// Region from explicit half-open bounds
+constexpr HitRegion hitBounds(int x0, int y0, int x1, int y1, TouchHandler handler)
+{
+    return HitRegion{(uint16_t)x0, (uint16_t)y0, (uint16_t)x1, (uint16_t)y1, handler};
+}
+
+constexpr bool hitContains(const HitRegion &region, uint16_t x, uint16_t y)
+{
+    return (x >= region.x0) && (x < region.x1) && (y >= region.y0) && (y < region.y1);
+}
+
+// Mark every grid cell a region overlaps with that region's bit
+template <size_t N>
+constexpr HitGrid buildHitGrid(const HitRegion (&regions)[N])
+{
+    static_assert(N <= HITGRID_MAX_REGIONS, "Too many hit regions for one screen");
+
+    HitGrid grid{};
+    for (size_t i = 0; i < N; i++)
+    {
+        const HitRegion &r = regions[i];
+        if ((r.x1 <= r.x0) || (r.y1 <= r.y0) || (r.x0 >= HITGRID_SCREEN_W) || (r.y0 >= HITGRID_SCREEN_H))
+            continue;
+
+        int lastCol = (r.x1 - 1) / HITGRID_CELL;
+        int lastRow = (r.y1 - 1) / HITGRID_CELL;
+        if (lastCol >= HITGRID_COLS) { lastCol = HITGRID_COLS - 1; }
+        if (lastRow >= HITGRID_ROWS) { lastRow = HITGRID_ROWS - 1; }
+
+        for (int row = r.y0 / HITGRID_CELL; row <= lastRow; row++)
+        {
+            for (int col = r.x0 / HITGRID_CELL; col <= lastCol; col++)
+            {
+                grid[row * HITGRID_COLS + col] |= (HitMask)(1u << i);
+            }
+        }
+    }
+    return grid;
+}
+
+// One screen's touch layout. Regions earlier in the table win when they overlap.
+struct ScreenLayout
+{
+    const char *name;
+    const HitRegion *regions;
+    uint8_t count;
+    const HitGrid *grid;
+};
+
+// Find the region under a touch, or nullptr if nothing was hit
+inline const HitRegion *hitTest(const ScreenLayout &layout, uint16_t x, uint16_t y)
+{
+    if ((x >= HITGRID_SCREEN_W) || (y >= HITGRID_SCREEN_H))
+        return nullptr;
+
+    HitMask candidates = (*layout.grid)[(y / HITGRID_CELL) * HITGRID_COLS + (x / HITGRID_CELL)];
+    while (candidates)
+    {
+        uint8_t i = __builtin_ctz(candidates);
+        if (hitContains(layout.regions[i], x, y))
+            return &layout.regions[i];
+        candidates &= candidates - 1;
+    }
+    return nullptr;
+}
@@ -0,0 +1,160 @@
+// Touch recording and interaction latency for the keypad
+//
+// TouchRecorder turns the raw touch samples loop() reads into lines in the native host's
+// touch script format, "<ms> <x> <y> <held ms>", with the time counted from begin().
+// Samples at the same point are merged into one line; a drag gives a line per point.
+// Recordings from a keypad can be played back on the host with --replay.
+//
+// InteractionTimer follows the latest accepted touch through its handler (the state
+// change), the first frame drawn after it and the first PATCH to AmpliPi that completes
+// after it, in microseconds from the touch. begin(), handled(), framePushed() and
+// report() are called from loop(); patchSent() may come from the network task.
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+#define TOUCH_RECORD_LINE 32 // Longest line a TouchRecorder writes, with the terminator
+
+class TouchRecorder
+{
+public:
+    TouchRecorder() : originMs(0), open(false), startMs(0), lastX(0), lastY(0) {}
+
+    void begin(uint32_t nowMs) { originMs = nowMs; }
+
+    // Feed one sample. Returns true when a touch line has been completed into line.
+    bool sample(uint32_t nowMs, bool pressed, uint16_t x, uint16_t y, char *line, size_t size)
+    {
+        bool moved = pressed && open && ((x != lastX) || (y != lastY));
+        bool done = open && (!pressed || moved);
+        if (done)
+        {
+            snprintf(line, size, "%u %u %u %u", (unsigned)(startMs - originMs), (unsigned)lastX,
+                     (unsigned)lastY, (unsigned)((nowMs > startMs) ? nowMs - startMs : 1));
+            open = false;
+        }
+        if (pressed && !open)
+        {
+            open = true;
+            startMs = nowMs;
+            lastX = x;
+            lastY = y;
+        }
+        return done;
+    }
+
+private:
+    uint32_t originMs;
+    bool open;
+    uint32_t startMs;
+    uint16_t lastX;
+    uint16_t lastY;
+};
+
+struct InteractionPhase
+{
+    uint32_t count;
+    uint64_t totalUs;
+    uint32_t maxUs;
+
+    void add(uint32_t us)
+    {
+        ++count;
+        totalUs += us;
+        if (us > maxUs) { maxUs = us; }
+    }
+};
+
+class InteractionTimer
+{
+public:
+    // Interactions are reported once windowMs has passed without another touch
+    explicit InteractionTimer(uint32_t windowMs)
+        : windowUs(windowMs * 1000), touches(0), active(false), touchUs(0), x(0), y(0), screen(""),
+          stateUs(0), frameUs(0), patchUs(0), state(), frame(), patch() {}
+
+    // A touch was accepted on screen. Any interaction still open is reported first.
+    void begin(uint32_t nowUs, uint16_t touchX, uint16_t touchY, const char *screenName)
+    {
+        report(Serial, nowUs, true);
+        ++touches;
+        active = true;
+        touchUs = nowUs;
+        x = touchX;
+        y = touchY;
+        screen = screenName;
+        stateUs = 0;
+        frameUs = 0;
+        patchUs.store(0);
+    }
+
+    // The touch handler has returned and the keypad state reflects the touch
+    void handled(uint32_t nowUs)
+    {
+        if (active && (stateUs == 0)) { stateUs = elapsed(nowUs); }
+    }
+
+    void framePushed(uint32_t nowUs)
+    {
+        if (active && (stateUs != 0) && (frameUs == 0)) { frameUs = elapsed(nowUs); }
+    }
+
+    void patchSent(uint32_t nowUs)
+    {
+        uint32_t expected = 0;
+        if (active) { patchUs.compare_exchange_strong(expected, elapsed(nowUs)); }
+    }
+
+    // Print the open interaction as one JSON line once its window is over, or straight
+    // away with force. Phases that never happened are -1.
+    void report(Print &out, uint32_t nowUs, bool force = false)
+    {
+        if (!active || (!force && (nowUs - touchUs < windowUs)))
+            return;
+        active = false;
+        uint32_t patched = patchUs.load();
+        if (stateUs) { state.add(stateUs); }
+        if (frameUs) { frame.add(frameUs); }
+        if (patched) { patch.add(patched); }
+        out.printf("{\"touch\":%u,\"x\":%u,\"y\":%u,\"screen\":\"%s\",\"state_us\":%ld,\"frame_us\":%ld,\"patch_us\":%ld}\n",
+                   (unsigned)touches, (unsigned)x, (unsigned)y, screen, phase(stateUs), phase(frameUs), phase(patched));
+    }
+
+    // Totals over every reported interaction, as one JSON line
+    void summary(Print &out) const
+    {
+        out.printf("{\"touches\":%u", (unsigned)touches);
+        printPhase(out, "state", state);
+        printPhase(out, "frame", frame);
+        printPhase(out, "patch", patch);
+        out.println("}");
+    }
+
+private:
+    // Never 0, which marks a phase that hasn't happened
+    uint32_t elapsed(uint32_t nowUs) const { return (nowUs != touchUs) ? nowUs - touchUs : 1; }
+
+    static long phase(uint32_t us) { return us ? (long)us : -1L; }
+
+    static void printPhase(Print &out, const char *name, const InteractionPhase &p)
+    {
+        out.printf(",\"%s\":{\"count\":%u,\"avg_us\":%u,\"max_us\":%u}", name, (unsigned)p.count,
+                   (unsigned)(p.count ? p.totalUs / p.count : 0), (unsigned)p.maxUs);
+    }
+
+    uint32_t windowUs;
+    uint32_t touches;
+    bool active;
+    uint32_t touchUs;
+    uint16_t x;
+    uint16_t y;
+    const char *screen;
+    uint32_t stateUs;
+    uint32_t frameUs;
+    std::atomic<uint32_t> patchUs;
+    InteractionPhase state;
+    InteractionPhase frame;
+    InteractionPhase patch;
+};
@@ -0,0 +1,139 @@
+// Hot path tracing for the keypad
+//
+// Built with TRACE set, TRACE_SCOPE(name) records a begin event where it is declared and
+// an end event when its scope closes, each with micros() and the task it ran on, into a
+// ring buffer holding the last TRACE_EVENTS events. TRACE_DUMP(out) prints the buffer as
+// one line of Chrome trace event JSON, which chrome://tracing and Perfetto load. Without
+// TRACE every macro compiles to nothing. Names must be string literals.
+//
+// TRACE_ITERATION(name) is TRACE_SCOPE for a loop body: a pass that recorded nothing
+// else is taken back out of the buffer, so idle passes don't push out the busy ones.
+
+#pragma once
+
+#ifndef TRACE
+#define TRACE 0
+#endif
+
+#if TRACE
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS 1024
+#endif
+#define TRACE_MAX_TASKS 8
+
+struct TraceEvent
+{
+    const char *name;
+    TaskHandle_t task;
+    uint32_t us;
+    char phase; // 'B' or 'E'
+};
+
+class TraceBuffer
+{
+public:
+    TraceBuffer() : next(0), paused(false) {}
+
+    // Returns the event's position, for drop()
+    uint32_t record(const char *name, char phase)
+    {
+        if (paused.load(std::memory_order_relaxed))
+            return UINT32_MAX;
+        uint32_t position = next.fetch_add(1, std::memory_order_relaxed);
+        TraceEvent &event = events[position % TRACE_EVENTS];
+        event.name = name;
+        event.task = xTaskGetCurrentTaskHandle();
+        event.us = micros();
+        event.phase = phase;
+        return position;
+    }
+
+    // Take back the event at position if nothing has been recorded after it
+    bool drop(uint32_t position)
+    {
+        uint32_t expected = position + 1;
+        return (position != UINT32_MAX) && next.compare_exchange_strong(expected, position);
+    }
+
+    // Recording stops while the buffer prints, and starts again empty afterwards.
+    // The task that dumps is named "loop", the others by when they first appear.
+    void dump(Print &out)
+    {
+        paused.store(true);
+        delay(1); // Let a record() on another task finish its event
+        uint32_t end = next.load();
+        uint32_t start = (end > TRACE_EVENTS) ? end - TRACE_EVENTS : 0;
+
+        TaskHandle_t tasks[TRACE_MAX_TASKS] = {xTaskGetCurrentTaskHandle()};
+        uint8_t taskCount = 1;
+        out.print("{\"traceEvents\":[{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"loop\"}}");
+        for (uint32_t i = start; i < end; i++)
+        {
+            const TraceEvent &event = events[i % TRACE_EVENTS];
+            uint8_t tid = 0;
+            while ((tid < taskCount) && (tasks[tid] != event.task)) { ++tid; }
+            if ((tid == taskCount) && (taskCount < TRACE_MAX_TASKS)) { tasks[taskCount++] = event.task; }
+            out.printf(",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%u,\"pid\":1,\"tid\":%u}",
+                       event.name, event.phase, (unsigned)event.us, (unsigned)(tid + 1));
+        }
+        out.println("]}");
+
+        next.store(0);
+        paused.store(false);
+    }
+
+private:
+    TraceEvent events[TRACE_EVENTS];
+    std::atomic<uint32_t> next; // Total recorded; the ring holds the last TRACE_EVENTS
+    std::atomic<bool> paused;
+};
+
+inline TraceBuffer traceBuffer;
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *scopeName) : name(scopeName) { traceBuffer.record(name, 'B'); }
+    ~TraceScope() { traceBuffer.record(name, 'E'); }
+
+private:
+    const char *name;
+};
+
+class TraceIteration
+{
+public:
+    explicit TraceIteration(const char *scopeName) : name(scopeName), begin(traceBuffer.record(name, 'B')) {}
+    ~TraceIteration()
+    {
+        if (!traceBuffer.drop(begin)) { traceBuffer.record(name, 'E'); }
+    }
+
+private:
+    const char *name;
+    uint32_t begin;
+};
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_JOIN(traceScope, __LINE__)(name)
+#define TRACE_ITERATION(name) TraceIteration TRACE_JOIN(traceIteration, __LINE__)(name)
+#define TRACE_BEGIN(name) traceBuffer.record(name, 'B')
+#define TRACE_END(name) traceBuffer.record(name, 'E')
+#define TRACE_DUMP(out) traceBuffer.dump(out)
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_ITERATION(name)
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_DUMP(out)
+
+#endif
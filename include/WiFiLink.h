@@ -0,0 +1,288 @@
+// Non-blocking WiFi reconnection for the keypad
+//
+// WiFi events from the ESP32 core tell us when the link comes up or drops. tick() is
+// called every loop() and moves the reconnect state machine along without ever waiting:
+// it starts a connection attempt, gives it WIFI_LINK_CONNECT_TIMEOUT to get an IP, and
+// otherwise backs off (doubling up to WIFI_LINK_BACKOFF_MAX, with jitter) before trying
+// the next stored network.
+//
+// The BSSID, channel and IP settings of the last network we got an IP on are kept in NVS.
+// The first attempt at boot uses them to join that access point directly, skipping the
+// scan, and gives up on it after WIFI_LINK_FAST_CONNECT_TIMEOUT rather than the full
+// attempt time. The first reconnect attempt after a drop also goes straight there.
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <atomic>
+#include "esp_system.h"
+
+#define WIFI_LINK_MAX_CREDENTIALS 4
+#define WIFI_LINK_CONNECT_TIMEOUT 10000 // How long one attempt may take (in milliseconds)
+#define WIFI_LINK_BACKOFF_MIN 1000      // First wait after a failed attempt (in milliseconds)
+#define WIFI_LINK_BACKOFF_MAX 60000     // Longest wait between attempts (in milliseconds)
+#define WIFI_LINK_FAST_CONNECT_TIMEOUT 1500 // How long the directed attempt at boot may take (in milliseconds)
+#define WIFI_LINK_REUSE_IP false        // Also reuse the last IP settings and skip DHCP at boot
+#define WIFI_LINK_NVS_NAMESPACE "wifilink"
+
+// Where we were last connected
+struct WiFiLinkCache
+{
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+enum WiFiLinkState : uint8_t
+{
+    WIFI_LINK_UP,
+    WIFI_LINK_CONNECTING,
+    WIFI_LINK_BACKOFF,
+};
+
+class WiFiLink
+{
+public:
+    WiFiLink() : credentialCount(0), nextCredential(0), linkState(WIFI_LINK_CONNECTING),
+                 attemptStartedAt(0), backoffUntil(0), backoff(WIFI_LINK_BACKOFF_MIN), reconnectCount(0),
+                 cacheLoaded(false), directedNext(false), fastAttempt(false), staticIP(false), gotIP(false) {}
+
+    // Add a network to try. Duplicates and empty SSIDs are ignored.
+    void addCredential(const char *ssid, const char *pass)
+    {
+        if ((ssid == nullptr) || (ssid[0] == '\0') || (credentialCount >= WIFI_LINK_MAX_CREDENTIALS))
+            return;
+
+        for (uint8_t i = 0; i < credentialCount; i++)
+        {
+            if (strcmp(credentials[i].ssid, ssid) == 0)
+                return;
+        }
+
+        strncpy(credentials[credentialCount].ssid, ssid, sizeof(credentials[0].ssid) - 1);
+        strncpy(credentials[credentialCount].pass, pass ? pass : "", sizeof(credentials[0].pass) - 1);
+        ++credentialCount;
+    }
+
+    // Register for WiFi events and, unless already connected, start the first attempt.
+    // Call once, after the credentials have been added. Never blocks.
+    void begin()
+    {
+        instance = this;
+        WiFi.setAutoReconnect(false); // We handle reconnects ourselves, with backoff
+        WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+        WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_LOST_IP);
+        WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+        gotIP = (WiFi.status() == WL_CONNECTED);
+        if (gotIP)
+        {
+            linkState = WIFI_LINK_UP;
+            rememberConnection();
+            return;
+        }
+
+        WiFi.mode(WIFI_STA);
+        directedNext = true;
+        fastAttempt = true;
+        startAttempt(millis());
+    }
+
+    // Move the state machine along. Never blocks.
+    void tick(uint32_t nowMs)
+    {
+        bool up = gotIP.load(std::memory_order_acquire);
+
+        switch (linkState)
+        {
+        case WIFI_LINK_UP:
+            if (!up)
+            {
+                Serial.println(F("WiFi lost, reconnecting in the background"));
+                ++reconnectCount;
+                backoff = WIFI_LINK_BACKOFF_MIN;
+                directedNext = true; // Most drops are brief, the same access point is the best bet
+                startAttempt(nowMs);
+            }
+            break;
+
+        case WIFI_LINK_CONNECTING:
+            if (up)
+            {
+                Serial.print(F("WiFi connected to "));
+                Serial.print(WiFi.SSID());
+                Serial.print(F(", IP address: "));
+                Serial.println(WiFi.localIP());
+                linkState = WIFI_LINK_UP;
+                backoff = WIFI_LINK_BACKOFF_MIN;
+                rememberConnection();
+            }
+            else if (fastAttempt && (nowMs - attemptStartedAt >= WIFI_LINK_FAST_CONNECT_TIMEOUT))
+            {
+                // The access point from last time didn't answer, scan for any we know instead
+                Serial.println(F("WiFi fast connect failed, scanning instead"));
+                WiFi.disconnect();
+                if (staticIP)
+                {
+                    staticIP = false;
+                    WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0)); // Back to DHCP
+                }
+                startAttempt(nowMs);
+            }
+            else if (nowMs - attemptStartedAt >= WIFI_LINK_CONNECT_TIMEOUT)
+            {
+                WiFi.disconnect();
+                nextCredential = (nextCredential + 1) % (credentialCount ? credentialCount : 1);
+                uint32_t wait = backoff - (backoff / 5) + (esp_random() % (backoff / 5 * 2 + 1)); // +/- 20% jitter
+                Serial.printf("WiFi attempt timed out, retrying in %u ms\n", (unsigned)wait);
+                backoffUntil = nowMs + wait;
+                backoff = (backoff * 2 > WIFI_LINK_BACKOFF_MAX) ? WIFI_LINK_BACKOFF_MAX : backoff * 2;
+                linkState = WIFI_LINK_BACKOFF;
+            }
+            break;
+
+        case WIFI_LINK_BACKOFF:
+            if (up)
+            {
+                linkState = WIFI_LINK_UP;
+                rememberConnection();
+            }
+            else if ((int32_t)(nowMs - backoffUntil) >= 0)
+            {
+                startAttempt(nowMs);
+            }
+            break;
+        }
+    }
+
+    bool connected() const { return gotIP.load(std::memory_order_acquire); }
+    WiFiLinkState state() const { return linkState; }
+    uint32_t reconnects() const { return reconnectCount; }
+
+private:
+    struct Credential
+    {
+        char ssid[33];
+        char pass[65];
+    };
+
+    void startAttempt(uint32_t nowMs)
+    {
+        linkState = WIFI_LINK_CONNECTING;
+        attemptStartedAt = nowMs;
+        bool fast = fastAttempt;
+        fastAttempt = false;
+        if (credentialCount == 0)
+            return;
+
+        const Credential *cached = directedNext ? cachedCredential() : nullptr;
+        directedNext = false;
+        if (cached != nullptr)
+        {
+            fastAttempt = fast;
+            if (fastAttempt && WIFI_LINK_REUSE_IP && (cache.ip != 0))
+            {
+                staticIP = true;
+                WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+            }
+            Serial.print(fastAttempt ? F("WiFi fast connect to ") : F("WiFi reconnecting directly to "));
+            Serial.println(cached->ssid);
+            WiFi.begin(cached->ssid, cached->pass, cache.channel, cache.bssid);
+            return;
+        }
+
+        const Credential &cred = credentials[nextCredential];
+        Serial.print(F("WiFi connecting to "));
+        Serial.println(cred.ssid);
+        WiFi.begin(cred.ssid, cred.pass);
+    }
+
+    // The stored credential matching the cached access point, if there is one
+    const Credential *cachedCredential()
+    {
+        if (!cacheLoaded)
+        {
+            Preferences prefs;
+            cacheLoaded = true;
+            if (!prefs.begin(WIFI_LINK_NVS_NAMESPACE, true))
+                return nullptr;
+            if (prefs.getBytes("last", &cache, sizeof(cache)) != sizeof(cache))
+            {
+                memset(&cache, 0, sizeof(cache));
+            }
+            cache.ssid[sizeof(cache.ssid) - 1] = '\0';
+            prefs.end();
+        }
+
+        if ((cache.ssid[0] == '\0') || (cache.channel == 0))
+            return nullptr;
+
+        for (uint8_t i = 0; i < credentialCount; i++)
+        {
+            if (strcmp(credentials[i].ssid, cache.ssid) == 0)
+                return &credentials[i];
+        }
+        return nullptr;
+    }
+
+    // Save where we are connected, if it differs from what is stored, to spare the flash
+    void rememberConnection()
+    {
+        WiFiLinkCache now = {};
+        strncpy(now.ssid, WiFi.SSID().c_str(), sizeof(now.ssid) - 1);
+        uint8_t *bssid = WiFi.BSSID();
+        if (bssid != nullptr)
+        {
+            memcpy(now.bssid, bssid, sizeof(now.bssid));
+        }
+        now.channel = WiFi.channel();
+        now.ip = WiFi.localIP();
+        now.gateway = WiFi.gatewayIP();
+        now.subnet = WiFi.subnetMask();
+        now.dns = WiFi.dnsIP(0);
+
+        cachedCredential(); // Make sure the stored copy has been loaded
+        if (memcmp(&now, &cache, sizeof(cache)) == 0)
+            return;
+
+        cache = now;
+        Preferences prefs;
+        if (prefs.begin(WIFI_LINK_NVS_NAMESPACE, false))
+        {
+            prefs.putBytes("last", &cache, sizeof(cache));
+            prefs.end();
+        }
+    }
+
+    // Runs on the WiFi event task
+    static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t /*info*/)
+    {
+        if (instance == nullptr)
+            return;
+        instance->gotIP.store(event == ARDUINO_EVENT_WIFI_STA_GOT_IP, std::memory_order_release);
+    }
+
+    static WiFiLink *instance;
+
+    Credential credentials[WIFI_LINK_MAX_CREDENTIALS] = {};
+    uint8_t credentialCount;
+    uint8_t nextCredential;
+    WiFiLinkState linkState;
+    uint32_t attemptStartedAt;
+    uint32_t backoffUntil;
+    uint32_t backoff;
+    uint32_t reconnectCount;
+    WiFiLinkCache cache = {};
+    bool cacheLoaded;
+    bool directedNext; // Next attempt goes straight to the cached access point
+    bool fastAttempt;  // This attempt is the directed one at boot
+    bool staticIP;     // The boot attempt reused the cached IP settings
+    std::atomic<bool> gotIP;
+};
+
+inline WiFiLink *WiFiLink::instance = nullptr;
@@ -0,0 +1,175 @@
+#include "Arduino.h"
+#include "esp_system.h"
+#include "rom/crc.h"
+
+#include <chrono>
+#include <malloc.h>
+#include <mutex>
+#include <poll.h>
+#include <random>
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+#include <zlib.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static const std::chrono::steady_clock::time_point startedAt = std::chrono::steady_clock::now();
+
+unsigned long millis()
+{
+    return (unsigned long)(uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startedAt).count();
+}
+
+unsigned long micros()
+{
+    return (unsigned long)(uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startedAt).count();
+}
+
+void delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield()
+{
+    std::this_thread::yield();
+}
+
+static std::mutex randomLock;
+static std::mt19937 arduinoRandom(1);
+
+long random(long howBig)
+{
+    if (howBig <= 0)
+        return 0;
+    std::lock_guard<std::mutex> lock(randomLock);
+    return (long)(arduinoRandom() % (uint32_t)howBig);
+}
+
+long random(long howSmall, long howBig)
+{
+    if (howSmall >= howBig)
+        return howSmall;
+    return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+    std::lock_guard<std::mutex> lock(randomLock);
+    arduinoRandom.seed((uint32_t)seed);
+}
+
+uint32_t esp_random()
+{
+    static std::random_device device;
+    static std::mutex deviceLock;
+    std::lock_guard<std::mutex> lock(deviceLock);
+    return device();
+}
+
+uint32_t crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    // Same polynomial and inversions as the ROM routine, so results match the device's
+    return (uint32_t)crc32(crc, buf, len);
+}
+
+
+/**********/
+/* Serial */
+/**********/
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = fwrite(buffer, 1, size, stdout);
+    if (memchr(buffer, '\n', size)) { fflush(stdout); }
+    return n;
+}
+
+int HardwareSerial::available()
+{
+    if (peeked >= 0)
+        return 1;
+    struct pollfd in = {STDIN_FILENO, POLLIN, 0};
+    return (poll(&in, 1, 0) > 0) && (in.revents & POLLIN) ? 1 : 0;
+}
+
+int HardwareSerial::read()
+{
+    if (peeked >= 0)
+    {
+        int c = peeked;
+        peeked = -1;
+        return c;
+    }
+    if (!available())
+        return -1;
+    uint8_t c;
+    return (::read(STDIN_FILENO, &c, 1) == 1) ? c : -1;
+}
+
+int HardwareSerial::peek()
+{
+    if (peeked < 0) { peeked = read(); }
+    return peeked;
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+
+/*******/
+/* ESP */
+/*******/
+
+// The host heap has nothing to do with the ESP32's, but the numbers still move with the
+// keypad's own allocations, which is what comparisons need
+uint32_t EspClass::getHeapSize()
+{
+    struct mallinfo2 info = mallinfo2();
+    return (uint32_t)info.arena;
+}
+
+uint32_t EspClass::getFreeHeap()
+{
+    struct mallinfo2 info = mallinfo2();
+    return (uint32_t)info.fordblks;
+}
+
+uint32_t EspClass::getMinFreeHeap()
+{
+    return getFreeHeap();
+}
+
+uint32_t EspClass::getMaxAllocHeap()
+{
+    return getFreeHeap();
+}
+
+uint64_t EspClass::getEfuseMac()
+{
+    const char *mac = getenv("KEYPAD_MAC");
+    if (mac != nullptr)
+        return strtoull(mac, nullptr, 16);
+    return 0xA5B4C3D2E1F0ULL;
+}
+
+void EspClass::restart()
+{
+    Serial.println("ESP.restart() called, exiting");
+    fflush(stdout);
+    exit(0);
+}
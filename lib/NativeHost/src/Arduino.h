@@ -0,0 +1,92 @@
+// Arduino core for the native build
+//
+// Enough of the ESP32 Arduino core for the keypad firmware to build and run as a host
+// program: String, Print and Stream, Serial on stdin/stdout, the clock, random numbers and
+// a few ESP.* queries. Pin functions do nothing.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef unsigned int word;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define PROGMEM
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+using std::max;
+using std::min;
+
+template <typename T, typename L, typename H>
+T constrain(T value, L low, H high)
+{
+    return (value < low) ? low : ((value > high) ? high : value);
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+
+// Serial on the terminal: writes go to stdout, reads come from stdin without blocking
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long /*baud*/) {}
+    void end() {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    operator bool() const { return true; }
+    using Print::write;
+
+private:
+    int peeked = -1;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint64_t getEfuseMac(); // KEYPAD_MAC in the environment picks another unit
+    const char *getSdkVersion() { return "native"; }
+    void restart();
+};
+
+extern EspClass ESP;
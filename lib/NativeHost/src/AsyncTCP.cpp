@@ -0,0 +1,257 @@
+#include "AsyncTCP.h"
+#include "WiFi.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#define ASYNC_TCP_CONNECT_TIMEOUT 5000
+#define ASYNC_TCP_POLL_MS 20
+
+struct AsyncClient::Connection
+{
+    int fd = -1;
+    bool connected = false;
+    bool finished = false; // onDisconnect has run; nothing more is delivered
+
+    ~Connection()
+    {
+        if (fd >= 0) { ::close(fd); }
+    }
+};
+
+AsyncClient::AsyncClient(void * /*pcb*/) : lock(std::make_shared<std::recursive_mutex>())
+{
+}
+
+AsyncClient::~AsyncClient()
+{
+    std::lock_guard<std::recursive_mutex> guard(*lock);
+    disconnectCb = nullptr;
+    close(true);
+}
+
+bool AsyncClient::connect(IPAddress ip, uint16_t port)
+{
+    return connect(ip.toString().c_str(), port);
+}
+
+bool AsyncClient::connect(const char *host, uint16_t port)
+{
+    std::lock_guard<std::recursive_mutex> guard(*lock);
+    if (connection && !connection->finished)
+        return false;
+    if (WiFi.status() != WL_CONNECTED)
+        return false;
+
+    connection = std::make_shared<Connection>();
+    std::thread(&AsyncClient::run, this, connection, String(host), port).detach();
+    return true;
+}
+
+bool AsyncClient::current(const std::shared_ptr<Connection> &c)
+{
+    return (connection == c) && !c->finished;
+}
+
+// The last callback of a connection. Call with the lock held
+void AsyncClient::finish(const std::shared_ptr<Connection> &c)
+{
+    if (c->finished)
+        return;
+    c->finished = true;
+    c->connected = false;
+    if (c->fd >= 0) { shutdown(c->fd, SHUT_RDWR); }
+    if (disconnectCb) { disconnectCb(disconnectArg, this); }
+}
+
+void AsyncClient::run(std::shared_ptr<Connection> c, String host, uint16_t port)
+{
+    std::shared_ptr<std::recursive_mutex> held = lock;
+
+    // Resolve and connect outside the lock, as lwIP would in the background
+    IPAddress ip;
+    int fd = -1;
+    if (WiFi.hostByName(host.c_str(), ip))
+    {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = (uint32_t)ip;
+        int error = 0;
+        socklen_t length = sizeof(error);
+        struct pollfd wait = {fd, POLLOUT, 0};
+        bool ok = ((::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) || (errno == EINPROGRESS)) &&
+                  (poll(&wait, 1, ASYNC_TCP_CONNECT_TIMEOUT) == 1) &&
+                  (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0) && (error == 0);
+        if (!ok)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    {
+        std::lock_guard<std::recursive_mutex> guard(*held);
+        if (!current(c))
+        {
+            if (fd >= 0) { ::close(fd); }
+            return;
+        }
+        if (fd < 0)
+        {
+            if (errorCb) { errorCb(errorArg, this, ERR_CONN); }
+            finish(c);
+            return;
+        }
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        c->fd = fd;
+        c->connected = true;
+        if (connectCb) { connectCb(connectArg, this); }
+    }
+
+    uint8_t buffer[1436]; // One TCP segment, as lwIP would hand over
+    uint32_t lastRx = millis();
+    while (true)
+    {
+        struct pollfd wait = {fd, POLLIN, 0};
+        int ready = poll(&wait, 1, ASYNC_TCP_POLL_MS);
+
+        std::lock_guard<std::recursive_mutex> guard(*held);
+        if (!current(c))
+            return;
+
+        if (ready > 0)
+        {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (n > 0)
+            {
+                lastRx = millis();
+                if (dataCb) { dataCb(dataArg, this, buffer, (size_t)n); }
+                continue;
+            }
+            if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+                continue;
+            if (n < 0 && errorCb) { errorCb(errorArg, this, ERR_RST); }
+            finish(c);
+            return;
+        }
+
+        if ((rxTimeout > 0) && (millis() - lastRx >= rxTimeout * 1000))
+        {
+            if (timeoutCb) { timeoutCb(timeoutArg, this, millis() - lastRx); }
+            lastRx = millis();
+        }
+    }
+}
+
+void AsyncClient::close(bool /*now*/)
+{
+    std::lock_guard<std::recursive_mutex> guard(*lock);
+    if (connection) { finish(connection); }
+}
+
+int8_t AsyncClient::abort()
+{
+    close(true);
+    return ERR_ABRT;
+}
+
+bool AsyncClient::connected()
+{
+    std::lock_guard<std::recursive_mutex> guard(*lock);
+    return connection && connection->connected;
+}
+
+bool AsyncClient::disconnected()
+{
+    std::lock_guard<std::recursive_mutex> guard(*lock);
+    return !connection || connection->finished;
+}
+
+size_t AsyncClient::add(const char *data, size_t size, uint8_t apiflags)
+{
+    return write(data, size, apiflags);
+}
+
+size_t AsyncClient::write(const char *data)
+{
+    return write(data, strlen(data));
+}
+
+size_t AsyncClient::write(const char *data, size_t size, uint8_t /*apiflags*/)
+{
+    std::lock_guard<std::recursive_mutex> guard(*lock);
+    if (!connection || !connection->connected)
+        return 0;
+    size_t sent = 0;
+    while (sent < size)
+    {
+        ssize_t n = ::send(connection->fd, data + sent, size - sent, MSG_NOSIGNAL);
+        if (n > 0)
+        {
+            sent += n;
+            continue;
+        }
+        if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            struct pollfd wait = {connection->fd, POLLOUT, 0};
+            if (poll(&wait, 1, ASYNC_TCP_CONNECT_TIMEOUT) == 1)
+                continue;
+        }
+        break;
+    }
+    return sent;
+}
+
+void AsyncClient::onConnect(AcConnectHandler cb, void *arg)
+{
+    connectCb = cb;
+    connectArg = arg;
+}
+
+void AsyncClient::onDisconnect(AcConnectHandler cb, void *arg)
+{
+    disconnectCb = cb;
+    disconnectArg = arg;
+}
+
+void AsyncClient::onData(AcDataHandler cb, void *arg)
+{
+    dataCb = cb;
+    dataArg = arg;
+}
+
+void AsyncClient::onError(AcErrorHandler cb, void *arg)
+{
+    errorCb = cb;
+    errorArg = arg;
+}
+
+void AsyncClient::onTimeout(AcTimeoutHandler cb, void *arg)
+{
+    timeoutCb = cb;
+    timeoutArg = arg;
+}
+
+const char *AsyncClient::errorToString(int8_t error)
+{
+    switch (error)
+    {
+    case ERR_OK: return "OK";
+    case ERR_TIMEOUT: return "Timeout";
+    case ERR_CONN: return "Not connected";
+    case ERR_ABRT: return "Connection aborted";
+    case ERR_RST: return "Connection reset";
+    case ERR_CLSD: return "Connection closed";
+    default: return "UNKNOWN";
+    }
+}
@@ -0,0 +1,85 @@
+// AsyncTCP for the native build
+//
+// Each connection gets a thread that plays the async_tcp task: it connects, then calls
+// onData as bytes arrive and onDisconnect when the peer closes. As on the ESP32,
+// onDisconnect is always the last callback of a connection, and close() from another task
+// runs it before returning.
+
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#define ERR_OK 0
+#define ERR_TIMEOUT -3
+#define ERR_CONN -11
+#define ERR_ABRT -13
+#define ERR_RST -14
+#define ERR_CLSD -15
+
+#define ASYNC_WRITE_FLAG_COPY 0x01
+
+class AsyncClient;
+
+typedef std::function<void(void *, AsyncClient *)> AcConnectHandler;
+typedef std::function<void(void *, AsyncClient *, void *data, size_t len)> AcDataHandler;
+typedef std::function<void(void *, AsyncClient *, int8_t error)> AcErrorHandler;
+typedef std::function<void(void *, AsyncClient *, uint32_t time)> AcTimeoutHandler;
+
+class AsyncClient
+{
+public:
+    AsyncClient(void *pcb = nullptr);
+    ~AsyncClient();
+
+    bool connect(IPAddress ip, uint16_t port);
+    bool connect(const char *host, uint16_t port);
+    void close(bool now = false);
+    void stop() { close(false); }
+    int8_t abort();
+
+    bool connected();
+    bool disconnected();
+    bool canSend() { return connected(); }
+    size_t space() { return connected() ? 5744 : 0; }
+    size_t add(const char *data, size_t size, uint8_t apiflags = ASYNC_WRITE_FLAG_COPY);
+    bool send() { return connected(); }
+    size_t write(const char *data);
+    size_t write(const char *data, size_t size, uint8_t apiflags = ASYNC_WRITE_FLAG_COPY);
+
+    void setRxTimeout(uint32_t timeout) { rxTimeout = timeout; }
+    void setAckTimeout(uint32_t /*timeout*/) {}
+    void setNoDelay(bool /*nodelay*/) {}
+
+    void onConnect(AcConnectHandler cb, void *arg = nullptr);
+    void onDisconnect(AcConnectHandler cb, void *arg = nullptr);
+    void onData(AcDataHandler cb, void *arg = nullptr);
+    void onError(AcErrorHandler cb, void *arg = nullptr);
+    void onTimeout(AcTimeoutHandler cb, void *arg = nullptr);
+
+    const char *errorToString(int8_t error);
+
+private:
+    struct Connection;
+
+    void run(std::shared_ptr<Connection> connection, String host, uint16_t port);
+    bool current(const std::shared_ptr<Connection> &connection);
+    void finish(const std::shared_ptr<Connection> &connection);
+
+    std::shared_ptr<std::recursive_mutex> lock; // Held while callbacks run, shared with connection threads
+    std::shared_ptr<Connection> connection;
+    uint32_t rxTimeout = 0; // Seconds without data before onTimeout, 0 for never
+
+    AcConnectHandler connectCb;
+    void *connectArg = nullptr;
+    AcConnectHandler disconnectCb;
+    void *disconnectArg = nullptr;
+    AcDataHandler dataCb;
+    void *dataArg = nullptr;
+    AcErrorHandler errorCb;
+    void *errorArg = nullptr;
+    AcTimeoutHandler timeoutCb;
+    void *timeoutArg = nullptr;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <Arduino.h>
+
+// The config portal's captive DNS; never started in the native build
+class DNSServer
+{
+public:
+    bool start(uint16_t /*port*/, const String & /*domainName*/, const IPAddress & /*resolvedIP*/) { return true; }
+    void processNextRequest() {}
+    void stop() {}
+};
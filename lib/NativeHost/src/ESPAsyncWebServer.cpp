@@ -0,0 +1,155 @@
+#include "ESPAsyncWebServer.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define WEB_SERVER_READ_TIMEOUT 2000 // Milliseconds to wait for a request's headers
+#define WEB_SERVER_MAX_REQUEST 4096
+
+static const char *statusText(int code)
+{
+    switch (code)
+    {
+    case 200: return "OK";
+    case 404: return "Not Found";
+    case 500: return "Internal Server Error";
+    default: return "";
+    }
+}
+
+static void writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n <= 0)
+            return;
+        data += n;
+        size -= n;
+    }
+}
+
+void AsyncWebServerRequest::send(int code, const String &contentType, const String &content)
+{
+    if (answered)
+        return;
+    answered = true;
+    String head = "HTTP/1.1 " + String(code) + " " + statusText(code) + "\r\n";
+    if (contentType.length()) { head += "Content-Type: " + contentType + "\r\n"; }
+    head += "Content-Length: " + String((unsigned)content.length()) + "\r\nConnection: close\r\n\r\n";
+    writeAll(fd, head.c_str(), head.length());
+    writeAll(fd, content.c_str(), content.length());
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response)
+{
+    send(response->code, response->contentType, response->content);
+    delete response;
+}
+
+
+/******************/
+/* AsyncWebServer */
+/******************/
+
+void AsyncWebServer::begin()
+{
+    if (running)
+        return;
+
+    uint16_t listenPort = port;
+    const char *webPort = getenv("KEYPAD_WEB_PORT");
+    if (webPort && (port == 80)) { listenPort = (uint16_t)atoi(webPort); }
+
+    listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(listenPort);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if ((listener < 0) || (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0) || (listen(listener, 16) != 0))
+    {
+        Serial.printf("Web server can't listen on port %u\n", (unsigned)listenPort);
+        if (listener >= 0) { ::close(listener); }
+        listener = -1;
+        return;
+    }
+    Serial.printf("Web server listening on port %u\n", (unsigned)listenPort);
+
+    running = true;
+    server = std::thread(&AsyncWebServer::serve, this);
+}
+
+void AsyncWebServer::end()
+{
+    if (!running)
+        return;
+    running = false;
+    ::shutdown(listener, SHUT_RDWR);
+    if (server.joinable()) { server.join(); }
+    ::close(listener);
+    listener = -1;
+}
+
+void AsyncWebServer::serve()
+{
+    while (running)
+    {
+        struct pollfd wait = {listener, POLLIN, 0};
+        if (poll(&wait, 1, 100) != 1)
+            continue;
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0)
+            continue;
+        handle(client);
+        ::close(client);
+    }
+}
+
+// Read the request line and headers, then run the matching route. Request bodies are
+// not read, as nothing the keypad serves takes one.
+void AsyncWebServer::handle(int client)
+{
+    String head;
+    char buffer[512];
+    unsigned long started = millis();
+    while ((head.indexOf("\r\n\r\n") < 0) && (head.length() < WEB_SERVER_MAX_REQUEST) && (millis() - started < WEB_SERVER_READ_TIMEOUT))
+    {
+        struct pollfd wait = {client, POLLIN, 0};
+        if (poll(&wait, 1, 100) != 1)
+            continue;
+        ssize_t n = ::recv(client, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+            return;
+        head.concat(buffer, n);
+    }
+
+    int firstSpace = head.indexOf(' ');
+    int secondSpace = head.indexOf(' ', firstSpace + 1);
+    if ((firstSpace <= 0) || (secondSpace <= firstSpace))
+        return;
+    String methodName = head.substring(0, firstSpace);
+    String url = head.substring(firstSpace + 1, secondSpace);
+    int query = url.indexOf('?');
+    if (query >= 0) { url.remove(query); }
+    int method = (methodName == "GET") ? HTTP_GET : (methodName == "POST") ? HTTP_POST : 0;
+
+    AsyncWebServerRequest request(client, method, url);
+    for (const Route &route : routes)
+    {
+        if ((route.uri == url) && (route.method & method))
+        {
+            route.handler(&request);
+            break;
+        }
+    }
+    if (!request.sent())
+    {
+        if (notFound) { notFound(&request); }
+        request.send(404, "text/plain", "Not found");
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#define HTTP_GET 0b00000001
+#define HTTP_POST 0b00000010
+#define HTTP_ANY 0b01111111
+
+class AsyncWebServerRequest;
+
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+
+class AsyncWebServerResponse
+{
+public:
+    virtual ~AsyncWebServerResponse() {}
+    void setCode(int statusCode) { code = statusCode; }
+    void addHeader(const String & /*name*/, const String & /*value*/) {}
+
+protected:
+    friend class AsyncWebServerRequest;
+    int code = 200;
+    String contentType;
+    String content;
+};
+
+// A response printed piece by piece, sent once the handler passes it to send()
+class AsyncResponseStream : public AsyncWebServerResponse, public Print
+{
+public:
+    explicit AsyncResponseStream(const String &type) { contentType = type; }
+
+    size_t write(uint8_t c) override
+    {
+        content.concat((char)c);
+        return 1;
+    }
+
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        content.concat((const char *)buffer, size);
+        return size;
+    }
+};
+
+class AsyncWebServerRequest
+{
+public:
+    AsyncWebServerRequest(int socket, int requestMethod, const String &requestUrl)
+        : fd(socket), httpMethod(requestMethod), requestPath(requestUrl) {}
+
+    int method() const { return httpMethod; }
+    const String &url() const { return requestPath; }
+
+    void send(int code, const String &contentType = String(), const String &content = String());
+    void send(AsyncWebServerResponse *response);
+    AsyncResponseStream *beginResponseStream(const String &contentType, size_t /*bufferSize*/ = 1460)
+    {
+        return new AsyncResponseStream(contentType);
+    }
+
+    bool sent() const { return answered; }
+
+private:
+    int fd;
+    int httpMethod;
+    String requestPath;
+    bool answered = false;
+};
+
+// Serves the routes the keypad registers, one request per connection, from a thread that
+// plays the async_tcp task. The KEYPAD_WEB_PORT environment variable (--web-port) moves
+// port 80 somewhere a normal user may listen.
+class AsyncWebServer
+{
+public:
+    AsyncWebServer(uint16_t port) : port(port) {}
+    ~AsyncWebServer() { end(); }
+
+    void begin();
+    void end();
+    void on(const char *uri, int method, ArRequestHandlerFunction onRequest) { routes.push_back({String(uri), method, onRequest}); }
+    void onNotFound(ArRequestHandlerFunction fn) { notFound = fn; }
+
+private:
+    struct Route
+    {
+        String uri;
+        int method;
+        ArRequestHandlerFunction handler;
+    };
+
+    void serve();
+    void handle(int client);
+
+    uint16_t port;
+    std::vector<Route> routes;
+    ArRequestHandlerFunction notFound;
+    int listener = -1;
+    std::atomic<bool> running{false};
+    std::thread server;
+};
@@ -0,0 +1,37 @@
+#include "ESPAsync_WiFiManager.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+ESPAsync_WMParameter::ESPAsync_WMParameter(const char *id, const char * /*placeholder*/, const char *defaultValue, int length) : id(id), length(length)
+{
+    String variable = "KEYPAD_" + String(id);
+    variable.toUpperCase();
+    const char *overridden = getenv(variable.c_str());
+    value = overridden ? overridden : (defaultValue ? defaultValue : "");
+    if ((int)value.length() > length) { value.remove(length); }
+}
+
+bool ESPAsync_WiFiManager::startConfigPortal(const char *apName, const char * /*apPassword*/)
+{
+    Serial.print(F("Native config portal for "));
+    Serial.println(apName);
+    WiFi.begin(NATIVE_WIFI_SSID, NATIVE_WIFI_PASS);
+
+    // As if the form had been submitted with the values the parameters already hold
+    if (saveCallback && !parameters.empty()) { saveCallback(); }
+    return WiFi.status() == WL_CONNECTED;
+}
+
+String ESPAsync_WiFiManager::getStatus(wl_status_t status)
+{
+    switch (status)
+    {
+    case WL_IDLE_STATUS: return "WL_IDLE_STATUS";
+    case WL_NO_SSID_AVAIL: return "WL_NO_SSID_AVAIL";
+    case WL_CONNECTED: return "WL_CONNECTED";
+    case WL_CONNECT_FAILED: return "WL_CONNECT_FAILED";
+    case WL_DISCONNECTED: return "WL_DISCONNECTED";
+    default: return "UNKNOWN";
+    }
+}
@@ -0,0 +1,68 @@
+// ESPAsync_WiFiManager for the native build
+//
+// There is no access point to configure, so the portal "succeeds" at once with a network
+// called "native", and each parameter takes its value from KEYPAD_<ID> in the environment
+// (for example KEYPAD_AMPLIPIHOST=localhost:8080) or keeps its default.
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ESPAsyncWebServer.h>
+#include <DNSServer.h>
+#include <vector>
+
+#ifndef _ESPASYNC_WIFIMGR_LOGLEVEL_
+#define _ESPASYNC_WIFIMGR_LOGLEVEL_ 1
+#endif
+
+#define WM_PRINT_PREFIX "[WM] "
+#define LOGERROR(x) do { if (_ESPASYNC_WIFIMGR_LOGLEVEL_ > 0) { Serial.print(WM_PRINT_PREFIX); Serial.println(x); } } while (0)
+#define LOGERROR1(x, y) do { if (_ESPASYNC_WIFIMGR_LOGLEVEL_ > 0) { Serial.print(WM_PRINT_PREFIX); Serial.print(x); Serial.print(" "); Serial.println(y); } } while (0)
+#define LOGERROR2(x, y, z) do { if (_ESPASYNC_WIFIMGR_LOGLEVEL_ > 0) { Serial.print(WM_PRINT_PREFIX); Serial.print(x); Serial.print(" "); Serial.print(y); Serial.print(" "); Serial.println(z); } } while (0)
+#define LOGERROR3(x, y, z, w) do { if (_ESPASYNC_WIFIMGR_LOGLEVEL_ > 0) { Serial.print(WM_PRINT_PREFIX); Serial.print(x); Serial.print(" "); Serial.print(y); Serial.print(" "); Serial.print(z); Serial.print(" "); Serial.println(w); } } while (0)
+
+#define NATIVE_WIFI_SSID "native"
+#define NATIVE_WIFI_PASS "nativehost"
+
+class ESPAsync_WMParameter
+{
+public:
+    ESPAsync_WMParameter(const char *id, const char *placeholder, const char *defaultValue, int length);
+
+    const char *getID() const { return id; }
+    const char *getValue() const { return value.c_str(); }
+    int getValueLength() const { return length; }
+
+private:
+    const char *id;
+    String value;
+    int length;
+};
+
+class ESPAsync_WiFiManager
+{
+public:
+    ESPAsync_WiFiManager(AsyncWebServer * /*webserver*/, DNSServer * /*dnsserver*/, const char * /*iHostname*/ = "") {}
+
+    void setSaveConfigCallback(void (*func)()) { saveCallback = func; }
+    void addParameter(ESPAsync_WMParameter *p) { parameters.push_back(p); }
+    void setDebugOutput(bool /*debug*/) {}
+    void setMinimumSignalQuality(int /*quality*/ = 8) {}
+    void setConfigPortalChannel(int /*channel*/ = 1) {}
+    void setCORSHeader(const char * /*CORSHeaders*/) {}
+    void setConfigPortalTimeout(unsigned long /*seconds*/) {}
+    void resetSettings() {}
+
+    String WiFi_SSID() { return String(); }
+    String WiFi_Pass() { return String(); }
+
+    bool startConfigPortal(const char *apName, const char *apPassword = nullptr);
+    String getSSID(uint8_t index) { return (index == 0) ? String(NATIVE_WIFI_SSID) : String(); }
+    String getPW(uint8_t index) { return (index == 0) ? String(NATIVE_WIFI_PASS) : String(); }
+    String getStatus(wl_status_t status);
+
+private:
+    void (*saveCallback)() = nullptr;
+    std::vector<ESPAsync_WMParameter *> parameters;
+};
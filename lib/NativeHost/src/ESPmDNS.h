@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Arduino.h>
+
+// mDNS queries go to the host resolver, which answers .local names where avahi or
+// Bonjour is running
+class MDNSResponder
+{
+public:
+    bool begin(const char * /*hostName*/) { return true; }
+    void end() {}
+    IPAddress queryHost(String host, uint32_t timeout = 2000);
+};
+
+extern MDNSResponder MDNS;
@@ -0,0 +1,223 @@
+#include "FS.h"
+#include "SPIFFS.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace fs;
+
+SPIFFSFS SPIFFS;
+
+// Creates every directory leading up to the file
+static void makeParents(const String &file)
+{
+    std::string path(file.c_str());
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+    {
+        mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+}
+
+static bool isFile(const String &path)
+{
+    struct stat info;
+    return (stat(path.c_str(), &info) == 0) && S_ISREG(info.st_mode);
+}
+
+
+/********/
+/* File */
+/********/
+
+File::File(FILE *handle, const String &path) : handle(handle, fclose), path(path)
+{
+}
+
+size_t File::write(uint8_t c)
+{
+    return handle ? fwrite(&c, 1, 1, handle.get()) : 0;
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+    return handle ? fwrite(buffer, 1, size, handle.get()) : 0;
+}
+
+int File::available()
+{
+    if (!handle)
+        return 0;
+    return (int)(size() - position());
+}
+
+int File::read()
+{
+    if (!handle)
+        return -1;
+    int c = fgetc(handle.get());
+    return (c == EOF) ? -1 : c;
+}
+
+int File::peek()
+{
+    if (!handle)
+        return -1;
+    int c = fgetc(handle.get());
+    if (c == EOF)
+        return -1;
+    ungetc(c, handle.get());
+    return c;
+}
+
+void File::flush()
+{
+    if (handle) { fflush(handle.get()); }
+}
+
+size_t File::read(uint8_t *buffer, size_t size)
+{
+    return handle ? fread(buffer, 1, size, handle.get()) : 0;
+}
+
+bool File::seek(uint32_t position)
+{
+    return handle && (fseek(handle.get(), position, SEEK_SET) == 0);
+}
+
+size_t File::position() const
+{
+    if (!handle)
+        return 0;
+    long at = ftell(handle.get());
+    return (at < 0) ? 0 : (size_t)at;
+}
+
+size_t File::size() const
+{
+    if (!handle)
+        return 0;
+    fflush(handle.get());
+    struct stat info;
+    return (fstat(fileno(handle.get()), &info) == 0) ? (size_t)info.st_size : 0;
+}
+
+void File::close()
+{
+    handle.reset();
+}
+
+const char *File::name() const
+{
+    return path.c_str();
+}
+
+
+/******/
+/* FS */
+/******/
+
+FS::FS(const char *rootVariable, const char *defaultRoot) : rootVariable(rootVariable), defaultRoot(defaultRoot)
+{
+}
+
+String FS::root()
+{
+    const char *dir = getenv(rootVariable);
+    return String((dir != nullptr) ? dir : defaultRoot);
+}
+
+String FS::hostPath(const char *path)
+{
+    String written = root() + path;
+    if (isFile(written))
+        return written;
+
+    const char *data = getenv("KEYPAD_FS_DATA");
+    String shipped = String((data != nullptr) ? data : "data") + path;
+    return isFile(shipped) ? shipped : written;
+}
+
+File FS::open(const char *path, const char *mode)
+{
+    bool reading = (mode[0] == 'r') && (mode[1] != '+');
+    String file = reading ? hostPath(path) : root() + path;
+    if (!reading) { makeParents(file); }
+
+    // Binary mode so the BMPs and the WiFi credentials come back byte for byte
+    String hostMode = String(mode) + "b";
+    FILE *handle = fopen(file.c_str(), hostMode.c_str());
+    if (handle == nullptr)
+        return File();
+    return File(handle, String(path));
+}
+
+bool FS::exists(const char *path)
+{
+    return isFile(hostPath(path));
+}
+
+bool FS::remove(const char *path)
+{
+    // Files that only exist in the data folder are never deleted from it
+    return ::remove((root() + path).c_str()) == 0;
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+    String target = root() + to;
+    makeParents(target);
+    return ::rename(hostPath(from).c_str(), target.c_str()) == 0;
+}
+
+
+/**********/
+/* SPIFFS */
+/**********/
+
+bool SPIFFSFS::begin(bool /*formatOnFail*/, const char * /*basePath*/, uint8_t /*maxOpenFiles*/, const char * /*partitionLabel*/)
+{
+    String dir = root();
+    return (mkdir(dir.c_str(), 0755) == 0) || (errno == EEXIST);
+}
+
+bool SPIFFSFS::format()
+{
+    String dir = root();
+    DIR *listing = opendir(dir.c_str());
+    if (listing == nullptr)
+        return false;
+    struct dirent *entry;
+    while ((entry = readdir(listing)) != nullptr)
+    {
+        if (entry->d_type == DT_REG) { ::remove((dir + "/" + entry->d_name).c_str()); }
+    }
+    closedir(listing);
+    return true;
+}
+
+size_t SPIFFSFS::totalBytes()
+{
+    // The min_spiffs partition
+    return 0x30000;
+}
+
+size_t SPIFFSFS::usedBytes()
+{
+    String dir = root();
+    DIR *listing = opendir(dir.c_str());
+    if (listing == nullptr)
+        return 0;
+    size_t used = 0;
+    struct dirent *entry;
+    while ((entry = readdir(listing)) != nullptr)
+    {
+        struct stat info;
+        if ((entry->d_type == DT_REG) && (stat((dir + "/" + entry->d_name).c_str(), &info) == 0)) { used += info.st_size; }
+    }
+    closedir(listing);
+    return used;
+}
@@ -0,0 +1,66 @@
+// File system for the native build
+//
+// Paths live under a host directory instead of flash. Files that have never been written
+// there are read from the project's data folder, the same files "Upload Filesystem Image"
+// would have put on the device.
+
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+#include <stdio.h>
+
+namespace fs
+{
+
+class File : public Stream
+{
+public:
+    File() {}
+    File(FILE *handle, const String &path);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t read(uint8_t *buffer, size_t size);
+    bool seek(uint32_t position);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    const char *name() const;
+    operator bool() const { return handle != nullptr; }
+    using Print::write;
+
+private:
+    std::shared_ptr<FILE> handle;
+    String path;
+};
+
+class FS
+{
+public:
+    explicit FS(const char *rootVariable, const char *defaultRoot);
+
+    File open(const char *path, const char *mode = "r");
+    File open(const String &path, const char *mode = "r") { return open(path.c_str(), mode); }
+    bool exists(const char *path);
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool remove(const char *path);
+    bool remove(const String &path) { return remove(path.c_str()); }
+    bool rename(const char *from, const char *to);
+    bool rename(const String &from, const String &to) { return rename(from.c_str(), to.c_str()); }
+
+    String root();            // Directory the file system writes to
+    String hostPath(const char *path); // Where a path is on the host, falling back to the data folder
+
+protected:
+    const char *rootVariable;
+    const char *defaultRoot;
+};
+
+}
+
+using fs::File;
@@ -0,0 +1,287 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+unsigned long millis();
+
+namespace
+{
+
+struct NativeTask
+{
+    TaskFunction_t code;
+    void *parameters;
+    std::string name;
+    BaseType_t core;
+};
+
+// Thrown by vTaskDelete(nullptr) to unwind the task's thread
+struct TaskExit {};
+
+thread_local NativeTask *currentTask = nullptr;
+
+// Waits on the condition until it holds or the ticks run out. portMAX_DELAY waits forever
+template <typename Predicate>
+bool waitFor(std::condition_variable &cond, std::unique_lock<std::mutex> &lock, TickType_t ticks, Predicate ready)
+{
+    if (ticks == portMAX_DELAY)
+    {
+        cond.wait(lock, ready);
+        return true;
+    }
+    return cond.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+void taskTrampoline(NativeTask *task)
+{
+    currentTask = task;
+    try
+    {
+        task->code(task->parameters);
+    }
+    catch (const TaskExit &)
+    {
+    }
+    currentTask = nullptr;
+    delete task;
+}
+
+struct NativeQueue
+{
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+};
+
+struct NativeSemaphore
+{
+    std::mutex lock;
+    std::condition_variable changed;
+    UBaseType_t count;
+    UBaseType_t maxCount;
+};
+
+struct NativeEventGroup
+{
+    std::mutex lock;
+    std::condition_variable changed;
+    EventBits_t bits = 0;
+};
+
+}
+
+
+/*********/
+/* Tasks */
+/*********/
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t /*stackDepth*/, void *parameters, UBaseType_t /*priority*/, TaskHandle_t *created, BaseType_t coreID)
+{
+    NativeTask *task = new NativeTask{code, parameters, name ? name : "", coreID};
+    if (created != nullptr) { *created = task; }
+    std::thread(taskTrampoline, task).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stackDepth, void *parameters, UBaseType_t priority, TaskHandle_t *created)
+{
+    return xTaskCreatePinnedToCore(code, name, stackDepth, parameters, priority, created, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if ((task == nullptr) || (task == currentTask))
+        throw TaskExit();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return currentTask;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t /*task*/)
+{
+    return 0;
+}
+
+BaseType_t xPortGetCoreID()
+{
+    // Tasks report the core they asked for; setup() and loop() run on core 1 on the ESP32
+    if ((currentTask != nullptr) && (currentTask->core != tskNO_AFFINITY))
+        return currentTask->core;
+    return 1;
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)millis();
+}
+
+
+/**********/
+/* Queues */
+/**********/
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    NativeQueue *queue = new NativeQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void *item, TickType_t ticksToWait)
+{
+    NativeQueue *queue = (NativeQueue *)handle;
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitFor(queue->changed, lock, ticksToWait, [queue] { return queue->items.size() < queue->length; }))
+        return errQUEUE_FULL;
+    const uint8_t *bytes = (const uint8_t *)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void *buffer, TickType_t ticksToWait)
+{
+    NativeQueue *queue = (NativeQueue *)handle;
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitFor(queue->changed, lock, ticksToWait, [queue] { return !queue->items.empty(); }))
+        return pdFALSE;
+    memcpy(buffer, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t handle)
+{
+    NativeQueue *queue = (NativeQueue *)handle;
+    std::lock_guard<std::mutex> lock(queue->lock);
+    return (UBaseType_t)queue->items.size();
+}
+
+void vQueueDelete(QueueHandle_t handle)
+{
+    delete (NativeQueue *)handle;
+}
+
+
+/**************/
+/* Semaphores */
+/**************/
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    NativeSemaphore *semaphore = new NativeSemaphore();
+    semaphore->count = initialCount;
+    semaphore->maxCount = maxCount;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle)
+{
+    NativeSemaphore *semaphore = (NativeSemaphore *)handle;
+    std::lock_guard<std::mutex> lock(semaphore->lock);
+    if (semaphore->count >= semaphore->maxCount)
+        return pdFALSE;
+    semaphore->count++;
+    semaphore->changed.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticksToWait)
+{
+    NativeSemaphore *semaphore = (NativeSemaphore *)handle;
+    std::unique_lock<std::mutex> lock(semaphore->lock);
+    if (!waitFor(semaphore->changed, lock, ticksToWait, [semaphore] { return semaphore->count > 0; }))
+        return pdFALSE;
+    semaphore->count--;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t handle)
+{
+    delete (NativeSemaphore *)handle;
+}
+
+
+/****************/
+/* Event groups */
+/****************/
+
+EventGroupHandle_t xEventGroupCreate()
+{
+    return new NativeEventGroup();
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t handle, EventBits_t bits)
+{
+    NativeEventGroup *group = (NativeEventGroup *)handle;
+    std::lock_guard<std::mutex> lock(group->lock);
+    group->bits |= bits;
+    group->changed.notify_all();
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t handle, EventBits_t bits)
+{
+    NativeEventGroup *group = (NativeEventGroup *)handle;
+    std::lock_guard<std::mutex> lock(group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t handle)
+{
+    NativeEventGroup *group = (NativeEventGroup *)handle;
+    std::lock_guard<std::mutex> lock(group->lock);
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t handle, EventBits_t bits, BaseType_t clearOnExit, BaseType_t waitForAll, TickType_t ticksToWait)
+{
+    NativeEventGroup *group = (NativeEventGroup *)handle;
+    std::unique_lock<std::mutex> lock(group->lock);
+    waitFor(group->changed, lock, ticksToWait, [group, bits, waitForAll] {
+        return waitForAll ? ((group->bits & bits) == bits) : ((group->bits & bits) != 0);
+    });
+    EventBits_t seen = group->bits;
+    bool satisfied = waitForAll ? ((seen & bits) == bits) : ((seen & bits) != 0);
+    if (satisfied && clearOnExit) { group->bits &= ~bits; }
+    return seen;
+}
+
+void vEventGroupDelete(EventGroupHandle_t handle)
+{
+    delete (NativeEventGroup *)handle;
+}
@@ -0,0 +1,211 @@
+#include "HTTPClient.h"
+
+bool HTTPClient::begin(WiFiClient &external, String url)
+{
+    bool parsed = begin(url);
+    client = &external;
+    return parsed;
+}
+
+bool HTTPClient::begin(String url)
+{
+    end();
+    client = &ownClient;
+    requestHeaders.clear();
+    if (!url.startsWith("http://"))
+        return false;
+
+    url = url.substring(7);
+    int slash = url.indexOf('/');
+    String authority = (slash < 0) ? url : url.substring(0, slash);
+    uri = (slash < 0) ? String("/") : url.substring(slash);
+
+    int colon = authority.indexOf(':');
+    host = (colon < 0) ? authority : authority.substring(0, colon);
+    port = (colon < 0) ? 80 : (uint16_t)authority.substring(colon + 1).toInt();
+    return host.length() > 0;
+}
+
+void HTTPClient::end()
+{
+    client->stop();
+}
+
+void HTTPClient::addHeader(const String &name, const String &value, bool /*first*/, bool replace)
+{
+    for (Header &header : requestHeaders)
+    {
+        if (header.name.equalsIgnoreCase(name))
+        {
+            if (replace) { header.value = value; }
+            return;
+        }
+    }
+    requestHeaders.push_back({name, value});
+}
+
+void HTTPClient::collectHeaders(const char *headerKeys[], const size_t headerKeysCount)
+{
+    responseHeaders.clear();
+    for (size_t i = 0; i < headerKeysCount; i++) { responseHeaders.push_back({String(headerKeys[i]), String()}); }
+}
+
+String HTTPClient::header(const char *name)
+{
+    for (const Header &header : responseHeaders)
+    {
+        if (header.name.equalsIgnoreCase(name))
+            return header.value;
+    }
+    return String();
+}
+
+bool HTTPClient::hasHeader(const char *name)
+{
+    return header(name).length() > 0;
+}
+
+int HTTPClient::GET()
+{
+    return sendRequest("GET");
+}
+
+bool HTTPClient::readLine(String &line)
+{
+    line = "";
+    unsigned long start = millis();
+    while (millis() - start < readTimeout)
+    {
+        int c = client->read();
+        if (c < 0)
+        {
+            if (!client->connected())
+                return false;
+            delay(1);
+            continue;
+        }
+        if (c == '\n')
+        {
+            if (line.endsWith("\r")) { line.remove(line.length() - 1); }
+            return true;
+        }
+        line.concat((char)c);
+    }
+    return false;
+}
+
+int HTTPClient::sendRequest(const char *method, uint8_t *payload, size_t payloadSize)
+{
+    if (client == &ownClient) { client->stop(); }
+    size = -1;
+    chunked = false;
+    for (Header &header : responseHeaders) { header.value = ""; }
+
+    if (!client->connected() && !client->connect(host.c_str(), port, connectTimeout))
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    client->Stream::setTimeout(readTimeout);
+
+    String request = String(method) + " " + uri + (http10 ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n");
+    request += "Host: " + host + ((port != 80) ? ":" + String(port) : String()) + "\r\n";
+    request += "User-Agent: ESP32HTTPClient\r\n";
+    request += "Connection: close\r\n";
+    for (const Header &header : requestHeaders) { request += header.name + ": " + header.value + "\r\n"; }
+    if ((payload != nullptr) || (strcmp(method, "GET") != 0)) { request += "Content-Length: " + String((unsigned)payloadSize) + "\r\n"; }
+    request += "\r\n";
+
+    if (client->write((const uint8_t *)request.c_str(), request.length()) != request.length())
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    if ((payloadSize > 0) && (client->write(payload, payloadSize) != payloadSize))
+        return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+
+    String line;
+    if (!readLine(line))
+        return client->connected() ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+    if (!line.startsWith("HTTP/1."))
+        return HTTPC_ERROR_NO_HTTP_SERVER;
+    int code = line.substring(9, 12).toInt();
+
+    while (true)
+    {
+        if (!readLine(line))
+            return HTTPC_ERROR_CONNECTION_LOST;
+        if (line.length() == 0)
+            break;
+
+        int colon = line.indexOf(':');
+        if (colon <= 0)
+            continue;
+        String name = line.substring(0, colon);
+        String value = line.substring(colon + 1);
+        value.trim();
+
+        if (name.equalsIgnoreCase("Content-Length")) { size = value.toInt(); }
+        if (name.equalsIgnoreCase("Transfer-Encoding") && value.equalsIgnoreCase("chunked")) { chunked = true; }
+        for (Header &header : responseHeaders)
+        {
+            if (header.name.equalsIgnoreCase(name)) { header.value = value; }
+        }
+    }
+    return (code > 0) ? code : HTTPC_ERROR_NO_HTTP_SERVER;
+}
+
+String HTTPClient::getString()
+{
+    String body;
+    if (size > 0) { body.reserve(size); }
+
+    if (chunked)
+    {
+        String line;
+        while (readLine(line))
+        {
+            long chunk = strtol(line.c_str(), nullptr, 16);
+            if (chunk <= 0)
+                break;
+            std::vector<char> data(chunk);
+            if (client->readBytes(data.data(), chunk) != (size_t)chunk)
+                break;
+            body.concat(data.data(), chunk);
+            readLine(line); // CRLF after the chunk
+        }
+        return body;
+    }
+
+    char buffer[512];
+    int remaining = size;
+    while ((remaining != 0) && (client->connected() || client->available()))
+    {
+        size_t want = ((remaining < 0) || (remaining > (int)sizeof(buffer))) ? sizeof(buffer) : remaining;
+        size_t got = client->readBytes(buffer, want);
+        if (got == 0)
+            break;
+        body.concat(buffer, got);
+        if (remaining > 0) { remaining -= got; }
+    }
+    return body;
+}
+
+int HTTPClient::writeToStream(Stream *stream)
+{
+    String body = getString();
+    return (int)stream->write((const uint8_t *)body.c_str(), body.length());
+}
+
+String HTTPClient::errorToString(int error)
+{
+    switch (error)
+    {
+    case HTTPC_ERROR_CONNECTION_REFUSED: return F("connection refused");
+    case HTTPC_ERROR_SEND_HEADER_FAILED: return F("send header failed");
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return F("send payload failed");
+    case HTTPC_ERROR_NOT_CONNECTED: return F("not connected");
+    case HTTPC_ERROR_CONNECTION_LOST: return F("connection lost");
+    case HTTPC_ERROR_NO_STREAM: return F("no stream");
+    case HTTPC_ERROR_NO_HTTP_SERVER: return F("no HTTP server");
+    case HTTPC_ERROR_TOO_LESS_RAM: return F("too less ram");
+    case HTTPC_ERROR_ENCODING: return F("Transfer-Encoding not supported");
+    case HTTPC_ERROR_STREAM_WRITE: return F("Stream write error");
+    case HTTPC_ERROR_READ_TIMEOUT: return F("read Timeout");
+    default: return String();
+    }
+}
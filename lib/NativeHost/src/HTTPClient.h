@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <vector>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_STREAM (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_ENCODING (-9)
+#define HTTPC_ERROR_STREAM_WRITE (-10)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTPC_TCP_TIMEOUT 5000
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_NOT_MODIFIED 304
+#define HTTP_CODE_NOT_FOUND 404
+#define HTTP_CODE_UNSUPPORTED_MEDIA_TYPE 415
+
+// The parts of the ESP32 HTTPClient the keypad uses, over a host socket. One request per
+// connection; HTTP/1.1 chunked bodies are decoded by getString(). As on the ESP32, a
+// client given to begin() that is already connected carries the request as it is.
+class HTTPClient
+{
+public:
+    ~HTTPClient() { end(); }
+
+    bool begin(String url);
+    bool begin(WiFiClient &client, String url);
+    void end();
+
+    void setConnectTimeout(int32_t timeoutMs) { connectTimeout = timeoutMs; }
+    void setTimeout(uint16_t timeoutMs) { readTimeout = timeoutMs; }
+    void setReuse(bool /*reuse*/) {}
+    void useHTTP10(bool useHTTP10 = true) { http10 = useHTTP10; }
+
+    void addHeader(const String &name, const String &value, bool first = false, bool replace = true);
+    void collectHeaders(const char *headerKeys[], const size_t headerKeysCount);
+    String header(const char *name);
+    bool hasHeader(const char *name);
+
+    int GET();
+    int PATCH(uint8_t *payload, size_t size) { return sendRequest("PATCH", payload, size); }
+    int PATCH(String payload) { return sendRequest("PATCH", payload); }
+    int POST(uint8_t *payload, size_t size) { return sendRequest("POST", payload, size); }
+    int POST(String payload) { return sendRequest("POST", payload); }
+    int sendRequest(const char *method, String payload) { return sendRequest(method, (uint8_t *)payload.c_str(), payload.length()); }
+    int sendRequest(const char *method, uint8_t *payload = nullptr, size_t size = 0);
+
+    int getSize() { return size; }
+    String getString();
+    WiFiClient *getStreamPtr() { return connected() ? client : nullptr; }
+    WiFiClient &getStream() { return *client; }
+    bool connected() { return client->connected(); }
+    int writeToStream(Stream *stream);
+
+    static String errorToString(int error);
+
+private:
+    struct Header
+    {
+        String name;
+        String value;
+    };
+
+    bool readLine(String &line);
+
+    WiFiClient ownClient;
+    WiFiClient *client = &ownClient; // ownClient, or the one given to begin()
+    String host;
+    uint16_t port = 80;
+    String uri;
+    int32_t connectTimeout = HTTPC_TCP_TIMEOUT;
+    uint16_t readTimeout = HTTPC_TCP_TIMEOUT;
+    bool http10 = false;
+    std::vector<Header> requestHeaders;
+    std::vector<Header> responseHeaders;
+    int size = -1;
+    bool chunked = false;
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+#include "Print.h"
+
+// IPv4 address, stored in network order like the core's
+class IPAddress : public Printable
+{
+public:
+    IPAddress() : address(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d);
+    IPAddress(uint32_t networkOrder) : address(networkOrder) {}
+
+    operator uint32_t() const { return address; }
+    bool operator==(const IPAddress &other) const { return address == other.address; }
+    bool operator!=(const IPAddress &other) const { return address != other.address; }
+    uint8_t operator[](int index) const { return ((const uint8_t *)&address)[index]; }
+    uint8_t &operator[](int index) { return ((uint8_t *)&address)[index]; }
+
+    bool fromString(const char *text);
+    String toString() const;
+    size_t printTo(Print &p) const override { return p.print(toString()); }
+
+private:
+    uint32_t address;
+};
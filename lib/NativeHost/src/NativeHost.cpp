@@ -0,0 +1,306 @@
+#include "NativeHost.h"
+#include "TFT_eSPI.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+void setup();
+void loop();
+
+namespace NativeHost
+{
+
+struct Touch
+{
+    uint32_t at;
+    uint16_t x;
+    uint16_t y;
+    uint32_t held;
+    bool fromLoop; // at counts from the first loop() instead of the start
+};
+
+static TFT_eSPI *screen = nullptr;
+static std::vector<Touch> touches;
+static uint32_t loopStartedAt = 0;
+static bool looping = false;
+
+void attachDisplay(TFT_eSPI *display)
+{
+    screen = display;
+}
+
+static void put16(FILE *out, uint16_t value)
+{
+    fputc(value & 0xFF, out);
+    fputc(value >> 8, out);
+}
+
+static void put32(FILE *out, uint32_t value)
+{
+    put16(out, value & 0xFFFF);
+    put16(out, value >> 16);
+}
+
+// One row of the screen as BMP pixels: blue, green, red
+static void frameRow(int y, uint8_t *row)
+{
+    const uint16_t *frame = screen->frameBuffer();
+    for (int x = 0; x < TFT_WIDTH; x++)
+    {
+        uint16_t pixel = frame[y * TFT_WIDTH + x];
+        uint8_t r = (pixel >> 11) & 0x1F, g = (pixel >> 5) & 0x3F, b = pixel & 0x1F;
+        row[x * 3] = (b << 3) | (b >> 2);
+        row[x * 3 + 1] = (g << 2) | (g >> 4);
+        row[x * 3 + 2] = (r << 3) | (r >> 2);
+    }
+}
+
+// 24 bit BMP, bottom row first, the same format the keypad draws its icons from
+bool saveFrame(const char *path)
+{
+    if (screen == nullptr)
+        return false;
+    FILE *out = fopen(path, "wb");
+    if (out == nullptr)
+        return false;
+
+    uint32_t rowBytes = TFT_WIDTH * 3; // 720, already a multiple of 4
+    fputc('B', out);
+    fputc('M', out);
+    put32(out, 54 + rowBytes * TFT_HEIGHT);
+    put32(out, 0);
+    put32(out, 54);
+    put32(out, 40);
+    put32(out, TFT_WIDTH);
+    put32(out, TFT_HEIGHT);
+    put16(out, 1);
+    put16(out, 24);
+    put32(out, 0);
+    put32(out, rowBytes * TFT_HEIGHT);
+    put32(out, 2835);
+    put32(out, 2835);
+    put32(out, 0);
+    put32(out, 0);
+
+    uint8_t row[TFT_WIDTH * 3];
+    for (int y = TFT_HEIGHT - 1; y >= 0; y--)
+    {
+        frameRow(y, row);
+        fwrite(row, 1, sizeof(row), out);
+    }
+    bool ok = !ferror(out);
+    fclose(out);
+    return ok;
+}
+
+// Pixels that differ between the screen and a BMP written by saveFrame(), or -1 if the
+// file can't be read or isn't a whole frame
+static long compareFrame(const char *path)
+{
+    FILE *in = fopen(path, "rb");
+    if (in == nullptr)
+        return -1;
+    uint8_t header[54];
+    bool ok = (fread(header, 1, sizeof(header), in) == sizeof(header)) && (header[0] == 'B') && (header[1] == 'M');
+    int32_t w, h;
+    uint16_t depth;
+    memcpy(&w, header + 18, 4);
+    memcpy(&h, header + 22, 4);
+    memcpy(&depth, header + 28, 2);
+    if (!ok || (w != TFT_WIDTH) || (h != TFT_HEIGHT) || (depth != 24))
+    {
+        fclose(in);
+        return -1;
+    }
+
+    long differing = 0;
+    uint8_t expected[TFT_WIDTH * 3], actual[TFT_WIDTH * 3];
+    for (int y = TFT_HEIGHT - 1; y >= 0; y--)
+    {
+        if (fread(expected, 1, sizeof(expected), in) != sizeof(expected))
+        {
+            fclose(in);
+            return -1;
+        }
+        frameRow(y, actual);
+        for (int x = 0; x < TFT_WIDTH; x++)
+        {
+            if (memcmp(expected + x * 3, actual + x * 3, 3) != 0) { differing++; }
+        }
+    }
+    fclose(in);
+    return differing;
+}
+
+static const char *goldenDir = nullptr;
+static bool goldenUpdate = false;
+
+GoldenResult checkGolden(const char *name, uint32_t &differing)
+{
+    differing = 0;
+    if ((goldenDir == nullptr) || (screen == nullptr))
+        return GOLDEN_OFF;
+
+    std::string path = std::string(goldenDir) + "/" + name + ".bmp";
+    if (goldenUpdate)
+        return saveFrame(path.c_str()) ? GOLDEN_WRITTEN : GOLDEN_MISSING;
+
+    long result = compareFrame(path.c_str());
+    if (result < 0)
+        return GOLDEN_MISSING;
+    std::string actualPath = std::string(goldenDir) + "/" + name + ".actual.bmp";
+    if (result == 0)
+    {
+        remove(actualPath.c_str());
+        return GOLDEN_MATCH;
+    }
+    differing = (uint32_t)result;
+    saveFrame(actualPath.c_str());
+    return GOLDEN_DIFFERS;
+}
+
+const char *goldenResultName(GoldenResult result)
+{
+    switch (result)
+    {
+    case GOLDEN_MATCH: return "match";
+    case GOLDEN_DIFFERS: return "differs";
+    case GOLDEN_MISSING: return "missing";
+    case GOLDEN_WRITTEN: return "written";
+    default: return "off";
+    }
+}
+
+bool loadTouchScript(const char *path, bool fromLoop)
+{
+    FILE *in = fopen(path, "r");
+    if (in == nullptr)
+        return false;
+
+    char line[128];
+    while (fgets(line, sizeof(line), in))
+    {
+        char *comment = strchr(line, '#');
+        if (comment) { *comment = 0; }
+        // Lines the keypad printed while recording can be used as they are
+        const char *touch = line;
+        if (strncmp(touch, "touchrec ", 9) == 0) { touch += 9; }
+        unsigned long at, held = 100;
+        unsigned x, y;
+        int fields = sscanf(touch, "%lu %u %u %lu", &at, &x, &y, &held);
+        if (fields >= 3) { touches.push_back({(uint32_t)at, (uint16_t)x, (uint16_t)y, (uint32_t)held, fromLoop}); }
+    }
+    fclose(in);
+    return true;
+}
+
+bool touched(uint16_t &x, uint16_t &y)
+{
+    uint32_t now = millis();
+    for (const Touch &touch : touches)
+    {
+        if (touch.fromLoop && !looping)
+            continue;
+        uint32_t at = touch.fromLoop ? touch.at + loopStartedAt : touch.at;
+        if ((now >= at) && (now - at < touch.held))
+        {
+            x = touch.x;
+            y = touch.y;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void (*exitCallback)() = nullptr;
+static bool stopping = false;
+static int exitStatus = 0;
+
+void onExit(void (*callback)())
+{
+    exitCallback = callback;
+}
+
+void stop(int status)
+{
+    exitStatus = status;
+    stopping = true;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--run-ms N] [--frame out.bmp] [--touch script.txt] [--fs dir] [--amplipi host[:port]]\n"
+                    "       [--replay recording.txt] [--web-port N] [--golden dir | --update-golden dir]\n", name);
+}
+
+int run(int argc, char **argv)
+{
+    unsigned long runMs = 0;
+    const char *framePath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (value == nullptr)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "--run-ms") == 0) { runMs = strtoul(value, nullptr, 10); }
+        else if (strcmp(argv[i], "--frame") == 0) { framePath = value; }
+        else if (strcmp(argv[i], "--fs") == 0) { setenv("KEYPAD_FS_ROOT", value, 1); }
+        else if (strcmp(argv[i], "--amplipi") == 0) { setenv("KEYPAD_AMPLIPIHOST", value, 1); }
+        else if (strcmp(argv[i], "--web-port") == 0) { setenv("KEYPAD_WEB_PORT", value, 1); }
+        else if (strcmp(argv[i], "--golden") == 0) { goldenDir = value; }
+        else if (strcmp(argv[i], "--update-golden") == 0)
+        {
+            goldenDir = value;
+            goldenUpdate = true;
+        }
+        else if ((strcmp(argv[i], "--touch") == 0) || (strcmp(argv[i], "--replay") == 0))
+        {
+            if (!loadTouchScript(value, strcmp(argv[i], "--replay") == 0))
+            {
+                fprintf(stderr, "Can't read touch script %s\n", value);
+                return 2;
+            }
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+
+    const char *sleep = getenv("KEYPAD_LOOP_SLEEP_US");
+    useconds_t loopSleep = sleep ? (useconds_t)atoi(sleep) : 1000;
+
+    setup();
+    loopStartedAt = millis();
+    looping = true;
+    while (!stopping && ((runMs == 0) || (millis() < runMs)))
+    {
+        loop();
+        if (loopSleep) { usleep(loopSleep); }
+    }
+
+    if (exitCallback) { exitCallback(); }
+
+    int status = exitStatus;
+    if (framePath && !saveFrame(framePath))
+    {
+        fprintf(stderr, "Can't write frame to %s\n", framePath);
+        status = 1;
+    }
+
+    // The API and boot tasks are still running, so leave without tearing down globals
+    fflush(stdout);
+    _exit(status);
+}
+
+}
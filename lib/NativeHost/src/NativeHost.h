@@ -0,0 +1,54 @@
+// Runs the keypad firmware as a host program
+//
+//   keypad [--run-ms N] [--frame out.bmp] [--touch script.txt] [--fs dir] [--amplipi host[:port]]
+//          [--replay recording.txt] [--web-port N] [--golden dir | --update-golden dir]
+//
+// setup() runs once, then loop() until --run-ms milliseconds have passed (or forever),
+// after which the screen is written to --frame. A touch script has one touch per line,
+// "<ms since start> <x> <y> [<held ms>]", in screen coordinates; # starts a comment.
+// --replay takes the same lines, as a keypad built with TOUCH_RECORD prints them (the
+// "touchrec" prefix and the rest of a serial log are skipped), with the times counted
+// from the first loop() so they line up with when the keypad was recording.
+// --fs, --amplipi and --web-port set KEYPAD_FS_ROOT, KEYPAD_AMPLIPIHOST and KEYPAD_WEB_PORT,
+// the port the web server listens on in place of 80. --golden and
+// --update-golden pick the directory checkGolden() works in.
+
+#pragma once
+
+#include <stdint.h>
+
+class TFT_eSPI;
+
+namespace NativeHost
+{
+
+int run(int argc, char **argv);
+
+// Called once loop() has stopped, at the end of --run-ms or after stop(), before the frame is saved
+void onExit(void (*callback)());
+
+// End the run once the current setup() or loop() returns, exiting with status
+void stop(int status);
+
+// The display whose framebuffer saveFrame() writes. Set by the TFT_eSPI constructor
+void attachDisplay(TFT_eSPI *display);
+bool saveFrame(const char *path);
+
+enum GoldenResult : uint8_t
+{
+    GOLDEN_OFF,     // No --golden or --update-golden given
+    GOLDEN_MATCH,
+    GOLDEN_DIFFERS, // The screen is saved as <name>.actual.bmp next to the golden frame
+    GOLDEN_MISSING, // No readable golden frame
+    GOLDEN_WRITTEN, // --update-golden: the screen is the new golden frame
+};
+
+// Compare the screen with the golden frame <dir>/<name>.bmp, or write it with
+// --update-golden. differing is set to the number of pixels that don't match.
+GoldenResult checkGolden(const char *name, uint32_t &differing);
+const char *goldenResultName(GoldenResult result);
+
+bool loadTouchScript(const char *path, bool fromLoop = false);
+bool touched(uint16_t &x, uint16_t &y); // Where the script is touching now, if anywhere
+
+}
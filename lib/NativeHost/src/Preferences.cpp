@@ -0,0 +1,127 @@
+#include "Preferences.h"
+#include "SPIFFS.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <vector>
+
+bool Preferences::begin(const char *name, bool readOnly, const char * /*partitionLabel*/)
+{
+    String nvs = SPIFFS.root() + "/nvs";
+    dir = nvs + "/" + name;
+    this->readOnly = readOnly;
+
+    // Like NVS, a read-only open of a namespace nothing was ever written to fails
+    struct stat info;
+    if (stat(dir.c_str(), &info) != 0)
+    {
+        if (readOnly)
+            return false;
+        mkdir(SPIFFS.root().c_str(), 0755);
+        mkdir(nvs.c_str(), 0755);
+        if (mkdir(dir.c_str(), 0755) != 0)
+            return false;
+    }
+    open = true;
+    return true;
+}
+
+void Preferences::end()
+{
+    open = false;
+}
+
+String Preferences::keyPath(const char *key)
+{
+    return dir + "/" + key;
+}
+
+bool Preferences::clear()
+{
+    if (!open || readOnly)
+        return false;
+    DIR *listing = opendir(dir.c_str());
+    if (listing == nullptr)
+        return false;
+    struct dirent *entry;
+    while ((entry = readdir(listing)) != nullptr)
+    {
+        if (entry->d_type == DT_REG) { ::remove(keyPath(entry->d_name).c_str()); }
+    }
+    closedir(listing);
+    return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+    return open && !readOnly && (::remove(keyPath(key).c_str()) == 0);
+}
+
+bool Preferences::isKey(const char *key)
+{
+    struct stat info;
+    return open && (stat(keyPath(key).c_str(), &info) == 0);
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length)
+{
+    if (!open || readOnly)
+        return 0;
+    FILE *file = fopen(keyPath(key).c_str(), "wb");
+    if (file == nullptr)
+        return 0;
+    size_t written = fwrite(value, 1, length, file);
+    fclose(file);
+    return written;
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+    struct stat info;
+    if (!open || (stat(keyPath(key).c_str(), &info) != 0))
+        return 0;
+    return (size_t)info.st_size;
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t maxLength)
+{
+    // NVS refuses reads into a buffer that is too small rather than truncating them
+    size_t length = getBytesLength(key);
+    if ((length == 0) || (length > maxLength))
+        return 0;
+    FILE *file = fopen(keyPath(key).c_str(), "rb");
+    if (file == nullptr)
+        return 0;
+    size_t read = fread(buffer, 1, length, file);
+    fclose(file);
+    return read;
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value)
+{
+    return putBytes(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue)
+{
+    uint32_t value;
+    if ((getBytesLength(key) != sizeof(value)) || (getBytes(key, &value, sizeof(value)) != sizeof(value)))
+        return defaultValue;
+    return value;
+}
+
+size_t Preferences::putString(const char *key, const char *value)
+{
+    return putBytes(key, value, strlen(value));
+}
+
+String Preferences::getString(const char *key, const String &defaultValue)
+{
+    size_t length = getBytesLength(key);
+    if (!isKey(key))
+        return defaultValue;
+    std::vector<char> text(length + 1, 0);
+    getBytes(key, text.data(), length);
+    return String(text.data());
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+
+// NVS for the native build: one file per key under <SPIFFS root>/nvs/<namespace>/
+class Preferences
+{
+public:
+    bool begin(const char *name, bool readOnly = false, const char *partitionLabel = nullptr);
+    void end();
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putBytes(const char *key, const void *value, size_t length);
+    size_t getBytes(const char *key, void *buffer, size_t maxLength);
+    size_t getBytesLength(const char *key);
+    size_t putUInt(const char *key, uint32_t value);
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+    size_t putString(const char *key, const char *value);
+    size_t putString(const char *key, const String &value) { return putString(key, value.c_str()); }
+    String getString(const char *key, const String &defaultValue = String());
+
+private:
+    String keyPath(const char *key);
+
+    String dir;
+    bool open = false;
+    bool readOnly = false;
+};
@@ -0,0 +1,3 @@
+#pragma once
+
+// TFT_eSPI talks to the panel over SPI on the device; the native display is a framebuffer
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "FS.h"
+
+// SPIFFS rooted at $KEYPAD_FS_ROOT (default ./native_fs), reading unwritten files from
+// $KEYPAD_FS_DATA (default ./data)
+class SPIFFSFS : public fs::FS
+{
+public:
+    SPIFFSFS() : fs::FS("KEYPAD_FS_ROOT", "native_fs") {}
+
+    bool begin(bool formatOnFail = false, const char *basePath = "/spiffs", uint8_t maxOpenFiles = 10, const char *partitionLabel = nullptr);
+    bool format();
+    size_t totalBytes();
+    size_t usedBytes();
+    void end() {}
+};
+
+extern SPIFFSFS SPIFFS;
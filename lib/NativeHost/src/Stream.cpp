@@ -0,0 +1,43 @@
+#include "Arduino.h"
+
+int Stream::timedRead()
+{
+    unsigned long start = millis();
+    do
+    {
+        int c = read();
+        if (c >= 0)
+            return c;
+        delay(1);
+    } while (millis() - start < timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length)
+    {
+        int c = timedRead();
+        if (c < 0)
+            break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readString()
+{
+    String out;
+    int c;
+    while ((c = timedRead()) >= 0) { out.concat((char)c); }
+    return out;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    String out;
+    int c;
+    while (((c = timedRead()) >= 0) && (c != terminator)) { out.concat((char)c); }
+    return out;
+}
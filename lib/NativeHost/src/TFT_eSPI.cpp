@@ -0,0 +1,326 @@
+#include "TFT_eSPI.h"
+#include "NativeHost.h"
+
+#include <string.h>
+
+// Free font stand-ins. Only the line height matters to the block glyphs
+#define NATIVE_FONT(name, advance) const GFXfont name = {nullptr, nullptr, 0x20, 0x7E, advance}
+
+NATIVE_FONT(TomThumb, 6);
+NATIVE_FONT(FreeMono9pt7b, 18);
+NATIVE_FONT(FreeMono12pt7b, 24);
+NATIVE_FONT(FreeMono18pt7b, 35);
+NATIVE_FONT(FreeMono24pt7b, 47);
+NATIVE_FONT(FreeMonoBold9pt7b, 18);
+NATIVE_FONT(FreeMonoBold12pt7b, 24);
+NATIVE_FONT(FreeMonoBold18pt7b, 35);
+NATIVE_FONT(FreeMonoBold24pt7b, 47);
+NATIVE_FONT(FreeMonoOblique9pt7b, 18);
+NATIVE_FONT(FreeMonoOblique12pt7b, 24);
+NATIVE_FONT(FreeMonoOblique18pt7b, 35);
+NATIVE_FONT(FreeMonoOblique24pt7b, 47);
+NATIVE_FONT(FreeMonoBoldOblique9pt7b, 18);
+NATIVE_FONT(FreeMonoBoldOblique12pt7b, 24);
+NATIVE_FONT(FreeMonoBoldOblique18pt7b, 35);
+NATIVE_FONT(FreeMonoBoldOblique24pt7b, 47);
+NATIVE_FONT(FreeSans9pt7b, 22);
+NATIVE_FONT(FreeSans12pt7b, 29);
+NATIVE_FONT(FreeSans18pt7b, 42);
+NATIVE_FONT(FreeSans24pt7b, 56);
+NATIVE_FONT(FreeSansBold9pt7b, 22);
+NATIVE_FONT(FreeSansBold12pt7b, 29);
+NATIVE_FONT(FreeSansBold18pt7b, 42);
+NATIVE_FONT(FreeSansBold24pt7b, 56);
+NATIVE_FONT(FreeSansOblique9pt7b, 22);
+NATIVE_FONT(FreeSansOblique12pt7b, 29);
+NATIVE_FONT(FreeSansOblique18pt7b, 42);
+NATIVE_FONT(FreeSansOblique24pt7b, 56);
+NATIVE_FONT(FreeSansBoldOblique9pt7b, 22);
+NATIVE_FONT(FreeSansBoldOblique12pt7b, 29);
+NATIVE_FONT(FreeSansBoldOblique18pt7b, 42);
+NATIVE_FONT(FreeSansBoldOblique24pt7b, 56);
+NATIVE_FONT(FreeSerif9pt7b, 22);
+NATIVE_FONT(FreeSerif12pt7b, 29);
+NATIVE_FONT(FreeSerif18pt7b, 42);
+NATIVE_FONT(FreeSerif24pt7b, 56);
+NATIVE_FONT(FreeSerifBold9pt7b, 22);
+NATIVE_FONT(FreeSerifBold12pt7b, 29);
+NATIVE_FONT(FreeSerifBold18pt7b, 42);
+NATIVE_FONT(FreeSerifBold24pt7b, 56);
+NATIVE_FONT(FreeSerifItalic9pt7b, 22);
+NATIVE_FONT(FreeSerifItalic12pt7b, 29);
+NATIVE_FONT(FreeSerifItalic18pt7b, 42);
+NATIVE_FONT(FreeSerifItalic24pt7b, 56);
+NATIVE_FONT(FreeSerifBoldItalic9pt7b, 22);
+NATIVE_FONT(FreeSerifBoldItalic12pt7b, 29);
+NATIVE_FONT(FreeSerifBoldItalic18pt7b, 42);
+NATIVE_FONT(FreeSerifBoldItalic24pt7b, 56);
+
+TFT_eSPI::TFT_eSPI(int16_t /*w*/, int16_t /*h*/) : _width(TFT_WIDTH), _height(TFT_HEIGHT)
+{
+    memset(frame, 0, sizeof(frame));
+    NativeHost::attachDisplay(this);
+}
+
+void TFT_eSPI::setRotation(uint8_t r)
+{
+    rotation = r & 3;
+    _width = (rotation & 1) ? TFT_HEIGHT : TFT_WIDTH;
+    _height = (rotation & 1) ? TFT_WIDTH : TFT_HEIGHT;
+}
+
+
+/**********/
+/* Shapes */
+/**********/
+
+void TFT_eSPI::countWindow(uint32_t pixels)
+{
+    bus.windows++;
+    bus.pixels += pixels;
+    bus.bytes += TFT_WINDOW_BYTES + 2 * (uint64_t)pixels;
+}
+
+void TFT_eSPI::plot(int32_t x, int32_t y, uint16_t color)
+{
+    if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+        return;
+
+    // Map to the panel's own portrait orientation, as MADCTL does
+    int32_t px = x, py = y;
+    switch (rotation)
+    {
+    case 1: px = TFT_WIDTH - 1 - y; py = x; break;
+    case 2: px = TFT_WIDTH - 1 - x; py = TFT_HEIGHT - 1 - y; break;
+    case 3: px = y; py = TFT_HEIGHT - 1 - x; break;
+    }
+    frame[py * TFT_WIDTH + px] = color;
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color)
+{
+    if ((x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+        return;
+    countWindow(1);
+    plot(x, y, (uint16_t)color);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > _width) { w = _width - x; }
+    if (y + h > _height) { h = _height - y; }
+    if ((w <= 0) || (h <= 0))
+        return;
+    countWindow(w * h);
+    for (int32_t row = y; row < y + h; row++)
+    {
+        for (int32_t col = x; col < x + w; col++) { plot(col, row, (uint16_t)color); }
+    }
+}
+
+void TFT_eSPI::fillScreen(uint32_t color)
+{
+    fillRect(0, 0, _width, _height, color);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color)
+{
+    fillRect(x, y, w, 1, color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color)
+{
+    fillRect(x, y, 1, h, color);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t radius, uint32_t color)
+{
+    if (radius > w / 2) { radius = w / 2; }
+    if (radius > h / 2) { radius = h / 2; }
+    fillRect(x, y + radius, w, h - 2 * radius, color);
+    for (int32_t dy = 0; dy < radius; dy++)
+    {
+        // Inset of this row of the corner, from the circle through the corner's centre
+        int32_t fromCentre = radius - dy;
+        int32_t inset = radius;
+        while ((inset > 0) && ((radius - inset + 1) * (radius - inset + 1) + fromCentre * fromCentre <= radius * radius)) { inset--; }
+        drawFastHLine(x + inset, y + dy, w - 2 * inset, color);
+        drawFastHLine(x + inset, y + h - 1 - dy, w - 2 * inset, color);
+    }
+}
+
+void TFT_eSPI::fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color)
+{
+    for (int32_t dy = -r; dy <= r; dy++)
+    {
+        int32_t dx = 0;
+        while ((dx + 1) * (dx + 1) + dy * dy <= r * r) { dx++; }
+        drawFastHLine(x - dx, y + dy, 2 * dx + 1, color);
+    }
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data)
+{
+    // Only the part on screen goes over the bus
+    int32_t visibleW = min(x + w, (int32_t)_width) - max(x, (int32_t)0);
+    int32_t visibleH = min(y + h, (int32_t)_height) - max(y, (int32_t)0);
+    if ((visibleW <= 0) || (visibleH <= 0))
+        return;
+    countWindow(visibleW * visibleH);
+
+    for (int32_t row = 0; row < h; row++)
+    {
+        for (int32_t col = 0; col < w; col++)
+        {
+            // Without swapping, the low byte goes to the panel first and ends up high
+            uint16_t pixel = data[row * w + col];
+            plot(x + col, y + row, swapBytes ? pixel : (uint16_t)((pixel << 8) | (pixel >> 8)));
+        }
+    }
+}
+
+
+/********/
+/* Text */
+/********/
+
+void TFT_eSPI::setFreeFont(const GFXfont *f)
+{
+    gfxFont = f;
+    if (f == nullptr) { textFont = 1; }
+}
+
+void TFT_eSPI::setTextFont(uint8_t font)
+{
+    gfxFont = nullptr;
+    textFont = font;
+}
+
+int16_t TFT_eSPI::fontHeight()
+{
+    if (gfxFont)
+        return gfxFont->yAdvance;
+    switch (textFont)
+    {
+    case 2: return 16;
+    case 4: return 26;
+    case 6: return 48;
+    case 7: return 48;
+    case 8: return 75;
+    default: return 8;
+    }
+}
+
+// Height above the baseline. GLCD and the numbered fonts are drawn from the top, so for
+// them the baseline is the bottom of the character cell
+int16_t TFT_eSPI::ascent()
+{
+    return gfxFont ? (gfxFont->yAdvance * 3) / 5 : fontHeight();
+}
+
+int16_t TFT_eSPI::charWidth(char c)
+{
+    if (!gfxFont && (textFont <= 1))
+        return 6;
+    int16_t average = gfxFont ? gfxFont->yAdvance / 2 : fontHeight() / 2;
+    if (strchr(" il.,:;!|'1()[]ftjI", c))
+        return average / 2 + 1;
+    if (strchr("mwMW@%", c))
+        return (average * 3) / 2;
+    return average;
+}
+
+int16_t TFT_eSPI::textWidth(const char *string)
+{
+    int16_t width = 0;
+    for (const char *c = string; *c; c++) { width += charWidth(*c); }
+    return width;
+}
+
+// One block per character: capitals and digits reach cap height, lower case letters stop
+// short of it, and descenders hang below the baseline
+void TFT_eSPI::drawChar(char c, int32_t x, int32_t baseline)
+{
+    int16_t width = charWidth(c);
+    if ((c == ' ') || (width < 3))
+        return;
+    int16_t top = ascent();
+    if ((c >= 'a') && (c <= 'z') && !strchr("bdfhklt", c)) { top = (top * 2) / 3; }
+    int16_t below = strchr("gjpqy", c) ? ascent() / 4 : 0;
+    fillRect(x + 1, baseline - top, width - 2, top + below, textColor);
+}
+
+int16_t TFT_eSPI::drawString(const char *string, int32_t x, int32_t y)
+{
+    int16_t width = textWidth(string);
+    int16_t height = fontHeight();
+
+    int32_t left = x;
+    if ((textDatum == TC_DATUM) || (textDatum == MC_DATUM) || (textDatum == BC_DATUM) || (textDatum == C_BASELINE)) { left -= width / 2; }
+    if ((textDatum == TR_DATUM) || (textDatum == MR_DATUM) || (textDatum == BR_DATUM) || (textDatum == R_BASELINE)) { left -= width; }
+
+    int32_t baseline = y + ascent();
+    if ((textDatum == ML_DATUM) || (textDatum == MC_DATUM) || (textDatum == MR_DATUM)) { baseline = y + ascent() / 2; }
+    if ((textDatum == BL_DATUM) || (textDatum == BC_DATUM) || (textDatum == BR_DATUM)) { baseline = y - (height - ascent()); }
+    if (textDatum >= L_BASELINE) { baseline = y; }
+
+    // The numbered fonts paint their background; free fonts leave it alone
+    if (!gfxFont && (textBgColor != textColor)) { fillRect(left, baseline - ascent(), width, height, textBgColor); }
+
+    for (const char *c = string; *c; c++)
+    {
+        drawChar(*c, left, baseline);
+        left += charWidth(*c);
+    }
+    return width;
+}
+
+size_t TFT_eSPI::write(uint8_t c)
+{
+    if (c == '\r')
+        return 1;
+    if (c == '\n')
+    {
+        cursorX = 0;
+        cursorY += fontHeight();
+        return 1;
+    }
+    if (textWrapX && (cursorX + charWidth(c) > _width))
+    {
+        cursorX = 0;
+        cursorY += fontHeight();
+    }
+
+    // Free fonts print from the baseline, the others from the top of the cell
+    if (!gfxFont && (textBgColor != textColor)) { fillRect(cursorX, cursorY, charWidth(c), fontHeight(), textBgColor); }
+    drawChar((char)c, cursorX, gfxFont ? cursorY : cursorY + ascent());
+    cursorX += charWidth(c);
+    return 1;
+}
+
+
+/*********/
+/* Touch */
+/*********/
+
+void TFT_eSPI::calibrateTouch(uint16_t *data, uint32_t /*colorFG*/, uint32_t /*colorBG*/, uint8_t /*size*/)
+{
+    // An identity calibration: script coordinates are screen coordinates already
+    const uint16_t identity[5] = {0, TFT_WIDTH, 0, TFT_HEIGHT, 0};
+    memcpy(data, identity, sizeof(identity));
+}
+
+uint8_t TFT_eSPI::getTouch(uint16_t *x, uint16_t *y, uint16_t /*threshold*/)
+{
+    return NativeHost::touched(*x, *y) ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+// TFT_eSPI for the native build
+//
+// Draws into a 240x320 RGB565 framebuffer in place of the ILI9341, which NativeHost can
+// save as a BMP. Shapes and images are drawn exactly; text is drawn as solid blocks, one
+// per character, with widths and heights taken from the font size, so layouts line up
+// with the device but the words themselves aren't legible. getTouch() plays back the
+// touch script given to NativeHost.
+//
+// Every draw is also tallied as the ILI9341 would receive it over SPI: an address window
+// (CASET, RASET and RAMWR, 11 bytes) and two bytes per pixel. Counts are as exact as the
+// drawing, so text counts follow the blocks rather than the real glyphs.
+
+#pragma once
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#define TFT_WIDTH 240
+#define TFT_HEIGHT 320
+
+#define TFT_BLACK 0x0000
+#define TFT_NAVY 0x000F
+#define TFT_DARKGREEN 0x03E0
+#define TFT_DARKCYAN 0x03EF
+#define TFT_MAROON 0x7800
+#define TFT_PURPLE 0x780F
+#define TFT_OLIVE 0x7BE0
+#define TFT_LIGHTGREY 0xD69A
+#define TFT_DARKGREY 0x7BEF
+#define TFT_BLUE 0x001F
+#define TFT_GREEN 0x07E0
+#define TFT_CYAN 0x07FF
+#define TFT_RED 0xF800
+#define TFT_MAGENTA 0xF81F
+#define TFT_YELLOW 0xFFE0
+#define TFT_WHITE 0xFFFF
+#define TFT_ORANGE 0xFDA0
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define CL_DATUM 3
+#define MC_DATUM 4
+#define CC_DATUM 4
+#define MR_DATUM 5
+#define CR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+#define L_BASELINE 9
+#define C_BASELINE 10
+#define R_BASELINE 11
+
+// Same layout as Adafruit GFX fonts; the native stand-ins only fill in yAdvance
+typedef struct
+{
+    uint8_t *bitmap;
+    void *glyph;
+    uint16_t first;
+    uint16_t last;
+    uint8_t yAdvance;
+} GFXfont;
+
+#define TFT_WINDOW_BYTES 11 // CASET and RASET with their 4 byte arguments, then RAMWR
+
+// What the drawing so far would have sent to the panel
+struct TFT_BusStats
+{
+    uint32_t windows; // Address windows set, one per primitive or image
+    uint64_t pixels;  // Pixels written
+    uint64_t bytes;   // Commands, arguments and pixel data
+};
+
+class TFT_eSPI : public Print
+{
+public:
+    TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+
+    void init(uint8_t /*tc*/ = 0) {}
+    void begin(uint8_t tc = 0) { init(tc); }
+    void setRotation(uint8_t r);
+    uint8_t getRotation() { return rotation; }
+    int16_t width() { return _width; }
+    int16_t height() { return _height; }
+
+    void startWrite() {}
+    void endWrite() {}
+
+    void fillScreen(uint32_t color);
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t radius, uint32_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+
+    bool getSwapBytes() { return swapBytes; }
+    void setSwapBytes(bool swap) { swapBytes = swap; }
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data) { pushImage(x, y, w, h, (const uint16_t *)data); }
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+
+    void setTextWrap(bool wrapX, bool /*wrapY*/ = false) { textWrapX = wrapX; }
+    void setFreeFont(const GFXfont *f = nullptr);
+    void setTextFont(uint8_t font);
+    void setTextColor(uint16_t color) { textColor = textBgColor = color; }
+    void setTextColor(uint16_t fg, uint16_t bg, bool /*bgFill*/ = false) { textColor = fg; textBgColor = bg; }
+    void setTextDatum(uint8_t datum) { textDatum = datum; }
+    uint8_t getTextDatum() { return textDatum; }
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    void setCursor(int16_t x, int16_t y, uint8_t font) { setTextFont(font); setCursor(x, y); }
+    int16_t getCursorX() { return cursorX; }
+    int16_t getCursorY() { return cursorY; }
+
+    int16_t drawString(const String &string, int32_t x, int32_t y, uint8_t font) { setTextFont(font); return drawString(string.c_str(), x, y); }
+    int16_t drawString(const String &string, int32_t x, int32_t y) { return drawString(string.c_str(), x, y); }
+    int16_t drawString(const char *string, int32_t x, int32_t y, uint8_t font) { setTextFont(font); return drawString(string, x, y); }
+    int16_t drawString(const char *string, int32_t x, int32_t y);
+    int16_t textWidth(const String &string) { return textWidth(string.c_str()); }
+    int16_t textWidth(const char *string);
+    int16_t fontHeight();
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    void setTouch(uint16_t * /*data*/) {}
+    void calibrateTouch(uint16_t *data, uint32_t colorFG, uint32_t colorBG, uint8_t size);
+    uint8_t getTouch(uint16_t *x, uint16_t *y, uint16_t threshold = 600);
+
+    // Native only: the panel as the ILI9341 holds it, TFT_WIDTH x TFT_HEIGHT in portrait
+    const uint16_t *frameBuffer() const { return frame; }
+    const TFT_BusStats &busStats() const { return bus; }
+    void resetBusStats() { bus = TFT_BusStats{}; }
+
+private:
+    void plot(int32_t x, int32_t y, uint16_t color);
+    void countWindow(uint32_t pixels);
+    int16_t charWidth(char c);
+    int16_t ascent();
+    void drawChar(char c, int32_t x, int32_t baseline);
+
+    uint16_t frame[TFT_WIDTH * TFT_HEIGHT];
+    TFT_BusStats bus = {};
+    uint8_t rotation = 0;
+    int16_t _width;
+    int16_t _height;
+    bool swapBytes = false;
+
+    const GFXfont *gfxFont = nullptr;
+    uint8_t textFont = 1;
+    uint16_t textColor = TFT_WHITE;
+    uint16_t textBgColor = TFT_WHITE;
+    uint8_t textDatum = TL_DATUM;
+    bool textWrapX = true;
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+};
+
+extern const GFXfont TomThumb;
+extern const GFXfont FreeMono9pt7b, FreeMono12pt7b, FreeMono18pt7b, FreeMono24pt7b;
+extern const GFXfont FreeMonoBold9pt7b, FreeMonoBold12pt7b, FreeMonoBold18pt7b, FreeMonoBold24pt7b;
+extern const GFXfont FreeMonoOblique9pt7b, FreeMonoOblique12pt7b, FreeMonoOblique18pt7b, FreeMonoOblique24pt7b;
+extern const GFXfont FreeMonoBoldOblique9pt7b, FreeMonoBoldOblique12pt7b, FreeMonoBoldOblique18pt7b, FreeMonoBoldOblique24pt7b;
+extern const GFXfont FreeSans9pt7b, FreeSans12pt7b, FreeSans18pt7b, FreeSans24pt7b;
+extern const GFXfont FreeSansBold9pt7b, FreeSansBold12pt7b, FreeSansBold18pt7b, FreeSansBold24pt7b;
+extern const GFXfont FreeSansOblique9pt7b, FreeSansOblique12pt7b, FreeSansOblique18pt7b, FreeSansOblique24pt7b;
+extern const GFXfont FreeSansBoldOblique9pt7b, FreeSansBoldOblique12pt7b, FreeSansBoldOblique18pt7b, FreeSansBoldOblique24pt7b;
+extern const GFXfont FreeSerif9pt7b, FreeSerif12pt7b, FreeSerif18pt7b, FreeSerif24pt7b;
+extern const GFXfont FreeSerifBold9pt7b, FreeSerifBold12pt7b, FreeSerifBold18pt7b, FreeSerifBold24pt7b;
+extern const GFXfont FreeSerifItalic9pt7b, FreeSerifItalic12pt7b, FreeSerifItalic18pt7b, FreeSerifItalic24pt7b;
+extern const GFXfont FreeSerifBoldItalic9pt7b, FreeSerifBoldItalic12pt7b, FreeSerifBoldItalic18pt7b, FreeSerifBoldItalic24pt7b;
@@ -0,0 +1,192 @@
+#include "WString.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Digits of value in base, most significant first
+static std::string toBase(unsigned long long value, unsigned char base)
+{
+    if ((base < 2) || (base > 36)) { base = 10; }
+    char buf[65];
+    char *p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    do
+    {
+        unsigned digit = (unsigned)(value % base);
+        *--p = (char)((digit < 10) ? ('0' + digit) : ('A' + digit - 10));
+        value /= base;
+    } while (value);
+    return std::string(p);
+}
+
+static std::string signedToBase(long long value, unsigned char base)
+{
+    // Like the core, only base 10 gets a minus sign; other bases show the two's complement
+    if ((base == 10) && (value < 0))
+        return "-" + toBase(0ULL - (unsigned long long)value, base);
+    return toBase((unsigned long long)value, base);
+}
+
+String::String(unsigned char value, unsigned char base) : s(toBase(value, base)) {}
+String::String(int value, unsigned char base) : s((base == 10) ? signedToBase(value, base) : toBase((unsigned int)value, base)) {}
+String::String(unsigned int value, unsigned char base) : s(toBase(value, base)) {}
+String::String(long value, unsigned char base) : s((base == 10) ? signedToBase(value, base) : toBase((unsigned long)value, base)) {}
+String::String(unsigned long value, unsigned char base) : s(toBase(value, base)) {}
+String::String(long long value, unsigned char base) : s(signedToBase(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : s(toBase(value, base)) {}
+
+String::String(float value, unsigned int decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned int decimalPlaces)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+    s = buf;
+}
+
+bool String::equalsIgnoreCase(const String &str) const
+{
+    if (s.length() != str.s.length())
+        return false;
+    for (size_t i = 0; i < s.length(); i++)
+    {
+        if (tolower((unsigned char)s[i]) != tolower((unsigned char)str.s[i]))
+            return false;
+    }
+    return true;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    if (suffix.s.length() > s.length())
+        return false;
+    return s.compare(s.length() - suffix.s.length(), suffix.s.length(), suffix.s) == 0;
+}
+
+char &String::operator[](unsigned int index)
+{
+    static char dummy;
+    if (index >= s.length())
+    {
+        dummy = 0;
+        return dummy;
+    }
+    return s[index];
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const
+{
+    if ((buf == nullptr) || (bufsize == 0))
+        return;
+    if (index >= s.length())
+    {
+        buf[0] = 0;
+        return;
+    }
+    size_t n = s.length() - index;
+    if (n > bufsize - 1) { n = bufsize - 1; }
+    memcpy(buf, s.data() + index, n);
+    buf[n] = 0;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const
+{
+    if (beginIndex > endIndex)
+    {
+        unsigned int swap = beginIndex;
+        beginIndex = endIndex;
+        endIndex = swap;
+    }
+    String out;
+    if (beginIndex >= s.length())
+        return out;
+    if (endIndex > s.length()) { endIndex = (unsigned int)s.length(); }
+    out.s.assign(s, beginIndex, endIndex - beginIndex);
+    return out;
+}
+
+void String::replace(char find, char replace)
+{
+    for (char &c : s)
+    {
+        if (c == find) { c = replace; }
+    }
+}
+
+void String::replace(const String &find, const String &replace)
+{
+    if (find.s.empty())
+        return;
+    size_t pos = 0;
+    while ((pos = s.find(find.s, pos)) != std::string::npos)
+    {
+        s.replace(pos, find.s.length(), replace.s);
+        pos += replace.s.length();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+    if (index >= s.length())
+        return;
+    s.erase(index, count);
+}
+
+void String::toLowerCase()
+{
+    for (char &c : s) { c = (char)tolower((unsigned char)c); }
+}
+
+void String::toUpperCase()
+{
+    for (char &c : s) { c = (char)toupper((unsigned char)c); }
+}
+
+void String::trim()
+{
+    size_t first = 0;
+    while ((first < s.length()) && isspace((unsigned char)s[first])) { ++first; }
+    size_t last = s.length();
+    while ((last > first) && isspace((unsigned char)s[last - 1])) { --last; }
+    s = s.substr(first, last - first);
+}
+
+long String::toInt() const
+{
+    return atol(s.c_str());
+}
+
+double String::toDouble() const
+{
+    return atof(s.c_str());
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const char *lhs, const String &rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, char rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
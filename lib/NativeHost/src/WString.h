@@ -0,0 +1,150 @@
+// Arduino String for the native build, kept on a std::string
+//
+// Only the parts of the ESP32 core's String the keypad and ArduinoJson use. Like the
+// core, a String may hold zero bytes when built with concat(const char *, length).
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class __FlashStringHelper;
+
+class String
+{
+public:
+    String(const char *cstr = "") : s(cstr ? cstr : "") {}
+    String(const String &str) = default;
+    String(String &&str) = default;
+    String(const __FlashStringHelper *str) : s(reinterpret_cast<const char *>(str)) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+    String(long long value, unsigned char base = 10);
+    String(unsigned long long value, unsigned char base = 10);
+    String(float value, unsigned int decimalPlaces = 2);
+    String(double value, unsigned int decimalPlaces = 2);
+
+    String &operator=(const String &rhs) = default;
+    String &operator=(String &&rhs) = default;
+    String &operator=(const char *cstr)
+    {
+        s = cstr ? cstr : "";
+        return *this;
+    }
+
+    bool reserve(unsigned int size)
+    {
+        s.reserve(size);
+        return true;
+    }
+    unsigned int length() const { return (unsigned int)s.length(); }
+    bool isEmpty() const { return s.empty(); }
+    void clear() { s.clear(); }
+
+    bool concat(const String &str)
+    {
+        s += str.s;
+        return true;
+    }
+    bool concat(const char *cstr)
+    {
+        if (cstr == nullptr)
+            return false;
+        s += cstr;
+        return true;
+    }
+    bool concat(const char *cstr, unsigned int length)
+    {
+        if (cstr == nullptr)
+            return false;
+        s.append(cstr, length);
+        return true;
+    }
+    bool concat(char c)
+    {
+        s += c;
+        return true;
+    }
+    bool concat(int value) { return concat(String(value)); }
+    bool concat(unsigned int value) { return concat(String(value)); }
+    bool concat(long value) { return concat(String(value)); }
+    bool concat(unsigned long value) { return concat(String(value)); }
+    bool concat(float value) { return concat(String(value)); }
+    bool concat(double value) { return concat(String(value)); }
+
+    template <typename T>
+    String &operator+=(const T &rhs)
+    {
+        concat(rhs);
+        return *this;
+    }
+
+    int compareTo(const String &str) const { return s.compare(str.s); }
+    bool equals(const String &str) const { return s == str.s; }
+    bool equals(const char *cstr) const { return s == (cstr ? cstr : ""); }
+    bool equalsIgnoreCase(const String &str) const;
+    bool operator==(const String &rhs) const { return equals(rhs); }
+    bool operator==(const char *cstr) const { return equals(cstr); }
+    bool operator!=(const String &rhs) const { return !equals(rhs); }
+    bool operator!=(const char *cstr) const { return !equals(cstr); }
+    bool operator<(const String &rhs) const { return compareTo(rhs) < 0; }
+    bool operator>(const String &rhs) const { return compareTo(rhs) > 0; }
+    bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.length(), prefix.s) == 0; }
+    bool endsWith(const String &suffix) const;
+
+    char charAt(unsigned int index) const { return (index < s.length()) ? s[index] : 0; }
+    void setCharAt(unsigned int index, char c)
+    {
+        if (index < s.length())
+            s[index] = c;
+    }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index);
+    void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+    void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const { getBytes((unsigned char *)buf, bufsize, index); }
+    const char *c_str() const { return s.c_str(); }
+    char *begin() { return &s[0]; }
+    char *end() { return &s[0] + s.length(); }
+
+    int indexOf(char ch, unsigned int fromIndex = 0) const { return found(s.find(ch, fromIndex)); }
+    int indexOf(const String &str, unsigned int fromIndex = 0) const { return found(s.find(str.s, fromIndex)); }
+    int lastIndexOf(char ch) const { return found(s.rfind(ch)); }
+    int lastIndexOf(const String &str) const { return found(s.rfind(str.s)); }
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, length()); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void replace(char find, char replace);
+    void replace(const String &find, const String &replace);
+    void remove(unsigned int index) { remove(index, length()); }
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const { return (float)toDouble(); }
+    double toDouble() const;
+
+private:
+    static int found(size_t pos) { return (pos == std::string::npos) ? -1 : (int)pos; }
+
+    std::string s;
+};
+
+// Named so ArduinoJson recognizes the result of a String concatenation, as on the device
+class StringSumHelper : public String
+{
+public:
+    StringSumHelper(const String &s) : String(s) {}
+    StringSumHelper(const char *p) : String(p) {}
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+String operator+(const String &lhs, char rhs);
@@ -0,0 +1,234 @@
+#include "WiFi.h"
+#include "WiFiMulti.h"
+#include "ESPmDNS.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <string.h>
+
+WiFiClass WiFi;
+MDNSResponder MDNS;
+
+static uint8_t nativeBSSID[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+
+/********/
+/* WiFi */
+/********/
+
+wl_status_t WiFiClass::begin(const char *ssid, const char * /*passphrase*/, int32_t channel, const uint8_t * /*bssid*/, bool /*connect*/)
+{
+    {
+        std::lock_guard<std::recursive_mutex> guard(lock);
+        this->ssid = ssid ? ssid : "";
+        if (channel > 0) { linkChannel = channel; }
+        if (!linkAvailable)
+        {
+            linkStatus = WL_NO_SSID_AVAIL;
+            return linkStatus;
+        }
+        linkStatus = WL_CONNECTED;
+    }
+    raise(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    return WL_CONNECTED;
+}
+
+bool WiFiClass::config(IPAddress /*local*/, IPAddress /*gateway*/, IPAddress /*subnet*/, IPAddress /*dns1*/, IPAddress /*dns2*/)
+{
+    // The host keeps its own addressing
+    return true;
+}
+
+bool WiFiClass::disconnect(bool /*wifiOff*/, bool /*eraseAP*/)
+{
+    bool wasConnected;
+    {
+        std::lock_guard<std::recursive_mutex> guard(lock);
+        wasConnected = (linkStatus == WL_CONNECTED);
+        linkStatus = WL_DISCONNECTED;
+    }
+    if (wasConnected)
+    {
+        raise(ARDUINO_EVENT_WIFI_STA_LOST_IP);
+        raise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+    }
+    return true;
+}
+
+bool WiFiClass::reconnect()
+{
+    return begin(ssid.c_str()) == WL_CONNECTED;
+}
+
+bool WiFiClass::mode(wifi_mode_t /*mode*/)
+{
+    return true;
+}
+
+wl_status_t WiFiClass::status()
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    return linkStatus;
+}
+
+String WiFiClass::SSID()
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    return (linkStatus == WL_CONNECTED) ? ssid : String();
+}
+
+int8_t WiFiClass::RSSI()
+{
+    return (status() == WL_CONNECTED) ? -55 : 0;
+}
+
+int32_t WiFiClass::channel()
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    return linkChannel;
+}
+
+uint8_t *WiFiClass::BSSID()
+{
+    return nativeBSSID;
+}
+
+String WiFiClass::BSSIDstr()
+{
+    char text[18];
+    snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X", nativeBSSID[0], nativeBSSID[1], nativeBSSID[2], nativeBSSID[3], nativeBSSID[4], nativeBSSID[5]);
+    return String(text);
+}
+
+String WiFiClass::macAddress()
+{
+    uint64_t mac = ESP.getEfuseMac();
+    char text[18];
+    snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X",
+             (unsigned)(mac & 0xFF), (unsigned)((mac >> 8) & 0xFF), (unsigned)((mac >> 16) & 0xFF),
+             (unsigned)((mac >> 24) & 0xFF), (unsigned)((mac >> 32) & 0xFF), (unsigned)((mac >> 40) & 0xFF));
+    return String(text);
+}
+
+IPAddress WiFiClass::localIP()
+{
+    return (status() == WL_CONNECTED) ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+IPAddress WiFiClass::gatewayIP()
+{
+    return (status() == WL_CONNECTED) ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+IPAddress WiFiClass::subnetMask()
+{
+    return (status() == WL_CONNECTED) ? IPAddress(255, 0, 0, 0) : IPAddress();
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t /*index*/)
+{
+    return (status() == WL_CONNECTED) ? IPAddress(127, 0, 0, 53) : IPAddress();
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventCb callback, arduino_event_id_t event)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    handlers.push_back({callback, nullptr, event});
+    return (wifi_event_id_t)handlers.size();
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb callback, arduino_event_id_t event)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    handlers.push_back({nullptr, callback, event});
+    return (wifi_event_id_t)handlers.size();
+}
+
+void WiFiClass::raise(arduino_event_id_t event, uint8_t reason)
+{
+    std::vector<Handler> listeners;
+    {
+        std::lock_guard<std::recursive_mutex> guard(lock);
+        listeners = handlers;
+    }
+
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.wifi_sta_disconnected.reason = reason;
+    for (const Handler &handler : listeners)
+    {
+        if ((handler.event != ARDUINO_EVENT_MAX) && (handler.event != event))
+            continue;
+        if (handler.plain != nullptr) { handler.plain(event); }
+        if (handler.withInfo != nullptr) { handler.withInfo(event, info); }
+    }
+}
+
+void WiFiClass::setLinkUp(bool up)
+{
+    bool wasConnected;
+    {
+        std::lock_guard<std::recursive_mutex> guard(lock);
+        linkAvailable = up;
+        wasConnected = (linkStatus == WL_CONNECTED);
+        if (!up) { linkStatus = WL_CONNECTION_LOST; }
+    }
+    if (!up && wasConnected)
+    {
+        raise(ARDUINO_EVENT_WIFI_STA_LOST_IP);
+        raise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_BEACON_TIMEOUT);
+    }
+}
+
+int WiFiClass::hostByName(const char *host, IPAddress &result)
+{
+    if (result.fromString(host))
+        return 1;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *found = nullptr;
+    if ((getaddrinfo(host, nullptr, &hints, &found) != 0) || (found == nullptr))
+    {
+        result = IPAddress();
+        return 0;
+    }
+    result = IPAddress((uint32_t)((struct sockaddr_in *)found->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(found);
+    return 1;
+}
+
+
+/*************/
+/* WiFiMulti */
+/*************/
+
+bool WiFiMulti::addAP(const char *ssid, const char * /*passphrase*/)
+{
+    ssids.push_back(String(ssid));
+    return true;
+}
+
+uint8_t WiFiMulti::run(uint32_t /*connectTimeout*/)
+{
+    if (WiFi.status() == WL_CONNECTED)
+        return WL_CONNECTED;
+    if (ssids.empty())
+        return WL_NO_SSID_AVAIL;
+    return WiFi.begin(ssids.front().c_str());
+}
+
+
+/********/
+/* mDNS */
+/********/
+
+IPAddress MDNSResponder::queryHost(String host, uint32_t /*timeout*/)
+{
+    IPAddress found;
+    WiFi.hostByName((host + ".local").c_str(), found);
+    return found;
+}
@@ -0,0 +1,119 @@
+// WiFi for the native build
+//
+// The host's own network stands in for the access point. begin() connects straight away
+// and raises the same events the ESP32 does; WiFi.setLinkUp() can take the link
+// down and bring it back to exercise the reconnect paths.
+
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "esp_wifi.h"
+
+typedef enum
+{
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA,
+    WIFI_AP,
+    WIFI_AP_STA
+} wifi_mode_t;
+
+typedef enum
+{
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef struct
+{
+    uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+typedef union
+{
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+typedef arduino_event_info_t WiFiEventInfo_t;
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+typedef void (*WiFiEventFuncCb)(arduino_event_id_t event, arduino_event_info_t info);
+typedef int wifi_event_id_t;
+
+#define WIFI_REASON_ASSOC_LEAVE 8
+#define WIFI_REASON_BEACON_TIMEOUT 200
+
+class WiFiClass
+{
+public:
+    wl_status_t begin(const char *ssid, const char *passphrase = nullptr, int32_t channel = 0, const uint8_t *bssid = nullptr, bool connect = true);
+    bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = (uint32_t)0, IPAddress dns2 = (uint32_t)0);
+    bool disconnect(bool wifiOff = false, bool eraseAP = false);
+    bool reconnect();
+    bool mode(wifi_mode_t mode);
+    bool setAutoReconnect(bool /*autoReconnect*/) { return true; }
+    bool persistent(bool /*persistent*/) { return true; }
+    bool setSleep(bool /*enabled*/) { return true; }
+    bool setHostname(const char * /*hostname*/) { return true; }
+
+    wl_status_t status();
+    String SSID();
+    int8_t RSSI();
+    int32_t channel();
+    uint8_t *BSSID();
+    String BSSIDstr();
+    String macAddress();
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+
+    wifi_event_id_t onEvent(WiFiEventCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    wifi_event_id_t onEvent(WiFiEventFuncCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+
+    int hostByName(const char *host, IPAddress &result);
+
+    // Native only: take the link down (as if the access point vanished) or bring it back
+    void setLinkUp(bool up);
+
+private:
+    struct Handler
+    {
+        WiFiEventCb plain;
+        WiFiEventFuncCb withInfo;
+        arduino_event_id_t event;
+    };
+
+    void raise(arduino_event_id_t event, uint8_t reason = 0);
+
+    std::recursive_mutex lock;
+    std::vector<Handler> handlers;
+    wl_status_t linkStatus = WL_IDLE_STATUS;
+    bool linkAvailable = true;
+    String ssid;
+    int32_t linkChannel = 6;
+};
+
+extern WiFiClass WiFi;
+
+#include "WiFiClient.h"
@@ -0,0 +1,170 @@
+#include "WiFiClient.h"
+#include "WiFi.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define WIFI_CLIENT_CONNECT_TIMEOUT 3000
+
+struct WiFiClient::Socket
+{
+    int fd;
+    bool peerClosed = false;
+
+    explicit Socket(int fd) : fd(fd) {}
+    ~Socket() { ::close(fd); }
+};
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+    return connect(ip, port, WIFI_CLIENT_CONNECT_TIMEOUT);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs)
+{
+    stop();
+    if (WiFi.status() != WL_CONNECTED)
+        return 0;
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return 0;
+
+    // Connect without blocking so the timeout applies, then stay non-blocking for reads
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    if ((::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) && (errno != EINPROGRESS))
+    {
+        ::close(fd);
+        return 0;
+    }
+
+    struct pollfd wait = {fd, POLLOUT, 0};
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if ((poll(&wait, 1, timeoutMs) != 1) || (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0) || (error != 0))
+    {
+        ::close(fd);
+        return 0;
+    }
+
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    socket = std::make_shared<Socket>(fd);
+    return 1;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+    return connect(host, port, WIFI_CLIENT_CONNECT_TIMEOUT);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port, int32_t timeoutMs)
+{
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip))
+        return 0;
+    return connect(ip, port, timeoutMs);
+}
+
+uint8_t WiFiClient::connected()
+{
+    if (!socket)
+        return 0;
+    if (socket->peerClosed)
+        return available() > 0;
+
+    // Peek to notice the peer closing; buffered data still counts as connected
+    uint8_t probe;
+    ssize_t result = recv(socket->fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (result > 0)
+        return 1;
+    if ((result == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK)))
+    {
+        socket->peerClosed = true;
+        return 0;
+    }
+    return 1;
+}
+
+void WiFiClient::stop()
+{
+    socket.reset();
+}
+
+size_t WiFiClient::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size)
+{
+    if (!socket)
+        return 0;
+    size_t sent = 0;
+    while (sent < size)
+    {
+        ssize_t n = send(socket->fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+        if (n > 0)
+        {
+            sent += n;
+            continue;
+        }
+        if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            struct pollfd wait = {socket->fd, POLLOUT, 0};
+            if (poll(&wait, 1, (int)getTimeout()) == 1)
+                continue;
+        }
+        break;
+    }
+    return sent;
+}
+
+int WiFiClient::available()
+{
+    if (!socket)
+        return 0;
+    int pending = 0;
+    if (ioctl(socket->fd, FIONREAD, &pending) != 0)
+        return 0;
+    return pending;
+}
+
+int WiFiClient::read()
+{
+    uint8_t c;
+    return (read(&c, 1) == 1) ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size)
+{
+    if (!socket)
+        return -1;
+    ssize_t n = recv(socket->fd, buffer, size, MSG_DONTWAIT);
+    if (n == 0) { socket->peerClosed = true; }
+    return (n > 0) ? (int)n : -1;
+}
+
+int WiFiClient::peek()
+{
+    if (!socket)
+        return -1;
+    uint8_t c;
+    return (recv(socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1) ? c : -1;
+}
+
+int WiFiClient::setTimeout(uint32_t seconds)
+{
+    Stream::setTimeout(seconds * 1000);
+    return 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+#include "Client.h"
+
+// TCP client on a host socket. Copies share the connection, as on the ESP32
+class WiFiClient : public Client
+{
+public:
+    WiFiClient() {}
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs);
+    int connect(const char *host, uint16_t port) override;
+    int connect(const char *host, uint16_t port, int32_t timeoutMs);
+    uint8_t connected() override;
+    void stop() override;
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buffer, size_t size);
+    int peek() override;
+    void flush() override {}
+    int setTimeout(uint32_t seconds);
+
+    operator bool() { return connected(); }
+    using Print::write;
+
+private:
+    struct Socket;
+    std::shared_ptr<Socket> socket;
+};
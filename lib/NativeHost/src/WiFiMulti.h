@@ -0,0 +1,13 @@
+#pragma once
+
+#include <WiFi.h>
+
+class WiFiMulti
+{
+public:
+    bool addAP(const char *ssid, const char *passphrase = nullptr);
+    uint8_t run(uint32_t connectTimeout = 5000);
+
+private:
+    std::vector<String> ssids;
+};
@@ -0,0 +1,34 @@
+// FreeRTOS for the native build
+//
+// Tasks are threads, queues and semaphores are a mutex plus a condition variable, and a
+// tick is a millisecond. Task priorities and stack sizes are accepted and ignored.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef void *EventGroupHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t EventBits_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_FULL 0
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define tskIDLE_PRIORITY 0
+#define configMAX_PRIORITIES 25
+
+BaseType_t xPortGetCoreID();
+TickType_t xTaskGetTickCount();
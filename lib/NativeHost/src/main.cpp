@@ -0,0 +1,6 @@
+#include "NativeHost.h"
+
+int main(int argc, char **argv)
+{
+    return NativeHost::run(argc, argv);
+}
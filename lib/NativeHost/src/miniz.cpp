@@ -0,0 +1,72 @@
+#include "rom/miniz.h"
+
+#include <string.h>
+
+// Bump allocator over the decompressor's arena; everything goes when tinfl_init resets it
+static voidpf arenaAlloc(voidpf opaque, uInt items, uInt size)
+{
+    tinfl_decompressor *r = (tinfl_decompressor *)opaque;
+    size_t bytes = ((size_t)items * size + 15) & ~(size_t)15;
+    if (r->m_used + bytes > sizeof(r->m_arena))
+        return Z_NULL;
+    voidpf block = r->m_arena + r->m_used;
+    r->m_used += bytes;
+    return block;
+}
+
+static void arenaFree(voidpf /*opaque*/, voidpf /*address*/)
+{
+}
+
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const mz_uint8 *pIn_buf_next, size_t *pIn_buf_size, mz_uint8 * /*pOut_buf_start*/, mz_uint8 *pOut_buf_next, size_t *pOut_buf_size, const mz_uint32 decomp_flags)
+{
+    if (r->m_state == 0)
+    {
+        memset(&r->m_stream, 0, sizeof(r->m_stream));
+        r->m_used = 0;
+        r->m_num_bits = 0;
+        r->m_bit_buf = 0;
+        r->m_stream.zalloc = arenaAlloc;
+        r->m_stream.zfree = arenaFree;
+        r->m_stream.opaque = r;
+        int windowBits = (decomp_flags & TINFL_FLAG_PARSE_ZLIB_HEADER) ? MAX_WBITS : -MAX_WBITS;
+        if (inflateInit2(&r->m_stream, windowBits) != Z_OK)
+        {
+            *pIn_buf_size = 0;
+            *pOut_buf_size = 0;
+            return TINFL_STATUS_BAD_PARAM;
+        }
+        r->m_state = 1;
+    }
+
+    size_t inSize = *pIn_buf_size;
+    size_t outSize = *pOut_buf_size;
+    r->m_stream.next_in = (Bytef *)pIn_buf_next;
+    r->m_stream.avail_in = (uInt)inSize;
+    r->m_stream.next_out = pOut_buf_next;
+    r->m_stream.avail_out = (uInt)outSize;
+
+    int result = inflate(&r->m_stream, Z_SYNC_FLUSH);
+    *pIn_buf_size = inSize - r->m_stream.avail_in;
+    *pOut_buf_size = outSize - r->m_stream.avail_out;
+
+    if (result == Z_STREAM_END)
+    {
+        // Read ahead as the ROM does, taking whatever follows the stream into the bit buffer
+        while ((r->m_stream.avail_in > 0) && (r->m_num_bits < TINFL_BITBUF_SIZE))
+        {
+            r->m_bit_buf |= (tinfl_bit_buf_t)*r->m_stream.next_in++ << r->m_num_bits;
+            r->m_stream.avail_in--;
+            r->m_num_bits += 8;
+        }
+        *pIn_buf_size = inSize - r->m_stream.avail_in;
+        return TINFL_STATUS_DONE;
+    }
+    if ((result != Z_OK) && (result != Z_BUF_ERROR))
+        return TINFL_STATUS_FAILED;
+    if (r->m_stream.avail_out == 0)
+        return TINFL_STATUS_HAS_MORE_OUTPUT;
+    if (decomp_flags & TINFL_FLAG_HAS_MORE_INPUT)
+        return TINFL_STATUS_NEEDS_MORE_INPUT;
+    return TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS;
+}
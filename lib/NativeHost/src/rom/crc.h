@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Little-endian CRC-32, as in the ESP32 ROM. Backed by zlib's crc32 on the host
+uint32_t crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
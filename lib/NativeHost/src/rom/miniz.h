@@ -0,0 +1,54 @@
+// The ESP32 ROM's tinfl inflater, for the native build
+//
+// Backed by zlib's raw inflate. zlib allocates from an arena inside the decompressor, so
+// a decompressor that is simply freed part way through a stream leaks nothing, just as
+// with the ROM version. zlib stops at the end of the deflate stream, but the ROM reads
+// ahead into its bit buffer, so at the end this takes the next few bytes into m_bit_buf
+// as the ROM would.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zlib.h>
+
+typedef unsigned char mz_uint8;
+typedef uint32_t mz_uint32;
+
+enum
+{
+    TINFL_FLAG_PARSE_ZLIB_HEADER = 1,
+    TINFL_FLAG_HAS_MORE_INPUT = 2,
+    TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF = 4,
+    TINFL_FLAG_COMPUTE_ADLER32 = 8
+};
+
+typedef enum
+{
+    TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS = -4,
+    TINFL_STATUS_BAD_PARAM = -3,
+    TINFL_STATUS_ADLER32_MISMATCH = -2,
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2
+} tinfl_status;
+
+#define TINFL_LZ_DICT_SIZE 32768
+#define TINFL_BITBUF_SIZE 32
+typedef mz_uint32 tinfl_bit_buf_t;
+#define TINFL_NATIVE_ARENA (48 * 1024) // zlib's inflate state and its own 32 KB window
+
+typedef struct
+{
+    mz_uint32 m_state; // 0 until the first call sets up m_stream
+    mz_uint32 m_num_bits;
+    tinfl_bit_buf_t m_bit_buf; // Bytes read past the end of the stream, first in the low bits
+    z_stream m_stream;
+    size_t m_used;
+    alignas(16) unsigned char m_arena[TINFL_NATIVE_ARENA];
+} tinfl_decompressor;
+
+#define tinfl_init(r) do { (r)->m_state = 0; } while (0)
+
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const mz_uint8 *pIn_buf_next, size_t *pIn_buf_size, mz_uint8 *pOut_buf_start, mz_uint8 *pOut_buf_next, size_t *pOut_buf_size, const mz_uint32 decomp_flags);
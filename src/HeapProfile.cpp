@@ -0,0 +1,167 @@
+// Allocation counting for the heap profile (include/HeapProfile.h) and the benchmarks
+// (bench/Bench.h). Builds with HEAP_PROFILE link with
+// -Wl,--wrap=malloc,--wrap=free,--wrap=calloc,--wrap=realloc so every allocation in the
+// program comes through here on its way to the real allocator.
+
+#include <HeapProfile.h>
+
+#if HEAP_PROFILE
+
+#include <atomic>
+#include <new>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_heap_caps.h>
+#define allocatedSize(ptr) heap_caps_get_allocated_size(ptr)
+#else
+#include <malloc.h>
+#define allocatedSize(ptr) malloc_usable_size(ptr)
+#endif
+
+extern "C"
+{
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+}
+
+thread_local HeapSubsystem heapSubsystem = HEAP_OTHER;
+
+struct SubsystemCounters
+{
+    std::atomic<uint32_t> allocs;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint32_t> failures;
+};
+
+static SubsystemCounters subsystems[HEAP_SUBSYSTEMS];
+static std::atomic<uint32_t> allocs(0);
+static std::atomic<uint64_t> bytes(0);
+static std::atomic<uint32_t> frees(0);
+static std::atomic<int64_t> live(0);
+static std::atomic<int64_t> peak(0);
+
+static void counted(void *ptr, size_t requested)
+{
+    SubsystemCounters &counters = subsystems[heapSubsystem];
+    if (ptr == nullptr)
+    {
+        if (requested) { counters.failures.fetch_add(1, std::memory_order_relaxed); }
+        return;
+    }
+    int64_t size = allocatedSize(ptr);
+    counters.allocs.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    int64_t now = live.fetch_add(size, std::memory_order_relaxed) + size;
+    int64_t high = peak.load(std::memory_order_relaxed);
+    while ((now > high) && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed)) {}
+}
+
+// Blocks from heap_caps_malloc() come through here without having been counted, which is
+// why live isn't reported on the ESP32. See include/HeapProfile.h.
+static void released(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+    frees.fetch_add(1, std::memory_order_relaxed);
+    live.fetch_sub(allocatedSize(ptr), std::memory_order_relaxed);
+}
+
+extern "C"
+{
+void *__wrap_malloc(size_t size)
+{
+    void *ptr = __real_malloc(size);
+    counted(ptr, size);
+    return ptr;
+}
+
+void __wrap_free(void *ptr)
+{
+    released(ptr);
+    __real_free(ptr);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    void *ptr = __real_calloc(n, size);
+    counted(ptr, n * size);
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    // A failed realloc leaves the old block where it was, so only count it out on success
+    size_t before = ptr ? allocatedSize(ptr) : 0;
+    void *moved = __real_realloc(ptr, size);
+    if (moved != nullptr)
+    {
+        if (ptr != nullptr)
+        {
+            frees.fetch_add(1, std::memory_order_relaxed);
+            live.fetch_sub(before, std::memory_order_relaxed);
+        }
+        counted(moved, size);
+    }
+    else if (size) { counted(nullptr, size); }
+    return moved;
+}
+}
+
+#if !defined(ARDUINO_ARCH_ESP32)
+// The host's libstdc++ is a shared library, out of reach of --wrap, so send new and delete
+// through the wrapped malloc as the ESP32's static libstdc++ already does
+void *operator new(size_t size)
+{
+    void *ptr = malloc(size ? size : 1);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+#endif
+
+HeapSubsystemStats heapSubsystemStats(HeapSubsystem subsystem)
+{
+    const SubsystemCounters &counters = subsystems[subsystem];
+    return {counters.allocs.load(), counters.bytes.load(), counters.failures.load()};
+}
+
+HeapTotals heapTotals()
+{
+    return {allocs.load(), bytes.load(), frees.load(), live.load(), peak.load()};
+}
+
+void heapResetPeak()
+{
+    peak.store(live.load());
+}
+
+#endif
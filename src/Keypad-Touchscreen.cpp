@@ -3,30 +3,84 @@
 
 #include <Arduino.h>
 #include <stdint.h>
+#include <atomic>
 #include "FS.h"
 #include "SPIFFS.h"
 #include <Free_Fonts.h>
 #include <esp_wifi.h>
 #include <WiFi.h>
 #include <WiFiClient.h>
-#include <WiFiMulti.h>
-WiFiMulti wifiMulti;
 
 #include <SPI.h>
 #include <TFT_eSPI.h> // Hardware-specific library
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include <mDNSresolve.h>
+#include <TouchLayout.h>
+#include <FrameScheduler.h>
+#include <StateStore.h>
+#include <AsyncFlow.h>
+#include <ApiJobs.h>
+#include <ApiClient.h>
+#include <ApiText.h>
+#include <BmpRow.h>
+#include <WiFiLink.h>
+#include <BootTiming.h>
+#include <BootPipeline.h>
+#include <SettingsStore.h>
+#include <PollScheduler.h>
+#include <StateSnapshot.h>
+#include <TouchRecord.h>
+#include <Trace.h>
+#include <NetTiming.h>
+#include <Metrics.h>
+#include <HeapMonitor.h>
+#include <HeapProfile.h>
+#if NATIVE_HOST
+#include <NativeHost.h>
+#endif
 
 /* Debug options */
 #define DEBUGAPIREQ false
+#ifndef RENDER_HARNESS
+#define RENDER_HARNESS 0 // Draw every screen from fixed data and report timings instead of starting up (pio run -e render)
+#endif
+#ifndef TOUCH_RECORD
+#define TOUCH_RECORD 0 // 1: print every touch as a "touchrec" line for --replay, 2: also keep them in TOUCH_RECORD_FILE
+#endif
+#define TOUCH_RECORD_FILE "/touches.txt" // Printed and cleared at the next boot
+#define TOUCH_RECORD_MAX_BYTES 32768
+// Build with -DTRACE=1 (pio run -e esp32dev_trace) to trace the request, parse, draw and
+// loop timings; send 't' over serial to print the trace. See include/Trace.h.
+// Build with -DHEAP_PROFILE=1 (pio run -e esp32dev_heap) to count allocations per
+// subsystem in the stats printout and /metrics. See include/HeapProfile.h.
+// The request timeouts, response limits and poll intervals are in include/ApiClient.h,
+// shared with the fleet load generator.
 
 
 /**************************************/
 /* Configure screen colors and layout */
 /**************************************/
-// How quickly does the metadata refresh (in milliseconds)
-#define REFRESH_INTERVAL 5000
+// The frame and touch timings below are defaults for the stored settings, as is
+// REFRESH_INTERVAL in include/ApiClient.h.
+
+// UI frame rate and how long one frame may spend drawing before deferrable work waits
+#define FRAME_INTERVAL 33    // In milliseconds, about 30 Hz
+#define FRAME_BUDGET 20000   // In microseconds
+#define FRAME_STATS_INTERVAL 30000 // How often frame statistics are printed (in milliseconds)
+
+// Heap health. A warning is printed when the free heap or the largest free block is below
+// its floor, or falling fast enough to get there within HEAP_WARN_HORIZON.
+#define HEAP_SAMPLE_INTERVAL 60000 // In milliseconds; the trend is fitted over the last HEAP_SAMPLES (an hour)
+#define HEAP_FREE_FLOOR 32768
+#define HEAP_BLOCK_FLOOR (API_MAX_RESPONSE + 4096) // A response still has to fit in one piece
+#define HEAP_WARN_HORIZON 24 // In hours
+
+// Touches closer together than this are ignored (in milliseconds)
+#define TOUCH_DEBOUNCE 200
+
+// How long after a touch its state, frame and PATCH timings are reported (in milliseconds)
+#define INTERACTION_WINDOW 2000
 
 // Colors
 #define GREY 0x5AEB
@@ -98,14 +152,28 @@ WiFiMulti wifiMulti;
 // Maximum length of the source name
 #define SRC_NAME_LEN 22
 
+// Number of streams shown on each page of the source selection screen
+#define SOURCES_PER_PAGE 6
+
 
 /******************************/
 /* Configure system variables */
 /******************************/
 TFT_eSPI tft = TFT_eSPI(); // Invoke TFT display library
+FrameScheduler frameScheduler(FRAME_INTERVAL, FRAME_BUDGET);
+InteractionTimer interactions(INTERACTION_WINDOW);
+NetTimings netTimings;
+LoopStats loopStats;
+HeapMonitor heapMonitor(HEAP_SAMPLE_INTERVAL, HEAP_FREE_FLOOR, HEAP_BLOCK_FLOOR, HEAP_WARN_HORIZON);
+#if HEAP_PROFILE
+HeapProfileReport heapProfileReport;
+#endif
+#if TOUCH_RECORD
+TouchRecorder touchRecorder;
+#endif
 
-// This is the file name used to store the touch coordinate
-// calibration data. Cahnge the name to start a new calibration.
+// This is the file name the touch coordinate calibration data used to be stored in.
+// It is now kept in the settings record, the file is only read to migrate it.
 #define CALIBRATION_FILE "/TouchCalData"
 
 // Set REPEAT_CAL to true instead of false to run calibration
@@ -189,6 +257,10 @@ String AP_PASS;
 
 #define HTTP_PORT           80
 
+// Prometheus metrics are served on HTTP_PORT at this path once setup() is done
+#define METRICS_PATH        "/metrics"
+AsyncWebServer metricsServer(HTTP_PORT);
+
 #define AMPLIPIHOST_LEN     64
 #define AMPLIPIZONE_LEN     6
 char amplipiHost [AMPLIPIHOST_LEN] = "amplipi.local"; // Default settings
@@ -196,33 +268,69 @@ char amplipiZone1 [AMPLIPIZONE_LEN] = "0";
 char amplipiZone2 [AMPLIPIZONE_LEN] = "-1";
 char amplipiSource [AMPLIPIZONE_LEN] = "0";
 
+// When to poll each AmpliPi resource
+PollScheduler pollScheduler;
+
+// Everything that is saved across reboots, in one record in NVS
+KeypadSettings settings = {};
+SettingsStore settingsStore;
+
 
 /*************************************/
 /* Configure globally used variables */
 /*************************************/
-String activeScreen = "metadata"; // Available screens: metadata, source, setting
-String sourceName = "";
-String currentArtist = "";
-String currentSong = "";
-String currentStatus = "";
-String currentAlbumArt = "";
-String currentSourceName = "";
-bool inWarning = false;
+enum Screen : uint8_t
+{
+    SCREEN_METADATA,
+    SCREEN_SOURCE,
+    SCREEN_SETTING,
+    SCREEN_COUNT
+};
+Screen activeScreen = SCREEN_METADATA;
+// Zones, source and stream as last read from AmpliPi. Network code publishes into it and the
+// frame renderer reads from it.
+StateStore<KeypadState> stateStore;
+
+// Requests to AmpliPi, run on a background task so the UI keeps going while they're in flight
+ApiJobQueue apiJobs;
+ApiCodec apiCodec(API_MSGPACK);
+
+// Reconnects WiFi in the background when the link drops
+WiFiLink wifiLink;
+
+// How long each part of startup took, printed once the first metadata is on screen
+BootTiming bootTiming;
+
+// Startup phases, run side by side where they don't depend on each other
+BootPipeline bootPipeline(bootTiming);
+#define BOOT_STORAGE   (1 << 0) // File system mounted, config.json loaded
+#define BOOT_DISPLAY   (1 << 1) // Screen initialized
+#define BOOT_ASSETS    (1 << 2) // Icons decoded into RAM
+#define BOOT_CALIBRATE (1 << 3) // Touch calibration loaded or done
+
+// The WiFi connects from loop(), so its boot phase is timed there until it first gets an IP
+uint8_t wifiBootPhase = BOOT_TIMING_MAX_PHASES;
+
+// Last known state, saved to flash so the next boot can show it straight away
+StateSnapshot stateSnapshot;
 int newAmplipiSource = 0;
 int newAmplipiZone1 = 0;
 int newAmplipiZone2 = 0;
 bool amplipiZone2Enabled = false;
 int totalStreams = 0;
 int currentSourceOffset = 0;
-int sourceIDs[6];
+int sourceIDs[SOURCES_PER_PAGE];
+String sourceNames[SOURCES_PER_PAGE];
+int sourcesOnPage = 0;
+bool sourcesLoading = false;
+bool redrawScreen = true; // Whole active screen needs drawing, for example after a screen change
 bool updateAlbumart = true;
 bool updateSource = false;
+bool updateMetadata = false;
+bool updateWarning = false;
+bool updateSettingValues = false;
 bool updateMute1 = true;
 bool updateMute2 = true;
-bool muteZone1 = false;
-bool muteZone2 = false;
-float volPercent1 = 100;
-float volPercent2 = 100;
 bool updateVol1 = true;
 bool updateVol2 = true;
 bool metadata_refresh = true;
@@ -236,59 +344,13 @@ bool metadata_refresh = true;
 
 ///////////////////////////////////////////
 
-uint8_t connectMultiWiFi()
+// Remember a network for the WiFi link to try
+void addWiFiCredential(const char *ssid, const char *pass)
 {
-#define WIFI_MULTI_1ST_CONNECT_WAITING_MS           0L
-#define WIFI_MULTI_CONNECT_WAITING_MS               100L
-  
-  uint8_t status;
-
-  LOGERROR(F("ConnectMultiWiFi with :"));
-  
-  if ( (Router_SSID != "") && (Router_Pass != "") )
-  {
-    //LOGERROR3(F("* Flash-stored Router_SSID = "), Router_SSID, F(", Router_Pass = "), Router_Pass );
-  }
-
-  for (uint8_t i = 0; i < NUM_WIFI_CREDENTIALS; i++)
-  {
-    // Don't permit NULL SSID and password len < MIN_AP_PASSWORD_SIZE (8)
-    if ( (String(WM_config.WiFi_Creds[i].wifi_ssid) != "") && (strlen(WM_config.WiFi_Creds[i].wifi_pw) >= MIN_AP_PASSWORD_SIZE) )
-    {
-      //LOGERROR3(F("* Additional SSID = "), WM_config.WiFi_Creds[i].wifi_ssid, F(", PW = "), WM_config.WiFi_Creds[i].wifi_pw );
-    }
-  }
-  
-  LOGERROR(F("Connecting MultiWifi..."));
-
-  WiFi.mode(WIFI_STA);
-
-  int i = 0;
-  status = wifiMulti.run();
-  delay(WIFI_MULTI_1ST_CONNECT_WAITING_MS);
-
-  while ( ( i++ < 20 ) && ( status != WL_CONNECTED ) )
-  {
-    status = wifiMulti.run();
-
-    if ( status == WL_CONNECTED )
-      break;
-    else
-      delay(WIFI_MULTI_CONNECT_WAITING_MS);
-  }
-
-  if ( status == WL_CONNECTED )
-  {
-    LOGERROR1(F("WiFi connected after time: "), i);
-    LOGERROR3(F("SSID:"), WiFi.SSID(), F(",RSSI="), WiFi.RSSI());
-    LOGERROR3(F("Channel:"), WiFi.channel(), F(",IP address:"), WiFi.localIP() );
-  }
-  else
-    LOGERROR(F("WiFi not connected"));
-
-  return status;
+    wifiLink.addCredential(ssid, pass);
 }
 
+
 //flag for saving data
 bool shouldSaveConfig = false;
 
@@ -299,6 +361,7 @@ void saveConfigCallback()
   shouldSaveConfig = true;
 }
 
+// Read the old config.json, for migration
 bool loadFileFSConfigFile()
 {
   //clean FS, for testing
@@ -374,67 +437,42 @@ bool loadFileFSConfigFile()
   return true;
 }
 
-bool saveFileFSConfigFile()
+// Move the WiFi reconnect state machine along and let the UI know when the link changes
+void check_WiFi()
 {
-  Serial.println(F("Saving config"));
-
-  DynamicJsonDocument json(1024);
-
-  json["amplipiHost"]  = amplipiHost;
-  json["amplipiZone1"] = amplipiZone1;
-  json["amplipiZone2"] = amplipiZone2;
-  json["amplipiSource"] = amplipiSource;
-
-  File configFile = FileFS.open(configFileName, "w");
-
-  if (!configFile)
-  {
-    Serial.println(F("Failed to open config file for writing"));
-
-    return false;
-  }
-
-  serializeJsonPretty(json, Serial);
-  // Write data to file and close it
-  serializeJson(json, configFile);
+    wifiLink.tick(millis());
 
-  configFile.close();
-  //end save
-
-  return true;
+    bool connected = wifiLink.connected();
+    if (connected && (wifiBootPhase < BOOT_TIMING_MAX_PHASES))
+    {
+        bootTiming.end(wifiBootPhase);
+        wifiBootPhase = BOOT_TIMING_MAX_PHASES;
+    }
+    stateStore.publish([connected](KeypadState &state) -> uint32_t {
+        if (state.wifiConnected == connected) { return 0; }
+        state.wifiConnected = connected;
+        return STATE_LINK;
+    });
 }
 
-void check_WiFi()
-{
-  if ( (WiFi.status() != WL_CONNECTED) )
-  {
-    Serial.println(F("\nWiFi lost. Calling connectMultiWiFi in loop"));
-    connectMultiWiFi();
-  }
-}  
-
-void check_status()
+// Copy the config portal's WiFi networks out of the settings. Returns false if there are none.
+bool loadConfigData()
 {
-  static ulong checkstatus_timeout  = 0;
-  static ulong checkwifi_timeout    = 0;
-
-  static ulong current_millis;
-
-#define WIFICHECK_INTERVAL    1000L
+    memset(&WM_config, 0, sizeof(WM_config));
 
-  current_millis = millis();
-  
-  // Check WiFi every WIFICHECK_INTERVAL (1) seconds.
-  if ((current_millis > checkwifi_timeout) || (checkwifi_timeout == 0))
-  {
-    check_WiFi();
-    checkwifi_timeout = current_millis + WIFICHECK_INTERVAL;
-  }
+    bool found = false;
+    for (uint8_t i = 0; i < NUM_WIFI_CREDENTIALS; i++)
+    {
+        strncpy(WM_config.WiFi_Creds[i].wifi_ssid, settings.wifi[i].ssid, sizeof(WM_config.WiFi_Creds[i].wifi_ssid) - 1);
+        strncpy(WM_config.WiFi_Creds[i].wifi_pw, settings.wifi[i].pass, sizeof(WM_config.WiFi_Creds[i].wifi_pw) - 1);
+        if (WM_config.WiFi_Creds[i].wifi_ssid[0] != '\0') { found = true; }
+    }
+    return found;
 }
 
-bool loadConfigData()
+// Read the WiFi networks from the old /wifi_cred.dat, for migration
+bool loadLegacyConfigData()
 {
-
   if (FileFS.exists(CONFIG_FILENAME))
   {
     File file = FileFS.open(CONFIG_FILENAME, "r");
@@ -460,32 +498,127 @@ bool loadConfigData()
     return false;
   }
 }
-    
+
+// Read the touch calibration from the old /TouchCalData, for migration. The file holds
+// seven values, of which the record keeps the five setTouch() takes.
+bool loadLegacyCalibration(uint16_t *calData)
+{
+    bool calDataOK = false;
+    if (SPIFFS.exists(CALIBRATION_FILE))
+    {
+        File f = SPIFFS.open(CALIBRATION_FILE, "r");
+        if (f)
+        {
+            uint16_t fileData[7];
+            if (f.readBytes((char *)fileData, sizeof(fileData)) == sizeof(fileData))
+            {
+                memcpy(calData, fileData, 5 * sizeof(uint16_t));
+                calDataOK = true;
+            }
+            f.close();
+        }
+    }
+    return calDataOK;
+}
+
+// Save the current AmpliPi settings and WiFi networks, along with everything else in the record
+bool saveSettings()
+{
+    strncpy(settings.amplipiHost, amplipiHost, sizeof(settings.amplipiHost) - 1);
+    strncpy(settings.amplipiZone1, amplipiZone1, sizeof(settings.amplipiZone1) - 1);
+    strncpy(settings.amplipiZone2, amplipiZone2, sizeof(settings.amplipiZone2) - 1);
+    strncpy(settings.amplipiSource, amplipiSource, sizeof(settings.amplipiSource) - 1);
+
+    for (uint8_t i = 0; i < NUM_WIFI_CREDENTIALS; i++)
+    {
+        strncpy(settings.wifi[i].ssid, WM_config.WiFi_Creds[i].wifi_ssid, sizeof(settings.wifi[i].ssid) - 1);
+        strncpy(settings.wifi[i].pass, WM_config.WiFi_Creds[i].wifi_pw, sizeof(settings.wifi[i].pass) - 1);
+    }
+
+    Serial.println(F("Saving settings"));
+    return settingsStore.save(settings);
+}
+
 void saveConfigData()
 {
-  File file = FileFS.open(CONFIG_FILENAME, "w");
-  LOGERROR(F("SaveWiFiCfgFile "));
+    saveSettings();
+}
 
-  if (file)
-  {
-    file.write((uint8_t*) &WM_config,   sizeof(WM_config));
-    file.close();
-    LOGERROR(F("OK"));
-  }
-  else
-  {
-    LOGERROR(F("failed"));
-  }
+// Factory values for everything in the record
+void defaultSettings()
+{
+    memset(&settings, 0, sizeof(settings));
+    strncpy(settings.amplipiHost, "amplipi.local", sizeof(settings.amplipiHost) - 1);
+    strncpy(settings.amplipiZone1, "0", sizeof(settings.amplipiZone1) - 1);
+    strncpy(settings.amplipiZone2, "-1", sizeof(settings.amplipiZone2) - 1);
+    strncpy(settings.amplipiSource, "0", sizeof(settings.amplipiSource) - 1);
+    settings.refreshInterval = REFRESH_INTERVAL;
+    settings.frameInterval = FRAME_INTERVAL;
+    settings.frameBudget = FRAME_BUDGET;
+    settings.touchDebounce = TOUCH_DEBOUNCE;
 }
 
+// Put the stored settings into effect
+void applySettings()
+{
+    strncpy(amplipiHost, settings.amplipiHost, sizeof(amplipiHost) - 1);
+    strncpy(amplipiZone1, settings.amplipiZone1, sizeof(amplipiZone1) - 1);
+    strncpy(amplipiZone2, settings.amplipiZone2, sizeof(amplipiZone2) - 1);
+    strncpy(amplipiSource, settings.amplipiSource, sizeof(amplipiSource) - 1);
+    frameScheduler.setTiming(settings.frameInterval, settings.frameBudget);
 
-// Function to handle touchscreen calibration. Calibration only runs once, unless 
-//  TouchCalData file is removed or REPEAT_CAL is set to true
-void touch_calibrate()
+    configurePolling(pollScheduler, settings.refreshInterval);
+}
+
+// Load the settings record. On the first boot after an update there isn't one yet, so
+//  build it from config.json, /wifi_cred.dat and /TouchCalData, then remove those files
+//  once the record reads back intact.
+void loadSettings()
 {
-    uint16_t calData[5];
-    uint8_t calDataOK = 0;
+    if (settingsStore.load(settings))
+    {
+        Serial.println(F("Loaded settings"));
+        applySettings();
+        return;
+    }
+
+    if (FileFS.exists(configFileName) || FileFS.exists(CONFIG_FILENAME) || SPIFFS.exists(CALIBRATION_FILE))
+        Serial.println(F("No stored settings, migrating from the file system"));
+    else
+        Serial.println(F("No usable stored settings and no old files to migrate, starting from defaults"));
+    defaultSettings();
+    applySettings();
+
+    // Reads config.json straight into amplipiHost, amplipiZone1/2 and amplipiSource
+    loadFileFSConfigFile();
+
+    if (!loadLegacyConfigData())
+    {
+        memset(&WM_config, 0, sizeof(WM_config));
+    }
+
+    settings.touchCalValid = loadLegacyCalibration(settings.touchCal);
+
+    // Only remove the old files once the record is written and reads back the same, so a
+    // bad write is migrated again at the next boot rather than losing them
+    KeypadSettings saved;
+    if (saveSettings() && settingsStore.load(saved) && (memcmp(&saved, &settings, sizeof(saved)) == 0))
+    {
+        if (FileFS.exists(configFileName)) { FileFS.remove(configFileName); }
+        if (FileFS.exists(CONFIG_FILENAME)) { FileFS.remove(CONFIG_FILENAME); }
+        if (FileFS.exists(CALIBRATION_FILE)) { FileFS.remove(CALIBRATION_FILE); }
+    }
+    else
+    {
+        Serial.println(F("Settings didn't read back, keeping the old files to migrate again"));
+    }
+}
+
 
+// Boot phase: mount the file system, formatting it if it hasn't been formatted yet, and
+//  load the settings
+void loadStorage()
+{
     // check file system exists
     if (!SPIFFS.begin())
     {
@@ -494,29 +627,37 @@ void touch_calibrate()
         SPIFFS.begin();
     }
 
-    // check if calibration file exists and size is correct
-    if (SPIFFS.exists(CALIBRATION_FILE))
-    {
-        if (REPEAT_CAL)
-        {
-            // Delete if we want to re-calibrate
-            SPIFFS.remove(CALIBRATION_FILE);
-        }
-        else
-        {
-            File f = SPIFFS.open(CALIBRATION_FILE, "r");
-            if (f)
-            {
-                if (f.readBytes((char *)calData, 14) == 14)
-                    calDataOK = 1;
-                f.close();
-            }
-        }
-    }
+    // This gives us our WiFi settings and AmpliPi settings (if they've been set).
+    loadSettings();
+}
+
+// Boot phase: bring up the screen
+void initDisplay()
+{
+    // Initialize screen
+    tft.init();
+    Serial.println("Screen initialized");
+
+    // Set the rotation before we calibrate
+    tft.setRotation(0);
+
+    // Wrap test at right and bottom of screen
+    tft.setTextWrap(true, true);
+
+    tft.setFreeFont(FSS18);
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+}
+
+// Function to handle touchscreen calibration. Calibration only runs once, unless the
+//  stored calibration is cleared or REPEAT_CAL is set to true. Needs the settings loaded.
+void touch_calibrate()
+{
+    uint16_t calData[5];
 
-    if (calDataOK && !REPEAT_CAL)
+    if (settings.touchCalValid && !REPEAT_CAL)
     {
         // calibration data valid
+        memcpy(calData, settings.touchCal, sizeof(calData));
         tft.setTouch(calData);
         Serial.println("Touch screen calibrated");
     }
@@ -548,12 +689,9 @@ void touch_calibrate()
         tft.println("Calibration complete!");
 
         // store data
-        File f = SPIFFS.open(CALIBRATION_FILE, "w");
-        if (f)
-        {
-            f.write((const unsigned char *)calData, 14);
-            f.close();
-        }
+        memcpy(settings.touchCal, calData, sizeof(settings.touchCal));
+        settings.touchCalValid = true;
+        saveSettings();
     }
 }
 
@@ -585,35 +723,166 @@ void clearMainArea()
 }
 
 
+// Record whether the last AmpliPi request worked. The warning near the bottom of the screen
+// follows this.
+void setApiReachable(bool reachable)
+{
+    uint32_t changed = stateStore.publish([reachable](KeypadState &state) -> uint32_t {
+        if (state.apiUnreachable == !reachable) { return 0; }
+        state.apiUnreachable = !reachable;
+        return STATE_LINK;
+    });
+
+    if (changed)
+    {
+        if (reachable) { Serial.println("Cleared warning."); }
+        else { Serial.println("Warning: Unable to access AmpliPi"); }
+    }
+}
+
 // Show a warning near bottom of screen. Primarily used if we can't access AmpliPi API
-void drawWarning(String message)
+void drawWarning()
 {
+    TRACE_SCOPE("drawWarning");
     tft.fillRect(WARNZONE_X, WARNZONE_Y, WARNZONE_W, WARNZONE_H, TFT_BLACK); // Clear warning area
-    Serial.print("Warning: ");
-    Serial.println(message);
-    tft.setTextColor(TFT_RED, TFT_BLACK);
-    tft.setFreeFont(FSS9);
-    tft.drawString(message, (WARNZONE_X + 5), WARNZONE_Y);
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-    tft.setFreeFont(FSS12);
-    inWarning = true;
+    const KeypadState &state = stateStore.current();
+    // A state restored at boot starts without WiFi, and is marked as updating rather than
+    // warned about until a request to AmpliPi fails
+    if (state.apiUnreachable || (!state.wifiConnected && !state.stale))
+    {
+        tft.setTextDatum(TL_DATUM);
+        tft.setTextColor(TFT_RED, TFT_BLACK);
+        tft.setFreeFont(FSS9);
+        // Without WiFi, say so rather than blaming AmpliPi. The last known state stays on screen.
+        if (!state.wifiConnected) { tft.drawString("Reconnecting to WiFi...", (WARNZONE_X + 5), WARNZONE_Y); }
+        else { tft.drawString("Unable to access AmpliPi", (WARNZONE_X + 5), WARNZONE_Y); }
+        tft.setTextColor(TFT_WHITE, TFT_BLACK);
+        tft.setFreeFont(FSS12);
+    }
+    else if (state.stale)
+    {
+        // Restored at boot, AmpliPi hasn't confirmed it yet (the WiFi may still be connecting)
+        tft.setTextDatum(TL_DATUM);
+        tft.setTextColor(GREY, TFT_BLACK);
+        tft.setFreeFont(FSS9);
+        tft.drawString("Updating...", (WARNZONE_X + 5), WARNZONE_Y);
+        tft.setTextColor(TFT_WHITE, TFT_BLACK);
+        tft.setFreeFont(FSS12);
+    }
+    updateWarning = false;
 }
 
-void clearWarning()
+
+// Check a 24 bit BMP's header and seek to its pixel data. Returns false if the format isn't supported.
+bool readBmpHeader(fs::File &bmpFS, uint16_t &w, uint16_t &h)
 {
-    Serial.println("Cleared warning.");
-    tft.fillRect(WARNZONE_X, WARNZONE_Y, WARNZONE_W, WARNZONE_H, TFT_BLACK); // Clear warning area
-    inWarning = false;
+    if (read16(bmpFS) != 0x4D42)
+        return false;
+
+    read32(bmpFS);
+    read32(bmpFS);
+    uint32_t seekOffset = read32(bmpFS);
+    read32(bmpFS);
+    w = read32(bmpFS);
+    h = read32(bmpFS);
+
+    if ((read16(bmpFS) == 1) && (read16(bmpFS) == 24) && (read32(bmpFS) == 0))
+    {
+        bmpFS.seek(seekOffset);
+        return true;
+    }
+    Serial.println("BMP format not recognized.");
+    return false;
+}
+
+// Read one row of BMP pixels and convert it from 24 to 16 bit colour, in place
+void readBmpRow(fs::File &bmpFS, uint8_t *lineBuffer, uint16_t w, uint16_t padding)
+{
+    bmpFS.read(lineBuffer, w * 3 + padding);
+    bmpRowToRgb565(lineBuffer, w);
+}
+
+
+// Icons drawn on every screen. They are decoded into RAM during boot so drawing them
+// doesn't touch the file system. pixels is set last, once the icon is ready.
+struct Icon
+{
+    const char *filename;
+    uint16_t w;
+    uint16_t h;
+    std::atomic<uint16_t *> pixels; // 16 bit colour, top row first
+};
+
+Icon icons[] = {
+    {"/source.bmp", 0, 0, {nullptr}},
+    {"/settings.bmp", 0, 0, {nullptr}},
+    {"/volume_off.bmp", 0, 0, {nullptr}},
+    {"/volume_up.bmp", 0, 0, {nullptr}},
+};
+
+void loadIcon(Icon &icon)
+{
+    fs::File bmpFS = SPIFFS.open(icon.filename, "r");
+    if (!bmpFS)
+        return;
+
+    uint16_t w, h;
+    if (readBmpHeader(bmpFS, w, h))
+    {
+        uint16_t padding = (4 - ((w * 3) & 3)) & 3;
+        uint8_t lineBuffer[w * 3 + padding];
+        uint16_t *pixels = (uint16_t *)malloc(w * h * sizeof(uint16_t));
+        if (pixels)
+        {
+            // BMP rows are stored bottom up
+            for (uint16_t row = 0; row < h; row++)
+            {
+                readBmpRow(bmpFS, lineBuffer, w, padding);
+                memcpy(&pixels[(h - 1 - row) * w], lineBuffer, w * sizeof(uint16_t));
+            }
+            icon.w = w;
+            icon.h = h;
+            icon.pixels.store(pixels, std::memory_order_release);
+        }
+    }
+    bmpFS.close();
+}
+
+// Boot phase: decode the icons into RAM
+void preloadIcons()
+{
+    for (Icon &icon : icons)
+    {
+        loadIcon(icon);
+    }
 }
 
 
-// Show the album art file on screen
+// Show a BMP file on screen, from RAM if it is a preloaded icon
 void drawBmp(const char *filename, int16_t x, int16_t y)
 {
+    TRACE_SCOPE("drawBmp");
 
     if ((x >= tft.width()) || (y >= tft.height()))
         return;
 
+    for (Icon &icon : icons)
+    {
+        if (strcmp(icon.filename, filename) == 0)
+        {
+            uint16_t *pixels = icon.pixels.load(std::memory_order_acquire);
+            if (pixels)
+            {
+                bool oldSwapBytes = tft.getSwapBytes();
+                tft.setSwapBytes(true);
+                tft.pushImage(x, y, icon.w, icon.h, pixels);
+                tft.setSwapBytes(oldSwapBytes);
+                return;
+            }
+            break; // Not loaded yet, fall back to the file
+        }
+    }
+
     fs::File bmpFS;
 
     // Open requested file on SD card
@@ -621,89 +890,90 @@ void drawBmp(const char *filename, int16_t x, int16_t y)
 
     if (!bmpFS)
     {
-        Serial.print("File not found");
+        Serial.println("File not found");
         return;
     }
 
-    uint32_t seekOffset;
     uint16_t w, h, row;
-    uint8_t r, g, b;
 
     uint32_t startTime = millis();
 
-    if (read16(bmpFS) == 0x4D42)
+    if (readBmpHeader(bmpFS, w, h))
     {
-        read32(bmpFS);
-        read32(bmpFS);
-        seekOffset = read32(bmpFS);
-        read32(bmpFS);
-        w = read32(bmpFS);
-        h = read32(bmpFS);
+        y += h - 1;
 
-        if ((read16(bmpFS) == 1) && (read16(bmpFS) == 24) && (read32(bmpFS) == 0))
-        {
-            y += h - 1;
-
-            bool oldSwapBytes = tft.getSwapBytes();
-            tft.setSwapBytes(true);
-            bmpFS.seek(seekOffset);
+        bool oldSwapBytes = tft.getSwapBytes();
+        tft.setSwapBytes(true);
 
-            uint16_t padding = (4 - ((w * 3) & 3)) & 3;
-            uint8_t lineBuffer[w * 3 + padding];
-
-            for (row = 0; row < h; row++)
-            {
+        uint16_t padding = (4 - ((w * 3) & 3)) & 3;
+        uint8_t lineBuffer[w * 3 + padding];
 
-                bmpFS.read(lineBuffer, sizeof(lineBuffer));
-                uint8_t *bptr = lineBuffer;
-                uint16_t *tptr = (uint16_t *)lineBuffer;
-                // Convert 24 to 16 bit colours
-                for (uint16_t col = 0; col < w; col++)
-                {
-                    b = *bptr++;
-                    g = *bptr++;
-                    r = *bptr++;
-                    *tptr++ = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-                }
+        for (row = 0; row < h; row++)
+        {
+            readBmpRow(bmpFS, lineBuffer, w, padding);
 
-                // Push the pixel row to screen, pushImage will crop the line if needed
-                // y is decremented as the BMP image is drawn bottom up
-                tft.pushImage(x, y--, w, 1, (uint16_t *)lineBuffer);
-            }
-            tft.setSwapBytes(oldSwapBytes);
-            Serial.print("Loaded in ");
-            Serial.print(millis() - startTime);
-            Serial.println(" ms");
+            // Push the pixel row to screen, pushImage will crop the line if needed
+            // y is decremented as the BMP image is drawn bottom up
+            tft.pushImage(x, y--, w, 1, (uint16_t *)lineBuffer);
         }
-        else
-            Serial.println("BMP format not recognized.");
+        tft.setSwapBytes(oldSwapBytes);
+        Serial.print("Loaded in ");
+        Serial.print(millis() - startTime);
+        Serial.println(" ms");
     }
     bmpFS.close();
 }
 
 
+// Look up AmpliPi and connect to it, timing each phase. HTTPClient sends its request over
+// the connection instead of making its own.
+bool connectApi(WiFiClient &client, NetRequestTimer &timer)
+{
+    String name(amplipiHost);
+    uint16_t port = 80;
+    int colon = name.indexOf(':');
+    if (colon > 0)
+    {
+        port = name.substring(colon + 1).toInt();
+        name.remove(colon);
+    }
+
+    IPAddress ip;
+    bool resolved = WiFi.hostByName(name.c_str(), ip);
+    timer.mark(NET_RESOLVE);
+    if (!resolved)
+        return false;
+    bool connected = client.connect(ip, port, API_TIMEOUT);
+    timer.mark(NET_CONNECT);
+    return connected;
+}
+
 // API Request to Amplipi
 String requestAPI(String request)
 {
+    TRACE_SCOPE("requestAPI");
+    HEAP_SCOPE(HEAP_API);
+    NetRequestTimer timer(netTimings, netEndpoint(request));
+    WiFiClient client;
     HTTPClient http;
 
-    String url = "http://" + String(amplipiHost) + "/api/" + request;
+    String url = apiUrl(amplipiHost, request);
     String payload;
 
 #if DEBUGAPIREQ
     Serial.print("[HTTP] begin...\n");
     Serial.print("[HTTP] GET...\n");
 #endif
-    http.setConnectTimeout(5000);
-    http.setTimeout(5000);
-    http.begin(url); //HTTP
+    http.begin(client, url); //HTTP
+    apiPrepareGet(http, apiCodec);
 
     // start connection and send HTTP header
-    int httpCode = http.GET();
+    int httpCode = connectApi(client, timer) ? http.GET() : HTTPC_ERROR_CONNECTION_REFUSED;
 
     // httpCode will be negative on error
     if (httpCode > 0)
     {
+        timer.mark(NET_TTFB);
 #if DEBUGAPIREQ
         // HTTP header has been send and Server response header has been handled
         Serial.printf("[HTTP] GET... code: %d\n", httpCode);
@@ -712,26 +982,25 @@ String requestAPI(String request)
         // file found at server
         if (httpCode == HTTP_CODE_OK)
         {
-            payload = http.getString();
+            apiReadBody(http, apiCodec, payload);
+            timer.mark(NET_BODY);
 
 #if DEBUGAPIREQ
             Serial.println(payload);
 #endif
 
             // Clear the warning since we jsut received a successful API request
-            if (inWarning)
-            {
-                clearWarning();
-            }
+            setApiReachable(true);
         }
     }
     else
     {
         Serial.printf("[HTTP] GET... failed, error: %s\n", http.errorToString(httpCode).c_str());
-        drawWarning("Unable to access AmpliPi");
+        setApiReachable(false);
     }
 
     http.end();
+    timer.done(httpCode == HTTP_CODE_OK);
 
     return payload;
 }
@@ -740,29 +1009,33 @@ String requestAPI(String request)
 // Send PATCH to API
 bool patchAPI(String request, String payload)
 {
+    TRACE_SCOPE("patchAPI");
+    HEAP_SCOPE(HEAP_API);
+    NetRequestTimer timer(netTimings, netEndpoint(request));
+    WiFiClient client;
     HTTPClient http;
 
     bool result = false;
 
-    String url = "http://" + String(amplipiHost) + "/api/" + request;
+    String url = apiUrl(amplipiHost, request);
 
 #if DEBUGAPIREQ
     Serial.print("[HTTP] begin...\n");
     Serial.print("[HTTP] PATCH...\n");
 #endif
 
-    http.setConnectTimeout(5000);
-    http.setTimeout(5000);
-    http.begin(url); //HTTP
-    http.addHeader("Accept", "application/json");
-    http.addHeader("Content-Type", "application/json");
+    uint8_t packed[API_PACKED_MAX];
+    http.begin(client, url); //HTTP
+    size_t packedSize = apiPreparePatch(http, apiCodec, payload, packed);
 
     // start connection and send HTTP header
-    int httpCode = http.PATCH(payload);
+    int httpCode = HTTPC_ERROR_CONNECTION_REFUSED;
+    if (connectApi(client, timer)) { httpCode = apiSendPatch(http, payload, packed, packedSize); }
 
     // httpCode will be negative on error
     if (httpCode > 0)
     {
+        timer.mark(NET_TTFB);
 #if DEBUGAPIREQ
         // HTTP header has been send and Server response header has been handled
         Serial.printf("[HTTP] PATCH... code: %d\n", httpCode);
@@ -774,12 +1047,10 @@ bool patchAPI(String request, String payload)
             result = true;
 
             // Clear the warning since we jsut received a successful API request
-            if (inWarning)
-            {
-                clearWarning();
-            }
+            setApiReachable(true);
         }
         String resultPayload = http.getString();
+        timer.mark(NET_BODY);
 
 #if DEBUGAPIREQ
         Serial.println("[HTTP] PATCH result:");
@@ -789,30 +1060,40 @@ bool patchAPI(String request, String payload)
     else
     {
         Serial.printf("[HTTP] PATCH... failed, error: %s\n", http.errorToString(httpCode).c_str());
-        drawWarning("Unable to access AmpliPi");
+        setApiReachable(false);
     }
 
     http.end();
+    timer.done(result);
+
+    // AmpliPi refused the MessagePack payload, so send it again as JSON
+    if (packedSize && apiCodec.refused(httpCode)) { return patchAPI(request, payload); }
 
     return result;
 }
 
 
 // Download album art or logo from AmpliPi API. Requires code update to AmpliPi API
+// The image is written to a temporary file and only replaces /albumart.bmp once it is
+// complete, so the screen never draws a half downloaded file.
 bool downloadAlbumart(String streamID)
 {
+    TRACE_SCOPE("downloadAlbumart");
+    HEAP_SCOPE(HEAP_ART);
+    NetRequestTimer timer(netTimings, NET_IMAGE);
+    WiFiClient client;
     HTTPClient http;
     bool outcome = true;
-    String url = "http://" + String(amplipiHost) + "/api/streams/image/" + streamID;
-    String filename = "/albumart.bmp";
+    String url = apiUrl(amplipiHost, "streams/image/" + streamID);
+    String filename = "/albumart.tmp";
 
     // configure server and url
-    http.setConnectTimeout(5000);
-    http.setTimeout(5000);
-    http.begin(url);
+    http.setConnectTimeout(API_TIMEOUT);
+    http.setTimeout(API_TIMEOUT);
+    http.begin(client, url);
 
     // start connection and send HTTP header
-    int httpCode = http.GET();
+    int httpCode = connectApi(client, timer) ? http.GET() : HTTPC_ERROR_CONNECTION_REFUSED;
 
 #if DEBUGAPIREQ
     Serial.println(("[HTTP] GET DONE with code " + String(httpCode)));
@@ -820,6 +1101,7 @@ bool downloadAlbumart(String streamID)
 
     if (httpCode > 0)
     {
+        timer.mark(NET_TTFB);
         Serial.println(F("-- >> OPENING FILE..."));
 
         SPIFFS.remove(filename);
@@ -827,6 +1109,7 @@ bool downloadAlbumart(String streamID)
         if (!f)
         {
             Serial.println(F("file open failed"));
+            http.end();
             return false;
         }
 
@@ -852,10 +1135,19 @@ bool downloadAlbumart(String streamID)
 
             // get tcp stream
             WiFiClient *stream = http.getStreamPtr();
+            timer.restart(); // Leave opening the file out of the body time
 
             // read all data from server
             while (http.connected() && (len > 0 || len == -1))
             {
+                // Something more important needs the network, try again on the next refresh
+                if (apiJobs.preempted(API_BACKGROUND))
+                {
+                    Serial.println("Album art download preempted");
+                    outcome = false;
+                    break;
+                }
+
                 // get available data size
                 size_t size = stream->available();
 
@@ -875,20 +1167,33 @@ bool downloadAlbumart(String streamID)
                 delay(1);
             }
 
+            timer.mark(NET_BODY);
+
 #if DEBUGAPIREQ
             Serial.println("[HTTP] connection closed or file end.");
 #endif
         }
+        else
+        {
+            outcome = false;
+        }
         f.close();
+
+        if (outcome)
+        {
+            SPIFFS.remove("/albumart.bmp");
+            SPIFFS.rename(filename.c_str(), "/albumart.bmp");
+        }
     }
     else
     {
         Serial.println("[HTTP] GET... failed, error: " + http.errorToString(httpCode));
 
-        //drawWarning("Unable to access AmpliPi");
+        //setApiReachable(false);
         outcome = false;
     }
     http.end();
+    timer.done(outcome);
     return outcome;
 }
 
@@ -896,6 +1201,7 @@ bool downloadAlbumart(String streamID)
 // Show downloaded album art of screen
 void drawAlbumart()
 {
+    TRACE_SCOPE("drawAlbumart");
     // Only update album art on screen if we need
     if (!updateAlbumart)
     {
@@ -912,6 +1218,7 @@ void drawAlbumart()
 // Show the current source on screen, top left (by default)
 void drawSource()
 {
+    TRACE_SCOPE("drawSource");
     // Only update source on screen if we need
     if (!updateSource)
     {
@@ -921,32 +1228,24 @@ void drawSource()
     tft.setFreeFont(FSS9);
     tft.setTextDatum(TL_DATUM);
     tft.fillRect(SRCBAR_X, SRCBAR_Y, SRCBAR_W, SRCBAR_H, TFT_BLACK); // Clear source bar first
-    tft.drawString(sourceName, 2, 5, GFXFF); // Top Left
+    tft.drawString(stateStore.current().stream.name, 2, 5, GFXFF); // Top Left
     drawBmp("/source.bmp", (SRCBAR_W - 36), SRCBAR_Y);
 
     updateSource = false;
 }
 
 
-void drawSourceSelection()
+// Keep the streams shown on the current page from AmpliPi's /api/ status
+void parseSourceList(const String &status_json)
 {
-    bool showPrev = false;
-    bool showNext = false;
+    HEAP_SCOPE(HEAP_JSON);
     String streamName = "";
 
-    // Stop metadata refresh
-    metadata_refresh = false;
-
-    Serial.println("Opening source selection screen.");
-
-    // Download source options
-    String status_json = requestAPI(""); // Requesting /api/
-    
     // DynamicJsonDocument<N> allocates memory on the heap
-    DynamicJsonDocument apiStatus(6144);
+    DynamicJsonDocument apiStatus(API_STATUS_DOC_SIZE);
 
     // Deserialize the JSON document
-    DeserializationError error = deserializeJson(apiStatus, status_json);
+    DeserializationError error = ApiCodec::deserialize(apiStatus, status_json);
 
     // Test if parsing succeeds.
     if (error)
@@ -955,53 +1254,70 @@ void drawSourceSelection()
         Serial.println(error.f_str());
     }
 
-    // Clear screen
-    clearMainArea();
-    
-    // Draw size selecton boxes
-    tft.setTextDatum(TL_DATUM);
-    tft.setTextColor(TFT_WHITE, TFT_NAVY);
-    tft.setFreeFont(FSS12);
-
-    Serial.print("currentSourceOffice: ");
+    Serial.print("currentSourceOffset: ");
     Serial.println(currentSourceOffset);
     Serial.println("Streams:");
-    int bi = 0; // Base iterator within 'print 6 items' loop (0-6)
     int i = 0; // Filtered iterator
-    int max = currentSourceOffset + 6;
+    int max = currentSourceOffset + SOURCES_PER_PAGE;
+    sourcesOnPage = 0;
+    totalStreams = 0;
     for (JsonObject value : apiStatus["streams"].as<JsonArray>()) {
         JsonObject thisStream = value;
         streamName = thisStream["name"].as<char*>();
         Serial.print(thisStream["id"].as<char*>());
         Serial.print(" - ");
-        Serial.print(streamName);
+        Serial.println(streamName);
         
         if (streamName.length() >= 19) {
             streamName = streamName.substring(0,18) + "...";
         }
 
-        // Only print 6 items on screen
+        // Only keep the items shown on screen
         if (i >= currentSourceOffset && i < max) 
         {
-            Serial.print(" - String X: ");
-            Serial.print((MAINZONE_X + 10));
-            Serial.print(" - String Y: ");
-            Serial.println((MAINZONE_Y + (40 * bi) + 10));
-
             // Add to sourceIDs array to be used in the main loop when one of the button is selected
-            sourceIDs[bi] = thisStream["id"].as<int>();
-
-            // Display stream button
-            tft.fillRoundRect(MAINZONE_X, (MAINZONE_Y + (40 * bi)), 240, 38, 6, TFT_NAVY); // Selection box
-            tft.drawString(streamName, (MAINZONE_X + 10), (MAINZONE_Y + (40 * bi) + 10));
-            ++bi;
+            sourceIDs[sourcesOnPage] = thisStream["id"].as<int>();
+            sourceNames[sourcesOnPage] = streamName;
+            ++sourcesOnPage;
         }
         ++i;
         ++totalStreams;
     }
+}
+
+
+void drawSourceSelection()
+{
+    TRACE_SCOPE("drawSourceSelection");
+    bool showPrev = (currentSourceOffset >= SOURCES_PER_PAGE);
+    bool showNext = (totalStreams > currentSourceOffset + SOURCES_PER_PAGE);
+
+    Serial.println("Opening source selection screen.");
+
+    // Clear screen
+    clearMainArea();
+
+    if (sourcesLoading)
+    {
+        tft.setTextDatum(TC_DATUM);
+        tft.setTextColor(TFT_WHITE, TFT_BLACK);
+        tft.setFreeFont(FSS12);
+        tft.drawString("Loading sources...", 120, (MAINZONE_Y + 50));
+        tft.setTextDatum(TL_DATUM);
+        return;
+    }
+    
+    // Draw size selecton boxes
+    tft.setTextDatum(TL_DATUM);
+    tft.setTextColor(TFT_WHITE, TFT_NAVY);
+    tft.setFreeFont(FSS12);
 
-    if (totalStreams > currentSourceOffset) { showNext = true; }
-    if (currentSourceOffset >= 6) { showPrev = true; }
+    for (int bi = 0; bi < sourcesOnPage; bi++)
+    {
+        // Display stream button
+        tft.fillRoundRect(MAINZONE_X, (MAINZONE_Y + (40 * bi)), 240, 38, 6, TFT_NAVY); // Selection box
+        tft.drawString(sourceNames[bi], (MAINZONE_X + 10), (MAINZONE_Y + (40 * bi) + 10));
+    }
 
     // Previous and Next buttons
     tft.setTextDatum(TC_DATUM);
@@ -1032,7 +1348,8 @@ void drawSourceSelection()
 }
 
 
-void selectSource(int y)
+// Find the stream under a tap on the source selection screen. Returns -1 for an empty slot.
+int selectSource(int y)
 {
     // Send source selection
     Serial.print("Source Select - Y: ");
@@ -1053,37 +1370,62 @@ void selectSource(int y)
     else if (y >= 158 && y < 198) { selected = 3; }
     else if (y >= 198 && y < 238) { selected = 4; }
     else if (y >= 238 && y < 278) { selected = 5; }
-    
-    String inputID = "stream=" + String(sourceIDs[selected]);
 
-    // Send 
-    String payload = "{\"input\": \"" + inputID + "\"}";
-    Serial.println(payload);
-    bool result = patchAPI("sources/" + String(amplipiSource), payload);
-    Serial.print("selectSource result: ");
-    Serial.println(result);
+    if (selected >= sourcesOnPage)
+    {
+        return -1; // Empty slot below the last stream
+    }
+
+    return sourceIDs[selected];
+}
+
+
+void drawZone1Setting()
+{
+    TRACE_SCOPE("drawZone1Setting");
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    tft.fillRect(0, 41, 160, 38, TFT_BLACK);
+    tft.drawString("Zone 1: " + String(newAmplipiZone1), 5, 50);
+}
+
+void drawZone2Setting()
+{
+    TRACE_SCOPE("drawZone2Setting");
+    String thisZone;
+    if (newAmplipiZone2 < 0) { thisZone = "None"; }
+    else { thisZone = String(newAmplipiZone2); }
+
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    tft.fillRect(0, 81, 160, 38, TFT_BLACK);
+    tft.drawString("Zone 2: " + thisZone, 5, 90);
+}
+
+void drawSourceSetting()
+{
+    TRACE_SCOPE("drawSourceSetting");
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    tft.fillRect(0, 121, 160, 38, TFT_BLACK);
+    tft.drawString("Source: " + String(newAmplipiSource), 5, 130);
 }
 
 
 void drawSettings()
 {
+    TRACE_SCOPE("drawSettings");
     // Available settings:
     // - Select zones to manage
     // - Reset WiFi settings (delete 'wifi.json' config file and reboot, or enable web server to select AP)
     // - Restart
     // - Show version, Wifi AP, IP address
 
-    // Stop metadata refresh
-    metadata_refresh = false;
-
     // Clear screen
     clearMainArea();
     
     // Show settings:
     // Zone 1
     tft.setFreeFont(FSS12);
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-    tft.drawString("Zone 1: " + String(amplipiZone1), 5, 50);
+    tft.setTextDatum(TL_DATUM);
+    drawZone1Setting();
 
     tft.setTextColor(TFT_WHITE, TFT_DARKGREEN);
     tft.fillRoundRect(160, 42, 36, 36, 6, TFT_DARKGREEN);
@@ -1094,11 +1436,7 @@ void drawSettings()
     tft.fillRect(20, 80, 200, 1, GREY); // Seperator
     
     // Zone 2
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-    String thisZone;
-    if (atoi(amplipiZone2) < 0) { thisZone = "None"; }
-    else { thisZone = String(amplipiZone2); }
-    tft.drawString("Zone 2: " + thisZone, 5, 90);
+    drawZone2Setting();
 
     tft.setTextColor(TFT_WHITE, TFT_DARKGREEN);
     tft.fillRoundRect(160, 82, 36, 36, 6, TFT_DARKGREEN);
@@ -1109,8 +1447,7 @@ void drawSettings()
     tft.fillRect(20, 120, 200, 1, GREY); // Seperator
 
     // Source
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-    tft.drawString("Source: " + String(amplipiSource), 5, 130);
+    drawSourceSetting();
 
     tft.setTextColor(TFT_WHITE, TFT_DARKGREEN);
     tft.fillRoundRect(160, 122, 36, 36, 6, TFT_DARKGREEN);
@@ -1147,121 +1484,62 @@ void drawSettings()
 }
 
 
-void sendVolUpdate(int zone)
+void sendVolUpdate(int zone, float volPercent)
 {
-    // Send volume update to API, but only one update per second so we don't spam it
-    int volDb = 0;
-    if (zone == 1) { volDb = (int)(volPercent1 * 0.79 - 79); } // Convert to proper AmpliPi number (-79 to 0)
-    else if (zone == 2) { volDb = (int)(volPercent2 * 0.79 - 79); } // Convert to proper AmpliPi number (-79 to 0)
+    // Send volume update to API. While the slider is dragged only the latest level stays queued.
+    int volDb = (int)(volPercent * 0.79 - 79); // Convert to proper AmpliPi number (-79 to 0)
 
-    String payload = "{\"vol\": " + String(volDb) + "}";
-    bool result = patchAPI("zones/" + String(amplipiZone1), payload);
-    Serial.print("sendVolUpdate result: ");
-    Serial.println(result);
+    apiJobs.submitLatest(API_PATCH, "zones/" + String((zone == 1) ? amplipiZone1 : amplipiZone2), volumePayload(volDb), "vol");
 }
 
-void drawVolume(int x, int zone)
+// Convert between volume percent and the x coordinate of the volume bar marker
+int volumeToX(float percent)
 {
-    if (!updateVol1 && !updateVol2)
-    {
-        return;
-    }; // Only update volume on screen if we need to
+    return VOLBAR_X + (int)(constrain(percent, 0.0f, 100.0f) * VOLBAR_W / 100);
+}
 
-    if (x > 185)
-    {
-        x = 200;
-    } // Bring to 100% if it's close
+float volumeFromX(int x)
+{
+    if (x > 185) { return 100; } // Bring to 100% if it's close
+    return constrain((x - VOLBAR_X) * 100.0f / VOLBAR_W, 0.0f, 100.0f);
+}
 
-    if (amplipiZone2Enabled) {
-        // Two Zone Mode
-        if (zone == 1) {
-            // Zone 1
-            tft.fillRect(VOLBARZONE_X, VOLBARZONE1_Y, VOLBARZONE_W, VOLBARZONE_H, TFT_BLACK); // Clear area first
-
-            // Volume control bar
-            tft.fillRect(VOLBAR_X, VOLBAR1_Y, VOLBAR_W, VOLBAR_H, GREY);           // Grey bar
-            if (muteZone1) {
-                // Muted
-                tft.fillCircle(x, (VOLBAR1_Y + 2), 8, GREY);                       // Circle marker
-            }
-            else {
-                // Unmuted
-                tft.fillRect(VOLBAR_X, VOLBAR1_Y, (x - VOLBAR_X), VOLBAR_H, BLUE); // Blue active bar
-                tft.fillCircle(x, (VOLBAR1_Y + 2), 8, BLUE);                       // Circle marker
-            }
-            updateVol1 = false;
-        }
-        else if (zone == 2) {
-            // Zone 2
-            tft.fillRect(VOLBARZONE_X, VOLBARZONE2_Y, VOLBARZONE_W, VOLBARZONE_H, TFT_BLACK); // Clear area first
-
-            // Volume control bar
-            tft.fillRect(VOLBAR_X, VOLBAR2_Y, VOLBAR_W, VOLBAR_H, GREY);           // Grey bar
-            if (muteZone2) {
-                // Muted
-                tft.fillCircle(x, (VOLBAR2_Y + 2), 8, GREY);                       // Circle marker
-            }
-            else {
-                // Unmuted
-                tft.fillRect(VOLBAR_X, VOLBAR2_Y, (x - VOLBAR_X), VOLBAR_H, BLUE); // Blue active bar
-                tft.fillCircle(x, (VOLBAR2_Y + 2), 8, BLUE);                       // Circle marker
-            }
-            updateVol2 = false;
-        }
+void drawVolume(int zone)
+{
+    TRACE_SCOPE("drawVolume");
+    // Two Zone Mode shows zone 1 in the upper section, otherwise zone 1 is in the lower section
+    bool upper = amplipiZone2Enabled && (zone == 1);
+    int zoneY = upper ? VOLBARZONE1_Y : VOLBARZONE2_Y;
+    int barY = upper ? VOLBAR1_Y : VOLBAR2_Y;
+    const ZoneState &state = stateStore.current().zones[zone - 1];
+    bool muted = state.mute;
+    int x = volumeToX(state.volPercent);
+
+    tft.fillRect(VOLBARZONE_X, zoneY, VOLBARZONE_W, VOLBARZONE_H, TFT_BLACK); // Clear area first
+
+    // Volume control bar
+    tft.fillRect(VOLBAR_X, barY, VOLBAR_W, VOLBAR_H, GREY);           // Grey bar
+    if (muted) {
+        tft.fillCircle(x, (barY + 2), 8, GREY);                       // Circle marker
     }
     else {
-        // One Zone Mode
-        tft.fillRect(VOLBARZONE_X, VOLBARZONE2_Y, VOLBARZONE_W, VOLBARZONE_H, TFT_BLACK);   // Clear area first
-
-        // Volume control bar
-        tft.fillRect(VOLBAR_X, VOLBAR2_Y, VOLBAR_W, VOLBAR_H, GREY);               // Grey bar
-        if (muteZone1) {
-            // Muted
-            tft.fillCircle(x, (VOLBAR2_Y + 2), 8, GREY);
-        }
-        else {
-            tft.fillRect(VOLBAR_X, VOLBAR2_Y, (x - VOLBAR_X), VOLBAR_H, BLUE);    // Blue active bar
-            tft.fillCircle(x, (VOLBAR2_Y + 2), 8, BLUE);
-        }
-        updateVol1 = false;
+        tft.fillRect(VOLBAR_X, barY, (x - VOLBAR_X), VOLBAR_H, BLUE); // Blue active bar
+        tft.fillCircle(x, (barY + 2), 8, BLUE);                       // Circle marker
     }
 
+    if (zone == 1) { updateVol1 = false; }
+    else { updateVol2 = false; }
 }
 
 
-void sendMuteUpdate(int zone)
+void sendMuteUpdate(int zone, bool mute)
 {
-    // Send volume update to API, but only one update per second so we don't spam it
-    String payload;
-
-    if (zone == 1)
-    {
-        if (muteZone1) {
-            payload = "{\"mute\": true}";
-        }
-        else {
-            payload = "{\"mute\": false}";
-        }
-        bool result = patchAPI("zones/" + String(amplipiZone1), payload);
-        Serial.print("sendMuteUpdate result: ");
-        Serial.println(result);
-    }
-    else if (zone == 2)
-    {
-        if (muteZone2) {
-            payload = "{\"mute\": true}";
-        }
-        else {
-            payload = "{\"mute\": false}";
-        }
-        bool result = patchAPI("zones/" + String(amplipiZone2), payload);
-        Serial.print("sendMuteUpdate result: ");
-        Serial.println(result);
-    }
+    apiJobs.submitLatest(API_PATCH, "zones/" + String((zone == 1) ? amplipiZone1 : amplipiZone2), mutePayload(mute), "mute");
 }
 
 void drawMuteBtn(int zone)
 {
+    TRACE_SCOPE("drawMuteBtn");
     if (!updateMute1 && !updateMute2)
     {
         return;
@@ -1270,6 +1548,8 @@ void drawMuteBtn(int zone)
     Serial.print("Drawing mute button for zone ");
     Serial.println(zone);
 
+    const KeypadState &state = stateStore.current();
+
     if (amplipiZone2Enabled) {
         // Two Zone Mode
         if (zone == 1) {
@@ -1289,20 +1569,20 @@ void drawMuteBtn(int zone)
         // Two Zone Mode
         if (zone == 1) {
             // Upper section
-            if (muteZone1) { drawBmp("/volume_off.bmp", MUTE_X, MUTE1_Y); }
+            if (state.zones[0].mute) { drawBmp("/volume_off.bmp", MUTE_X, MUTE1_Y); }
             else { drawBmp("/volume_up.bmp", MUTE_X, MUTE1_Y); }
             updateMute1 = false;
         }
         else if (zone == 2) {
             // Lower section
-            if (muteZone2) { drawBmp("/volume_off.bmp", MUTE_X, MUTE2_Y); }
+            if (state.zones[1].mute) { drawBmp("/volume_off.bmp", MUTE_X, MUTE2_Y); }
             else { drawBmp("/volume_up.bmp", MUTE_X, MUTE2_Y); }
             updateMute2 = false;
         }
     }
     else {
         // One Zone Mode, lower section
-        if (muteZone1) { drawBmp("/volume_off.bmp", MUTE_X, MUTE2_Y); }
+        if (state.zones[0].mute) { drawBmp("/volume_off.bmp", MUTE_X, MUTE2_Y); }
         else { drawBmp("/volume_up.bmp", MUTE_X, MUTE2_Y); }
         updateMute1 = false;
     }
@@ -1310,172 +1590,72 @@ void drawMuteBtn(int zone)
 }
 
 
-// Split a string by a separator
-String getValue(String data, char separator, int index)
+// Publish one zone's mute and volume from its JSON. index is 0 for zone 1 and 1 for zone 2.
+// Returns the change bits.
+uint32_t parseZone(int index, const String &json)
 {
-    int found = 0;
-    int strIndex[] = {0, -1};
-    int maxIndex = data.length() - 1;
+    HEAP_SCOPE(HEAP_JSON);
+    DynamicJsonDocument ampZoneStatus(API_ZONE_DOC_SIZE); // DynamicJsonDocument<N> allocates memory on the heap
+    DeserializationError error = ApiCodec::deserialize(ampZoneStatus, json); // Deserialize the JSON or MessagePack document
 
-    for (int i = 0; i <= maxIndex && found <= index; i++)
+    // Test if parsing succeeds.
+    if (error)
     {
-        if (data.charAt(i) == separator || i == maxIndex)
-        {
-            found++;
-            strIndex[0] = strIndex[1] + 1;
-            strIndex[1] = (i == maxIndex) ? i + 1 : i;
-        }
+        Serial.print(F("deserializeJson() failed: "));
+        Serial.println(error.f_str());
+        return 0;
     }
-    return found > index ? data.substring(strIndex[0], strIndex[1]) : "";
-}
 
-
-void getZone()
-{
-    if (amplipiZone2Enabled) {
-        // Two Zone Mode
-
-        // Zone 1
-        String json = requestAPI("zones/" + String(amplipiZone1));
-        DynamicJsonDocument ampSourceStatus(1000); // DynamicJsonDocument<N> allocates memory on the heap
-        DeserializationError error = deserializeJson(ampSourceStatus, json); // Deserialize the JSON document
-
-        // Test if parsing succeeds.
-        if (error)
-        {
-            Serial.print(F("deserializeJson() failed: "));
-            Serial.println(error.f_str());
-        }
-
-        // Update mute if data from API has changed
-        bool currentMute1 = ampSourceStatus["mute"];
-        if (currentMute1 != muteZone1) {
-            muteZone1 = currentMute1;
-            updateMute1 = true;
-            updateVol1 = true;
-        }
-        drawMuteBtn(1);
-
-        // Update volume bar if data from API has changed
-        int currentVol = ampSourceStatus["vol"];
-        int newVolPercent1;
-        if (currentVol < 0) {
-            newVolPercent1 = currentVol / 0.79 + 100; // Convert from AmpliPi number (-79 to 0) to percent
-        }
-        else {
-            newVolPercent1 = 100;
-        }
-
-        if (volPercent1 != newVolPercent1) {
-            volPercent1 = newVolPercent1;
-            updateVol1 = true;
-        }
-        drawVolume(int((volPercent1 * 1.6) + 45), 1); // Multiply by 1.5 (150px) and add 40 pixels to give it the x coord
-
-        // Zone 2
-        String json2 = requestAPI("zones/" + String(amplipiZone2));
-        DynamicJsonDocument ampSourceStatus2(1000); // DynamicJsonDocument<N> allocates memory on the heap
-        DeserializationError error2 = deserializeJson(ampSourceStatus2, json2); // Deserialize the JSON document
-
-        // Test if parsing succeeds.
-        if (error2)
-        {
-            Serial.print(F("deserializeJson() failed: "));
-            Serial.println(error2.f_str());
-        }
-
-        // Update mute if data from API has changed
-        bool currentMute2 = ampSourceStatus2["mute"];
-        if (currentMute2 != muteZone2) {
-            muteZone2 = currentMute2;
-            updateMute2 = true;
-            updateVol2 = true;
-        }
-        drawMuteBtn(2);
-
-        // Update volume bar if data from API has changed
-        int currentVol2 = ampSourceStatus2["vol"];
-        int newVolPercent2;
-        if (currentVol2 < 0) {
-            newVolPercent2 = currentVol2 / 0.79 + 100; // Convert from AmpliPi number (-79 to 0) to percent
-        }
-        else {
-            newVolPercent2 = 100;
-        }
-        
-        if (volPercent2 != newVolPercent2) {
-            volPercent2 = newVolPercent2;
-            updateVol2 = true;
-        }
-
-        drawVolume(int((volPercent2 * 1.5) + 45), 2); // Multiply by 1.5 (150px) and add 40 pixels to give it the x coord
+    bool currentMute = ampZoneStatus["mute"];
+    int currentVol = ampZoneStatus["vol"];
+    int newVolPercent;
+    if (currentVol < 0) {
+        newVolPercent = currentVol / 0.79 + 100; // Convert from AmpliPi number (-79 to 0) to percent
     }
     else {
-        // One Zone Mode
-        String json = requestAPI("zones/" + String(amplipiZone1));
-        DynamicJsonDocument ampSourceStatus(1000); // DynamicJsonDocument<N> allocates memory on the heap
-        DeserializationError error = deserializeJson(ampSourceStatus, json); // Deserialize the JSON document
-
-        // Test if parsing succeeds.
-        if (error)
-        {
-            Serial.print(F("deserializeJson() failed: "));
-            Serial.println(error.f_str());
-        }
-
-        // Update mute if data from API has changed
-        bool currentMute = ampSourceStatus["mute"];
-        if (currentMute != muteZone1) {
-            muteZone1 = currentMute;
-            updateMute1 = true;
-            updateVol1 = true;
-        }
-        drawMuteBtn(1);
+        newVolPercent = 100;
+    }
 
-        // Update volume bar if data from API has changed
-        int currentVol = ampSourceStatus["vol"];
-        int newVolPercent1;
-        if (currentVol < 0) {
-            newVolPercent1 = currentVol / 0.79 + 100; // Convert from AmpliPi number (-79 to 0) to percent
-        }
-        else {
-            newVolPercent1 = 100;
+    // Only flag the parts that changed, so the screen only redraws those
+    return stateStore.publish([index, currentMute, newVolPercent](KeypadState &state) -> uint32_t {
+        ZoneState &zone = state.zones[index];
+        uint32_t changed = 0;
+        if (!zone.valid || zone.mute != currentMute) {
+            zone.mute = currentMute;
+            changed |= STATE_ZONE_MUTE(index) | STATE_ZONE_VOL(index);
         }
-
-        if (volPercent1 != newVolPercent1) {
-            volPercent1 = newVolPercent1;
-            updateVol1 = true;
+        if (!zone.valid || zone.volPercent != newVolPercent) {
+            zone.volPercent = newVolPercent;
+            changed |= STATE_ZONE_VOL(index);
         }
-        drawVolume(int((volPercent1 * 1.5) + 45), 1); // Multiply by 1.5 (150px) and add 40 pixels to give it the x coord
-    }
-
+        zone.valid = true;
+        return changed;
+    });
 }
 
 
-String getSource(String sourceID)
+// Find which stream a source is playing. Returns "0" for a local input, or "" if the
+// source couldn't be read. sourceName is set to the source's configured name.
+String parseSource(const String &json, String &sourceName)
 {
-    String json = requestAPI("sources/" + String(sourceID));
-
+    HEAP_SCOPE(HEAP_JSON);
     // DynamicJsonDocument<N> allocates memory on the heap
-    DynamicJsonDocument ampSourceStatus(1000);
+    DynamicJsonDocument ampSourceStatus(API_SOURCE_DOC_SIZE);
 
     // Deserialize the JSON document
-    DeserializationError error = deserializeJson(ampSourceStatus, json);
+    DeserializationError error = ApiCodec::deserialize(ampSourceStatus, json);
 
     // Test if parsing succeeds.
     if (error)
     {
         Serial.print(F("deserializeJson() failed: "));
         Serial.println(error.f_str());
-
-        String errormsg = "Error parsing results from Amplipi API";
-        //tft.println(errormsg);
-        return errormsg;
+        return "";
     }
 
-    currentSourceName = ampSourceStatus["name"].as<String>();
-    if (currentSourceName.length() >= SRC_NAME_LEN) {
-        currentSourceName = currentSourceName.substring(0,18) + "...";
+    sourceName = ampSourceStatus["name"].as<String>();
+    if (sourceName.length() >= SRC_NAME_LEN) {
+        sourceName = sourceName.substring(0,18) + "...";
     }
 
     String sourceInput = ampSourceStatus["input"];
@@ -1498,27 +1678,94 @@ String getSource(String sourceID)
 }
 
 
+// Fill in a stream's details from its JSON. Returns false if it couldn't be parsed.
+bool parseStream(const String &json, StreamState &update)
+{
+    HEAP_SCOPE(HEAP_JSON);
+    // DynamicJsonDocument<N> allocates memory on the heap
+    DynamicJsonDocument ampStreamStatus(API_STREAM_DOC_SIZE);
+
+    // Deserialize the JSON document
+    DeserializationError error = ApiCodec::deserialize(ampStreamStatus, json);
+
+    // Test if parsing succeeds.
+    if (error)
+    {
+        Serial.print(F("deserializeJson() failed: "));
+        Serial.println(error.f_str());
+        return false;
+    }
+
+    // Missing fields come back as null and are stored as empty strings
+    JsonObject info = ampStreamStatus["info"];
+    copyText(update.artist, sizeof(update.artist), info["artist"]);
+    copyText(update.album, sizeof(update.album), info["album"]);
+    copyText(update.song, sizeof(update.song), info["song"]);
+    copyText(update.status, sizeof(update.status), ampStreamStatus["status"]);
+    copyText(update.name, sizeof(update.name), ampStreamStatus["name"]);
+    copyText(update.albumArt, sizeof(update.albumArt), info["img_url"]);
+    return true;
+}
+
+
+// Publish a stream's details, flagging only the parts that changed. Album art is published
+// separately by publishAlbumart() once it has been downloaded.
+uint32_t publishStream(const StreamState &update)
+{
+    uint32_t changed = stateStore.publish([&update](KeypadState &state) -> uint32_t {
+        StreamState &stream = state.stream;
+        uint32_t changed = 0;
+        if (copyText(stream.name, sizeof(stream.name), update.name)) { changed |= STATE_SOURCE_NAME; }
+        if (copyText(stream.artist, sizeof(stream.artist), update.artist)) { changed |= STATE_STREAM_META; }
+        if (copyText(stream.song, sizeof(stream.song), update.song)) { changed |= STATE_STREAM_META; }
+        if (copyText(stream.status, sizeof(stream.status), update.status)) { changed |= STATE_STREAM_META; }
+        copyText(stream.album, sizeof(stream.album), update.album);
+        if (!stream.valid) { changed |= STATE_SOURCE_NAME | STATE_STREAM_META; }
+        stream.valid = true;
+        if (state.stale)
+        {
+            // Zones were read just before the stream, so the whole screen is live now
+            state.stale = false;
+            changed |= STATE_LINK;
+        }
+        return changed;
+    });
+
+    if (changed & STATE_STREAM_META)
+    {
+        Serial.println("Printing artist and song on screen.");
+    }
+    return changed;
+}
+
+void publishAlbumart(const char *albumArt)
+{
+    stateStore.publish([albumArt](KeypadState &state) -> uint32_t {
+        copyText(state.stream.albumArt, sizeof(state.stream.albumArt), albumArt);
+        ++state.stream.artVersion;
+        return STATE_ART;
+    });
+}
+
+
 // Re-draw metadata, for example after source select is canceled
 void drawMetadata()
 {
-    String displaySong;
-    String displayArtist;
+    TRACE_SCOPE("drawMetadata");
+    const StreamState &stream = stateStore.current().stream;
+    String displaySong = stream.song;
+    String displayArtist = stream.artist;
 
-    if (currentSong.length() >= 19) {
-        displaySong = currentSong.substring(0,18) + "...";
-    }
-    else {
-        displaySong = currentSong;
+    if (displaySong.length() >= 19) {
+        displaySong = displaySong.substring(0,18) + "...";
     }
     
-    if (currentArtist.length() >= 19) {
-        displayArtist = currentArtist.substring(0,18) + "...";
-    }
-    else {
-        displayArtist = currentArtist;
+    if (displayArtist.length() >= 19) {
+        displayArtist = displayArtist.substring(0,18) + "...";
     }
 
     Serial.println("Refreshing metadata on screen");
+    updateMetadata = false;
 
     tft.setTextDatum(TC_DATUM);
     tft.setFreeFont(FSS12);
@@ -1529,152 +1776,1110 @@ void drawMetadata()
 }
 
 
-void getStream(String sourceID)
+// Run one queued API request on the network task
+bool runApiJob(ApiJob &job)
 {
-    String streamID = getSource(sourceID);
+    // Fail fast while WiFi is down instead of waiting on connection timeouts
+    if (!wifiLink.connected())
+    {
+        if (DEBUGAPIREQ) { Serial.println("WiFi down, skipping request: " + job.path); }
+        return false;
+    }
 
-    String streamArtist = "";
-    String streamAlbum = "";
-    String streamSong = "";
-    String streamStatus = "";
-    String albumArt = "";
-    String streamName = "";
+    switch (job.method)
+    {
+    case API_GET:
+        job.body = requestAPI(job.path);
+        return job.body.length() > 0;
+    case API_PATCH:
+    {
+        bool result = patchAPI(job.path, job.body);
+        interactions.patchSent(micros());
+        Serial.print("PATCH " + job.path + " result: ");
+        Serial.println(result);
+        return result;
+    }
+    case API_DOWNLOAD:
+        return downloadAlbumart(job.path);
+    default:
+        return false;
+    }
+}
+
+
+/*****************************************************/
+/* Flows: multi-step interactions that wait on the API */
+/*****************************************************/
+
+// Refresh zones, source and stream for the metadata screen
+struct RefreshFlow
+{
+    Flow flow;
+    ApiCall call;
+    AsyncHttpGet zoneGet[2]; // Zones and source are independent, so they are fetched side by side
+    AsyncHttpGet sourceGet;
+    ResponseFingerprint zoneSeen[2]; // Last responses parsed, so unchanged ones can be skipped
+    ResponseFingerprint sourceSeen;
+    ResponseFingerprint streamSeen;
+    bool fetchZones;
+    bool fetchSource;
+    String streamID; // Stream the source was last seen playing
+    String sourceName;
+    String albumArt; // Art reference waiting on its download
+    uint32_t changed;
+};
+RefreshFlow refreshFlow = {};
+
+// Art reference of the image currently in /albumart.bmp. Only touched by the refresh flow.
+String downloadedAlbumart = "";
+uint32_t artCacheHits = 0;   // Stream polls whose art was already downloaded
+uint32_t artCacheMisses = 0; // Stream polls that needed new art
+
+// Start an AmpliPi GET alongside any others in flight. Asks for a 304 if the last response
+// seen still stands.
+void startApiGet(AsyncHttpGet &get, const ResponseFingerprint &seen, const String &request)
+{
+    if (!apiStartPoll(get, amplipiHost, apiCodec, seen, request))
+        Serial.println("[HTTP] GET " + request + " could not start");
+}
 
-    if (streamID == "0")
+// Collect a GET started with startApiGet(). Returns false if it failed.
+bool takeApiGet(AsyncHttpGet &get, const String &request, String &json)
+{
+    bool unreachable = get.unreachable();
+    NetEndpoint endpoint = netEndpoint(request);
+    if (get.connectUs()) { netTimings.add(endpoint, NET_CONNECT, get.connectUs()); }
+    if (get.ttfbUs()) { netTimings.add(endpoint, NET_TTFB, get.ttfbUs()); }
+    if (get.bodyUs()) { netTimings.add(endpoint, NET_BODY, get.bodyUs()); }
+    bool ok = get.take(json);
+    netTimings.request(endpoint, ok);
+#if DEBUGAPIREQ
+    Serial.printf("[HTTP] GET %s... code: %d in %u ms\n", request.c_str(), get.status(), (unsigned)get.elapsed());
+#endif
+    if (ok)
     {
-        // Local Input
-        streamSong = "Local Input";
-        streamName = currentSourceName;
-        albumArt = "local";
+        apiCodec.received(json);
+        setApiReachable(true);
     }
-    else
+    else if (unreachable)
     {
-        // Streaming Input
-        String json = requestAPI("streams/" + streamID);
+        Serial.println("[HTTP] GET " + request + " failed");
+        setApiReachable(false);
+    }
+    return ok;
+}
 
-        // DynamicJsonDocument<N> allocates memory on the heap
-        DynamicJsonDocument ampSourceStatus(2000);
+// Collect a polled GET and compare it with the last response seen
+ResponseChange takePolledGet(AsyncHttpGet &get, ResponseFingerprint &seen, const String &request, String &json)
+{
+    return apiTakePoll(get, seen, request, json, takeApiGet);
+}
 
-        // Deserialize the JSON document
-        DeserializationError error = deserializeJson(ampSourceStatus, json);
+FlowStatus runRefreshFlow(RefreshFlow &f)
+{
+    String json;
+    String streamID;
+    StreamState update = {};
+
+    FLOW_BEGIN(f.flow);
+    Serial.println("Refreshing metadata");
+
+    // Zones and source, all at once. The source tells us the stream and is needed before
+    // the first stream poll.
+    f.changed = 0;
+    f.fetchZones = pollScheduler.due(POLL_ZONES, millis());
+    f.fetchSource = pollScheduler.due(POLL_SOURCE, millis());
+    if (f.fetchZones)
+    {
+        startApiGet(f.zoneGet[0], f.zoneSeen[0], "zones/" + String(amplipiZone1));
+        if (amplipiZone2Enabled) { startApiGet(f.zoneGet[1], f.zoneSeen[1], "zones/" + String(amplipiZone2)); } // Two Zone Mode
+    }
+    if (f.fetchSource) { startApiGet(f.sourceGet, f.sourceSeen, "sources/" + String(amplipiSource)); }
 
-        // Test if parsing succeeds.
-        if (error)
-        {
-            Serial.print(F("deserializeJson() failed: "));
-            Serial.println(error.f_str());
-            return;
-        }
+    FLOW_AWAIT(f.flow, (!f.fetchZones || (f.zoneGet[0].finished() && (!amplipiZone2Enabled || f.zoneGet[1].finished())))
+                       && (!f.fetchSource || f.sourceGet.finished()));
 
-        streamArtist = ampSourceStatus["info"]["artist"].as<String>();
-        if (streamArtist == "null")
-        {
-            streamArtist = "";
-        }
-        streamAlbum = ampSourceStatus["info"]["album"].as<String>();
-        if (streamAlbum == "null")
-        {
-            streamAlbum = "";
-        }
-        streamSong = ampSourceStatus["info"]["song"].as<String>();
-        if (streamSong == "null")
+    if (f.fetchZones)
+    {
+        if (takePolledGet(f.zoneGet[0], f.zoneSeen[0], "zones/" + String(amplipiZone1), json) == RESPONSE_NEW) { f.changed |= parseZone(0, json); }
+        if (amplipiZone2Enabled && (takePolledGet(f.zoneGet[1], f.zoneSeen[1], "zones/" + String(amplipiZone2), json) == RESPONSE_NEW)) { f.changed |= parseZone(1, json); }
+        pollScheduler.polled(POLL_ZONES, millis(), f.changed != 0);
+    }
+
+    if (f.fetchSource)
+    {
+        switch (takePolledGet(f.sourceGet, f.sourceSeen, "sources/" + String(amplipiSource), json))
         {
-            streamSong = "";
+        case RESPONSE_NEW: streamID = parseSource(json, f.sourceName); break;
+        case RESPONSE_UNCHANGED: streamID = f.streamID; break; // Still playing the same stream
+        default: break;
         }
-        streamStatus = ampSourceStatus["status"].as<String>();
-        if (streamStatus == "null")
+    }
+
+    // A failed fetch or parse, or an idle source, is no change of stream
+    if (!followSource(pollScheduler, millis(), f.fetchSource, streamID, f.streamID)) { FLOW_EXIT(f.flow); }
+
+    if (!pollScheduler.due(POLL_STREAM, millis())) { FLOW_EXIT(f.flow); }
+
+    if (f.streamID == "0")
+    {
+        // Local Input, nothing to fetch
+        copyText(update.song, sizeof(update.song), "Local Input");
+        copyText(update.name, sizeof(update.name), f.sourceName.c_str());
+        copyText(update.albumArt, sizeof(update.albumArt), "local");
+        publishStream(update);
+        f.albumArt = update.albumArt;
+        f.streamSeen.forget(); // The screen no longer shows the stream
+        pollScheduler.setPlaying(false);
+        pollScheduler.reschedule(POLL_STREAM, millis());
+    }
+    else
+    {
+        // Streaming Input
+        f.call = apiJobs.submit(API_GET, "streams/" + f.streamID);
+        FLOW_AWAIT(f.flow, apiJobs.finished(f.call));
+        if (!apiJobs.take(f.call, json))
         {
-            streamStatus = "";
+            pollScheduler.polled(POLL_STREAM, millis(), false);
+            FLOW_EXIT(f.flow);
         }
-        streamName = ampSourceStatus["name"].as<String>();
-        if (streamName == "null")
+        if (f.streamSeen.same("streams/" + f.streamID, json))
         {
-            streamName = "";
+            pollScheduler.polled(POLL_STREAM, millis(), false); // Nothing new to parse or draw
         }
-        albumArt = ampSourceStatus["info"]["img_url"].as<String>();
-        if (albumArt == "null")
+        else
         {
-            albumArt = "";
+            if (!parseStream(json, update))
+            {
+                f.streamSeen.forget();
+                pollScheduler.polled(POLL_STREAM, millis(), false);
+                FLOW_EXIT(f.flow);
+            }
+            pollScheduler.setPlaying(strcmp(update.status, "playing") == 0);
+            f.changed = publishStream(update);
+            if (f.changed & STATE_STREAM_META) { pollScheduler.trackChanged(millis()); }
+            pollScheduler.polled(POLL_STREAM, millis(), f.changed != 0);
+            f.albumArt = update.albumArt;
         }
     }
 
-    // Update source name if it has changed
-    if (streamName != sourceName)
-    {
-        sourceName = streamName;
-        updateSource = true;
-        drawSource();
-    }
-
-    // Only refresh screen if we have new data
-    if (currentArtist != streamArtist || currentSong != streamSong || currentStatus != streamStatus)
+    // Download and refresh album art if it has changed. A download that was cut short is
+    // retried here even when the stream itself hasn't changed.
+    if (f.albumArt == downloadedAlbumart) { ++artCacheHits; }
+    else
     {
-        Serial.println("Printing artist and song on screen.");
-        currentArtist = streamArtist;
-        currentSong = streamSong;
-        currentStatus = streamStatus;
-        drawMetadata();
+        ++artCacheMisses;
+        f.call = apiJobs.submit(API_DOWNLOAD, f.streamID);
+        FLOW_AWAIT(f.flow, apiJobs.finished(f.call));
+        if (apiJobs.take(f.call, json))
+        {
+            downloadedAlbumart = f.albumArt;
+            publishAlbumart(f.albumArt.c_str());
+        }
     }
 
-    // Download and refresh album art if it has changed
-    if (albumArt != currentAlbumArt)
-    {
-        currentAlbumArt = albumArt;
-        updateAlbumart = true;
-        downloadAlbumart(streamID);
-        drawAlbumart();
-    }
+    FLOW_END(f.flow);
+}
 
+void cancelRefreshFlow()
+{
+    refreshFlow.zoneGet[0].abort();
+    refreshFlow.zoneGet[1].abort();
+    refreshFlow.sourceGet.abort();
+    apiJobs.cancel(refreshFlow.call);
+    FLOW_STOP(refreshFlow.flow);
 }
 
 
-//------------------------------------------------------------------------------------------
-//------------------------------------------------------------------------------------------
-void setup(void)
+// Load the current page of the source selection screen
+struct SourceListFlow
 {
-    Serial.begin(115200);
-    Serial.println("AmpliPi System Startup");
+    Flow flow;
+    ApiCall call;
+};
+SourceListFlow sourceListFlow = {};
 
-    // Initialize screen
-    tft.init();
-    Serial.println("Screen initialized");
+FlowStatus runSourceListFlow(SourceListFlow &f)
+{
+    String json;
 
-    // Set the rotation before we calibrate
-    tft.setRotation(0);
+    FLOW_BEGIN(f.flow);
+    Serial.println("Loading source list.");
 
-    // Wrap test at right and bottom of screen
-    tft.setTextWrap(true, true);
+    f.call = apiJobs.submit(API_GET, ""); // Requesting /api/
+    FLOW_AWAIT(f.flow, apiJobs.finished(f.call));
+    apiJobs.take(f.call, json);
+    parseSourceList(json);
+    sourcesLoading = false;
+    redrawScreen = true;
 
-    tft.setFreeFont(FSS18);
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    FLOW_END(f.flow);
+}
 
-    // Call screen calibration
-    //  This also handles formatting the filesystem if it hasn't been formatted yet
-    touch_calibrate();
+void startSourceListFlow()
+{
+    apiJobs.cancel(sourceListFlow.call);
+    sourcesLoading = true;
+    redrawScreen = true;
+    FLOW_START(sourceListFlow.flow);
+}
 
-    // clear screen
-    tft.fillScreen(TFT_BLACK);
-    tft.setTextDatum(TL_DATUM);
-    tft.setCursor(60, 40, 2);
-    tft.setFreeFont(FSS18);
+void cancelSourceListFlow()
+{
+    apiJobs.cancel(sourceListFlow.call);
+    FLOW_STOP(sourceListFlow.flow);
+    sourcesLoading = false;
+}
 
-    tft.print("Ampli");
-    tft.setTextColor(TFT_RED, TFT_BLACK);
-    tft.println("Pi");
-    tft.setTextColor(TFT_WHITE, TFT_BLACK);
-    tft.setFreeFont(FSS12);
-    tft.setCursor(70, 100, 2);
-    tft.println("Welcome");
-    tft.println("");
 
-    // Load config file from WifiManager. This gives up our Wifi settings and AmpliPi settings (if they've been set).
-    //  Otherwise, it starts the web server so the settings can be configured.
-    loadFileFSConfigFile();
+// Switch the source to a stream, then refresh the metadata screen to show it
+struct SelectSourceFlow
+{
+    Flow flow;
+    ApiCall call;
+    int streamID;
+};
+SelectSourceFlow selectSourceFlow = {};
+
+bool refreshNow = true; // Poll everything now instead of waiting for the poll scheduler, set at boot too
+
+FlowStatus runSelectSourceFlow(SelectSourceFlow &f)
+{
+    String json;
+    StaticJsonDocument<JSON_OBJECT_SIZE(1) + 24> doc; // Room for a copy of the input string
+
+    FLOW_BEGIN(f.flow);
+
+    doc["input"] = "stream=" + String(f.streamID);
+    serializeJson(doc, json);
+    Serial.println(json);
+    f.call = apiJobs.submit(API_PATCH, "sources/" + String(amplipiSource), json);
+    FLOW_AWAIT(f.flow, apiJobs.finished(f.call));
+    Serial.print("selectSource result: ");
+    Serial.println(apiJobs.take(f.call, json));
+
+    // Any refresh already running started before the switch
+    cancelRefreshFlow();
+    refreshNow = true;
+
+    FLOW_END(f.flow);
+}
+
+void startSelectSourceFlow(int streamID)
+{
+    apiJobs.cancel(selectSourceFlow.call);
+    selectSourceFlow.streamID = streamID;
+    FLOW_START(selectSourceFlow.flow);
+}
+
+
+// Give each running flow a turn
+void runFlows()
+{
+    HEAP_SCOPE(HEAP_FLOWS);
+    if (refreshFlow.flow.active) { runRefreshFlow(refreshFlow); }
+    if (sourceListFlow.flow.active) { runSourceListFlow(sourceListFlow); }
+    if (selectSourceFlow.flow.active) { runSelectSourceFlow(selectSourceFlow); }
+}
+
+
+/*******************************************/
+/* Frame rendering, driven by FRAME_INTERVAL */
+/*******************************************/
+
+// Draw the whole active screen. The per-element flags are set so the rest of the frame fills it in.
+void drawScreen()
+{
+    TRACE_SCOPE("drawScreen");
+    switch (activeScreen)
+    {
+    case SCREEN_METADATA:
+        clearMainArea();
+        updateMute1 = true;
+        updateMute2 = true;
+        updateVol1 = true;
+        updateVol2 = true;
+        updateMetadata = true;
+        updateAlbumart = true;
+        break;
+    case SCREEN_SOURCE:
+        drawSourceSelection();
+        break;
+    case SCREEN_SETTING:
+        drawSettings();
+        updateSettingValues = false;
+        break;
+    default:
+        break;
+    }
+    updateWarning = true;
+    redrawScreen = false;
+}
+
+// Draw everything that changed since the last frame. Mute, volume and warnings are cheap
+// and give touch feedback, so they always draw. Source bar, metadata and album art wait
+// for a later frame once this one is over budget.
+void renderFrame()
+{
+    TRACE_SCOPE("renderFrame");
+    HEAP_SCOPE(HEAP_DRAW);
+    frameScheduler.beginFrame(micros());
+
+    // Pick up whatever has been published since the last frame
+    uint32_t changed = stateStore.acquire();
+    const KeypadState &state = stateStore.current();
+    if (changed & STATE_ZONE1_MUTE) { updateMute1 = true; }
+    if (changed & STATE_ZONE1_VOL) { updateVol1 = true; }
+    if (changed & STATE_ZONE2_MUTE) { updateMute2 = true; }
+    if (changed & STATE_ZONE2_VOL) { updateVol2 = true; }
+    if (changed & STATE_SOURCE_NAME) { updateSource = true; }
+    if (changed & STATE_STREAM_META) { updateMetadata = true; }
+    if (changed & STATE_ART) { updateAlbumart = true; }
+    if (changed & STATE_LINK) { updateWarning = true; }
+    stateSnapshot.changed(changed, millis());
+
+    if (redrawScreen)
+    {
+        drawScreen();
+    }
+
+    if (activeScreen == SCREEN_METADATA)
+    {
+        bool zone1 = state.zones[0].valid;
+        bool zone2 = amplipiZone2Enabled && state.zones[1].valid;
+        if (zone1 && updateMute1) { drawMuteBtn(1); }
+        if (zone2 && updateMute2) { drawMuteBtn(2); }
+        if (zone1 && updateVol1) { drawVolume(1); }
+        if (zone2 && updateVol2) { drawVolume(2); }
+    }
+    else if (activeScreen == SCREEN_SETTING && updateSettingValues)
+    {
+        drawZone1Setting();
+        drawZone2Setting();
+        drawSourceSetting();
+        updateSettingValues = false;
+    }
+
+    if (updateWarning)
+    {
+        drawWarning();
+    }
+
+    if (updateSource && state.stream.valid)
+    {
+        if (frameScheduler.withinBudget(micros())) { drawSource(); }
+        else { frameScheduler.defer(); }
+    }
+
+    if (activeScreen == SCREEN_METADATA && state.stream.valid)
+    {
+        if (updateMetadata)
+        {
+            if (frameScheduler.withinBudget(micros()))
+            {
+                drawMetadata();
+                if (!state.stale) { bootTiming.finish(); }
+            }
+            else { frameScheduler.defer(); }
+        }
+        if (updateAlbumart)
+        {
+            if (frameScheduler.withinBudget(micros())) { drawAlbumart(); }
+            else { frameScheduler.defer(); }
+        }
+    }
+
+    frameScheduler.endFrame(micros());
+    interactions.framePushed(micros());
+}
+
+void printFrameStats()
+{
+    const FrameStats &stats = frameScheduler.stats();
+    Serial.printf("Frames: %u, avg %u us, max %u us, over budget %u, deferred %u\n",
+                  (unsigned)stats.frames, (unsigned)frameScheduler.averageUs(), (unsigned)stats.maxUs,
+                  (unsigned)stats.overBudget, (unsigned)stats.deferred);
+    frameScheduler.resetPeak();
+}
+
+void printPollStats()
+{
+    uint32_t now = millis();
+    for (uint8_t r = 0; r < POLL_RESOURCES; r++)
+    {
+        PollResource resource = (PollResource)r;
+        const PollCounters &stats = pollScheduler.stats(resource);
+        Serial.printf("Poll %s: %u requests, %u changed, every %u ms\n", PollScheduler::name(resource),
+                      (unsigned)stats.requests, (unsigned)stats.changes, (unsigned)pollScheduler.interval(resource, now));
+    }
+}
+
+// GET /metrics, on the async_tcp task. The counters are read while the UI and network
+// tasks carry on updating them, which at worst mixes values a moment apart.
+void serveMetrics(AsyncWebServerRequest *request)
+{
+    HEAP_SCOPE(HEAP_WEB);
+    AsyncResponseStream *response = request->beginResponseStream(METRICS_CONTENT_TYPE);
+    MetricsWriter metrics(*response);
+
+    metrics.gauge("keypad_uptime_seconds", "Time since the keypad started", millis() / 1000.0);
+    metrics.gauge("keypad_heap_free_bytes", "Free heap", ESP.getFreeHeap());
+    metrics.gauge("keypad_heap_min_free_bytes", "Lowest free heap since the keypad started", ESP.getMinFreeHeap());
+    metrics.gauge("keypad_heap_largest_free_bytes", "Largest block the heap can allocate", ESP.getMaxAllocHeap());
+    metrics.gauge("keypad_heap_fragmentation_ratio", "Share of the free heap outside the largest block, at the last sample", heapMonitor.fragmentation());
+    HeapTrend freeTrend = heapMonitor.trend(false);
+    HeapTrend blockTrend = heapMonitor.trend(true);
+    if (freeTrend.valid)
+    {
+        metrics.gauge("keypad_heap_free_trend_bytes_per_hour", "Fitted change in free heap over the last hour", freeTrend.bytesPerHour);
+        metrics.gauge("keypad_heap_largest_free_trend_bytes_per_hour", "Fitted change in the largest free block over the last hour", blockTrend.bytesPerHour);
+    }
+#if HEAP_PROFILE
+    metrics.heapProfile("keypad_heap");
+#endif
+
+    metrics.boot("keypad_boot", bootTiming);
+    metrics.network("keypad_api", netTimings);
+
+    metrics.counter("keypad_loop_iterations_total", "Passes through loop()", loopStats.iterations);
+    metrics.counter("keypad_loop_seconds_total", "Time spent in loop()", loopStats.totalUs / 1e6);
+    metrics.gauge("keypad_loop_max_seconds", "Longest loop() pass in the current stats interval", loopStats.maxUs / 1e6);
+
+    const FrameStats &frames = frameScheduler.stats();
+    metrics.counter("keypad_frames_total", "Frames rendered", frames.frames);
+    metrics.counter("keypad_frame_seconds_total", "Time spent rendering frames", frames.totalUs / 1e6);
+    metrics.gauge("keypad_frame_max_seconds", "Longest frame in the current stats interval", frames.maxUs / 1e6);
+    metrics.counter("keypad_frames_over_budget_total", "Frames that ran past the frame budget", frames.overBudget);
+    metrics.counter("keypad_frame_draws_deferred_total", "Draws pushed to a later frame by the budget", frames.deferred);
+
+    bool connected = wifiLink.connected();
+    metrics.gauge("keypad_wifi_connected", "1 while WiFi is connected", connected ? 1 : 0);
+    if (connected) { metrics.gauge("keypad_wifi_rssi_dbm", "WiFi signal strength", WiFi.RSSI()); }
+    metrics.counter("keypad_wifi_reconnects_total", "Times WiFi was lost and reconnected", wifiLink.reconnects());
+
+    metrics.counter("keypad_art_cache_hits_total", "Stream polls whose album art was already downloaded", artCacheHits);
+    metrics.counter("keypad_art_cache_misses_total", "Stream polls that needed new album art", artCacheMisses);
+
+    request->send(response);
+}
+
+void beginMetrics()
+{
+    metricsServer.on(METRICS_PATH, HTTP_GET, serveMetrics);
+    metricsServer.begin();
+}
+
+
+// Change screens. Whatever the old screen still had in flight is cancelled.
+void setActiveScreen(Screen screen)
+{
+    if (screen != activeScreen)
+    {
+        switch (activeScreen)
+        {
+        case SCREEN_METADATA:
+            cancelRefreshFlow();
+            break;
+        case SCREEN_SOURCE:
+            cancelSourceListFlow();
+            break;
+        default:
+            break;
+        }
+        activeScreen = screen;
+    }
+    metadata_refresh = (screen == SCREEN_METADATA);
+    redrawScreen = true;
+}
+
+// Go back to the main metadata screen, for example after a source is picked or settings are closed
+void showMetadataScreen()
+{
+    currentSourceOffset = 0;
+    setActiveScreen(SCREEN_METADATA);
+    refreshNow = true;
+}
+
+// Put the last known state from flash on screen, marked stale until AmpliPi confirms it.
+// Returns false if there was nothing to restore.
+bool restoreSnapshot()
+{
+    KeypadState restored = {};
+    if (!stateSnapshot.restore(restored)) { return false; }
+
+    Serial.println("Restored last known state");
+    stateStore.publish([&restored](KeypadState &state) -> uint32_t {
+        state = restored;
+        return STATE_ZONE1_MUTE | STATE_ZONE1_VOL | STATE_ZONE2_MUTE | STATE_ZONE2_VOL |
+               STATE_SOURCE_NAME | STATE_STREAM_META | STATE_ART | STATE_LINK;
+    });
+
+    // /albumart.bmp still holds the art the snapshot refers to, no need to fetch it again
+    downloadedAlbumart = restored.stream.albumArt;
+
+    tft.fillScreen(TFT_BLACK);
+    updateSource = true;
+    renderFrame();
+    return true;
+}
+
+
+/*******************/
+/* Touch recording */
+/*******************/
+
+#if TOUCH_RECORD
+// Print what was recorded before the last restart, then start recording from now
+void beginTouchRecord()
+{
+#if TOUCH_RECORD == 2
+    fs::File previous = SPIFFS.open(TOUCH_RECORD_FILE, "r");
+    if (previous)
+    {
+        Serial.println("Touches recorded before this boot:");
+        while (previous.available())
+        {
+            Serial.print("touchprev ");
+            Serial.println(previous.readStringUntil('\n'));
+        }
+        previous.close();
+        SPIFFS.remove(TOUCH_RECORD_FILE);
+    }
+#endif
+    touchRecorder.begin(millis());
+}
+
+void recordTouch(bool pressed, uint16_t x, uint16_t y)
+{
+    char line[TOUCH_RECORD_LINE];
+    if (!touchRecorder.sample(millis(), pressed, x, y, line, sizeof(line)))
+        return;
+    Serial.print("touchrec ");
+    Serial.println(line);
+#if TOUCH_RECORD == 2
+    fs::File f = SPIFFS.open(TOUCH_RECORD_FILE, "a");
+    if (f && (f.size() < TOUCH_RECORD_MAX_BYTES)) { f.println(line); }
+    f.close();
+#endif
+}
+#endif
+
+void printInteractionSummary()
+{
+    interactions.report(Serial, micros(), true);
+    interactions.summary(Serial);
+}
+
+#if NATIVE_HOST
+void onHostExit()
+{
+    printInteractionSummary();
+    TRACE_DUMP(Serial);
+}
+#endif
+
+
+/**********************************/
+/* Touch handlers, one per region */
+/**********************************/
+
+void toggleMute(int zone)
+{
+    int index = zone - 1;
+    bool mute = !stateStore.current().zones[index].mute;
+    stateStore.publish([index, mute](KeypadState &state) -> uint32_t {
+        state.zones[index].mute = mute;
+        return STATE_ZONE_MUTE(index) | STATE_ZONE_VOL(index);
+    });
+    refreshFlow.zoneSeen[index].forget(); // Parse the next poll even if AmpliPi didn't take the change
+    sendMuteUpdate(zone, mute);
+    Serial.println("Mute button hit.");
+}
+
+void setVolumeFromTouch(uint16_t x, int zone)
+{
+    int index = zone - 1;
+    float volPercent = volumeFromX(x);
+    stateStore.publish([index, volPercent](KeypadState &state) -> uint32_t {
+        state.zones[index].volPercent = volPercent;
+        return STATE_ZONE_VOL(index);
+    });
+    refreshFlow.zoneSeen[index].forget(); // Parse the next poll even if AmpliPi didn't take the change
+    sendVolUpdate(zone, volPercent);
+    Serial.println("Volume control hit.");
+}
+
+// Metadata screen
+void onOpenSources(uint16_t /*x*/, uint16_t /*y*/)
+{
+    setActiveScreen(SCREEN_SOURCE);
+    startSourceListFlow();
+}
+
+// The upper mute and volume rows only exist in Two Zone Mode. The lower rows control
+// zone 2 in Two Zone Mode and zone 1 in One Zone Mode.
+void onMuteUpper(uint16_t /*x*/, uint16_t /*y*/)
+{
+    if (amplipiZone2Enabled) { toggleMute(1); }
+}
+
+void onMuteLower(uint16_t /*x*/, uint16_t /*y*/)
+{
+    toggleMute(amplipiZone2Enabled ? 2 : 1);
+}
+
+void onVolumeUpper(uint16_t x, uint16_t /*y*/)
+{
+    if (amplipiZone2Enabled) { setVolumeFromTouch(x, 1); }
+}
+
+void onVolumeLower(uint16_t x, uint16_t /*y*/)
+{
+    setVolumeFromTouch(x, amplipiZone2Enabled ? 2 : 1);
+}
+
+// Source Selection screen
+void onCloseSources(uint16_t /*x*/, uint16_t /*y*/)
+{
+    showMetadataScreen();
+}
+
+void onPickSource(uint16_t /*x*/, uint16_t y)
+{
+    int streamID = selectSource(y);
+    if (streamID >= 0)
+    {
+        startSelectSourceFlow(streamID);
+    }
+    showMetadataScreen();
+}
+
+void onPrevSources(uint16_t /*x*/, uint16_t /*y*/)
+{
+    // Show previous set of streams
+    currentSourceOffset = currentSourceOffset - SOURCES_PER_PAGE;
+    if (currentSourceOffset < 0) { currentSourceOffset = 0; }
+    startSourceListFlow();
+}
+
+void onNextSources(uint16_t /*x*/, uint16_t /*y*/)
+{
+    // Show next set of streams
+    currentSourceOffset = currentSourceOffset + SOURCES_PER_PAGE;
+    startSourceListFlow();
+}
+
+void onOpenSettings(uint16_t /*x*/, uint16_t /*y*/)
+{
+    // Start editing from the saved settings
+    newAmplipiZone1 = atoi(amplipiZone1);
+    newAmplipiZone2 = atoi(amplipiZone2);
+    newAmplipiSource = atoi(amplipiSource);
+
+    setActiveScreen(SCREEN_SETTING);
+}
+
+// Settings screen
+void onZone1Down(uint16_t /*x*/, uint16_t /*y*/)
+{
+    if (newAmplipiZone1 > 0) { --newAmplipiZone1; }
+    updateSettingValues = true;
+}
+
+void onZone1Up(uint16_t /*x*/, uint16_t /*y*/)
+{
+    if (newAmplipiZone1 < 3) { ++newAmplipiZone1; }
+    updateSettingValues = true;
+}
+
+void onZone2Down(uint16_t /*x*/, uint16_t /*y*/)
+{
+    if (newAmplipiZone2 > -1) { --newAmplipiZone2; } // -1 disables Zone 2
+    updateSettingValues = true;
+}
+
+void onZone2Up(uint16_t /*x*/, uint16_t /*y*/)
+{
+    if (newAmplipiZone2 < 3) { ++newAmplipiZone2; }
+    updateSettingValues = true;
+}
+
+void onSourceDown(uint16_t /*x*/, uint16_t /*y*/)
+{
+    if (newAmplipiSource > 0) { --newAmplipiSource; }
+    updateSettingValues = true;
+}
+
+void onSourceUp(uint16_t /*x*/, uint16_t /*y*/)
+{
+    if (newAmplipiSource < 3) { ++newAmplipiSource; }
+    updateSettingValues = true;
+}
+
+void onResetWiFi(uint16_t /*x*/, uint16_t /*y*/)
+{
+    // Forget the WiFi networks and AmpliPi settings and reboot. Calibration and tuning stay.
+    memset(&WM_config, 0, sizeof(WM_config));
+    strncpy(amplipiHost, "amplipi.local", sizeof(amplipiHost) - 1);
+    strncpy(amplipiZone1, "0", sizeof(amplipiZone1) - 1);
+    strncpy(amplipiZone2, "-1", sizeof(amplipiZone2) - 1);
+    strncpy(amplipiSource, "0", sizeof(amplipiSource) - 1);
+    saveSettings();
+    WiFi.disconnect(false, true); // Also erase the credentials the WiFi driver keeps
+    ESP.restart();
+}
+
+void onRecalibrate(uint16_t /*x*/, uint16_t /*y*/)
+{
+    // Clear the stored calibration and reboot
+    settings.touchCalValid = false;
+    saveSettings();
+    ESP.restart();
+}
+
+void onSaveSettings(uint16_t /*x*/, uint16_t /*y*/)
+{
+    sprintf(amplipiZone1, "%d", newAmplipiZone1);
+    sprintf(amplipiZone2, "%d", newAmplipiZone2);
+    sprintf(amplipiSource, "%d", newAmplipiSource);
+    saveSettings();
+
+    // If amplipiZone2 is 0 or great, Zone 2 should be enabled
+    amplipiZone2Enabled = (newAmplipiZone2 >= 0);
+
+    showMetadataScreen();
+}
+
+void onCancelSettings(uint16_t /*x*/, uint16_t /*y*/)
+{
+    showMetadataScreen();
+}
+
+
+/*************************************/
+/* Touch layout for each screen      */
+/*************************************/
+constexpr HitRegion metadataRegions[] = {
+    hitButton(SRCBUTTON_X, SRCBUTTON_Y, SRCBUTTON_W, SRCBUTTON_H, onOpenSources),
+    hitButton(MUTE_X, MUTE1_Y, MUTE_W, MUTE_H, onMuteUpper),
+    hitButton(MUTE_X, MUTE2_Y, MUTE_W, MUTE_H, onMuteLower),
+    hitButton(VOLBARZONE_X, VOLBARZONE1_Y, VOLBARZONE_W, VOLBARZONE_H, onVolumeUpper),
+    hitButton(VOLBARZONE_X, VOLBARZONE2_Y, VOLBARZONE_W, VOLBARZONE_H, onVolumeLower),
+};
+
+constexpr HitRegion sourceRegions[] = {
+    hitButton(SRCBUTTON_X, SRCBUTTON_Y, SRCBUTTON_W, SRCBUTTON_H, onCloseSources),
+    hitBounds(0, (MAINZONE_Y + 1), HITGRID_SCREEN_W, (RIGHTBUTTON_Y + 1), onPickSource), // Anything between source bar and Prev/Next buttons
+    hitButton(LEFTBUTTON_X, LEFTBUTTON_Y, LEFTBUTTON_W, LEFTBUTTON_H, onPrevSources),
+    hitButton(RIGHTBUTTON_X, RIGHTBUTTON_Y, RIGHTBUTTON_W, RIGHTBUTTON_H, onNextSources),
+    hitButton(SETTINGBUTTON_X, SETTINGBUTTON_Y, SETTINGBUTTON_W, SETTINGBUTTON_H, onOpenSettings),
+};
+
+constexpr HitRegion settingRegions[] = {
+    hitBounds(161, 41, 200, 81, onZone1Down),
+    hitBounds(201, 41, 240, 81, onZone1Up),
+    hitBounds(161, 81, 200, 121, onZone2Down),
+    hitBounds(201, 81, 240, 121, onZone2Up),
+    hitBounds(161, 121, 200, 161, onSourceDown),
+    hitBounds(201, 121, 240, 161, onSourceUp),
+    hitBounds(0, 190, HITGRID_SCREEN_W, 230, onResetWiFi),
+    hitBounds(0, 230, HITGRID_SCREEN_W, 271, onRecalibrate),
+    hitButton(LEFTBUTTON_X, LEFTBUTTON_Y, LEFTBUTTON_W, LEFTBUTTON_H, onSaveSettings),
+    hitButton(RIGHTBUTTON_X, RIGHTBUTTON_Y, RIGHTBUTTON_W, RIGHTBUTTON_H, onCancelSettings),
+};
+
+#define HIT_LAYOUT(name, regions, grid) {name, regions, sizeof(regions) / sizeof(regions[0]), &grid}
+
+constexpr HitGrid metadataGrid = buildHitGrid(metadataRegions);
+constexpr HitGrid sourceGrid = buildHitGrid(sourceRegions);
+constexpr HitGrid settingGrid = buildHitGrid(settingRegions);
+
+// Indexed by Screen
+const ScreenLayout screenLayouts[SCREEN_COUNT] = {
+    HIT_LAYOUT("metadata", metadataRegions, metadataGrid),
+    HIT_LAYOUT("source", sourceRegions, sourceGrid),
+    HIT_LAYOUT("setting", settingRegions, settingGrid),
+};
+
+
+/******************************************************************/
+/* Render harness: every screen and transition from fixed data    */
+/******************************************************************/
+#if RENDER_HARNESS
+
+#define HARNESS_SPI_HZ 40000000 // SPI_FREQUENCY in User_Setup.h, for the transfer time estimate
+#define HARNESS_MAX_FRAMES 8    // Frames a step may take to finish work deferred by the frame budget
+
+uint8_t harnessFailures = 0;
+
+// Write a 120x120 gradient as the album art, so art draws the same pixels on every run
+void writeHarnessAlbumart(uint8_t shade)
+{
+    const uint16_t size = 120;
+    const uint32_t rowBytes = size * 3;
+    uint8_t header[54] = {'B', 'M'};
+    uint32_t fields[] = {54 + rowBytes * size, 0, 54, 40, size, size};
+    memcpy(header + 2, fields, sizeof(fields));
+    header[26] = 1;  // Planes
+    header[28] = 24; // Bits per pixel
+
+    fs::File f = SPIFFS.open("/albumart.bmp", "w");
+    f.write(header, sizeof(header));
+    uint8_t row[rowBytes];
+    for (uint16_t y = 0; y < size; y++)
+    {
+        for (uint16_t x = 0; x < size; x++)
+        {
+            row[x * 3] = shade + x;         // Blue
+            row[x * 3 + 1] = y * 2;         // Green
+            row[x * 3 + 2] = 255 - x - y;   // Red
+        }
+        f.write(row, rowBytes);
+    }
+    f.close();
+}
+
+// True while the active screen still has parts to draw
+bool renderPending()
+{
+    if (redrawScreen || updateWarning || updateSource)
+        return true;
+    return (activeScreen == SCREEN_METADATA) && (updateMetadata || updateAlbumart || updateMute1 || updateVol1);
+}
+
+// Run a step, render until it is all on screen, then report what was drawn as one JSON
+// line and check the screen against the step's golden frame
+template <typename Step>
+void renderStep(const char *name, Step step)
+{
+#if NATIVE_HOST
+    tft.resetBusStats();
+#endif
+    uint32_t startedAt = micros();
+    step();
+    uint8_t frames = 0;
+    do
+    {
+        renderFrame();
+        ++frames;
+    } while (renderPending() && (frames < HARNESS_MAX_FRAMES));
+    uint32_t elapsed = micros() - startedAt;
+
+    Serial.printf("{\"render\":\"%s\",\"us\":%u,\"frames\":%u", name, (unsigned)elapsed, (unsigned)frames);
+#if NATIVE_HOST
+    const TFT_BusStats &bus = tft.busStats();
+    uint32_t differing;
+    NativeHost::GoldenResult golden = NativeHost::checkGolden(name, differing);
+    if ((golden == NativeHost::GOLDEN_DIFFERS) || (golden == NativeHost::GOLDEN_MISSING)) { ++harnessFailures; }
+    Serial.printf(",\"windows\":%u,\"pixels\":%llu,\"spi_bytes\":%llu,\"spi_us\":%llu,\"golden\":\"%s\",\"differing\":%u",
+                  (unsigned)bus.windows, (unsigned long long)bus.pixels, (unsigned long long)bus.bytes,
+                  (unsigned long long)(bus.bytes * 8 * 1000000ULL / HARNESS_SPI_HZ), NativeHost::goldenResultName(golden), (unsigned)differing);
+#endif
+    Serial.println("}");
+}
+
+// Publish a change to the shown state, as the network side would
+template <typename Apply>
+void harnessPublish(uint32_t changes, Apply apply)
+{
+    stateStore.publish([changes, &apply](KeypadState &state) -> uint32_t {
+        apply(state);
+        return changes;
+    });
+}
+
+void runRenderHarness()
+{
+    Serial.println("Render harness");
+
+    // The icons come from data/, found relative to the working directory. Without them
+    // every frame would differ from its golden frame, or be saved as one without icons.
+    for (Icon &icon : icons)
+    {
+        if (icon.pixels.load() == nullptr)
+        {
+            Serial.printf("{\"render\":\"error\",\"missing\":\"%s\"}\n", icon.filename);
+            ++harnessFailures;
+        }
+    }
+    if (harnessFailures)
+    {
+        Serial.println("Icons missing: run from the repository root, or set KEYPAD_FS_DATA to its data directory");
+        return;
+    }
+
+    amplipiZone2Enabled = true;
+    writeHarnessAlbumart(0);
+    tft.fillScreen(TFT_BLACK);
+
+    renderStep("metadata", []() {
+        harnessPublish(0xFFFFFFFF, [](KeypadState &state) {
+            state = KeypadState{};
+            state.zones[0] = ZoneState{true, false, 50.0f};
+            state.zones[1] = ZoneState{true, true, 25.0f};
+            state.stream.valid = true;
+            copyText(state.stream.name, sizeof(state.stream.name), "Groove Salad");
+            copyText(state.stream.song, sizeof(state.stream.song), "Kerala");
+            copyText(state.stream.artist, sizeof(state.stream.artist), "Bonobo");
+            copyText(state.stream.album, sizeof(state.stream.album), "Migration");
+            copyText(state.stream.status, sizeof(state.stream.status), "playing");
+            copyText(state.stream.albumArt, sizeof(state.stream.albumArt), "harness-0");
+            state.wifiConnected = true;
+        });
+        updateSource = true;
+        setActiveScreen(SCREEN_METADATA);
+    });
+
+    renderStep("volume_zone1", []() {
+        harnessPublish(STATE_ZONE1_VOL, [](KeypadState &state) { state.zones[0].volPercent = 75.0f; });
+    });
+
+    renderStep("mute_zone2", []() {
+        harnessPublish(STATE_ZONE2_MUTE, [](KeypadState &state) { state.zones[1].mute = false; });
+    });
+
+    renderStep("track_change", []() {
+        harnessPublish(STATE_STREAM_META, [](KeypadState &state) {
+            copyText(state.stream.song, sizeof(state.stream.song), "Roygbiv and a title long enough to be cut short");
+            copyText(state.stream.artist, sizeof(state.stream.artist), "Boards of Canada");
+        });
+    });
+
+    renderStep("album_art", []() {
+        writeHarnessAlbumart(128);
+        publishAlbumart("harness-1");
+    });
+
+    renderStep("source_name", []() {
+        harnessPublish(STATE_SOURCE_NAME, [](KeypadState &state) {
+            copyText(state.stream.name, sizeof(state.stream.name), "Kitchen Pandora");
+        });
+    });
+
+    renderStep("warning", []() { setApiReachable(false); });
+    renderStep("warning_cleared", []() { setApiReachable(true); });
+
+    renderStep("one_zone", []() {
+        amplipiZone2Enabled = false;
+        setActiveScreen(SCREEN_METADATA);
+    });
+    amplipiZone2Enabled = true;
+
+    renderStep("sources_loading", []() {
+        sourcesLoading = true;
+        setActiveScreen(SCREEN_SOURCE);
+    });
+
+    renderStep("sources", []() {
+        sourcesLoading = false;
+        currentSourceOffset = 0;
+        totalStreams = SOURCES_PER_PAGE + 2;
+        sourcesOnPage = SOURCES_PER_PAGE;
+        const char *names[SOURCES_PER_PAGE] = {"Kitchen AirPlay", "Kitchen Pandora", "Spotify", "DLNA", "Groove Salad", "Patio Bluetooth"};
+        for (int i = 0; i < SOURCES_PER_PAGE; i++)
+        {
+            sourceIDs[i] = 1000 + i;
+            sourceNames[i] = names[i];
+        }
+        redrawScreen = true;
+    });
+
+    renderStep("sources_page2", []() {
+        currentSourceOffset = SOURCES_PER_PAGE;
+        sourcesOnPage = 2;
+        sourceIDs[0] = 1006;
+        sourceNames[0] = "Office Radio";
+        sourceIDs[1] = 1007;
+        sourceNames[1] = "Garage Bluetooth";
+        redrawScreen = true;
+    });
+
+    renderStep("settings", []() {
+        newAmplipiZone1 = 1;
+        newAmplipiZone2 = -1;
+        newAmplipiSource = 0;
+        setActiveScreen(SCREEN_SETTING);
+    });
+
+    renderStep("settings_value", []() {
+        newAmplipiZone2 = 2;
+        updateSettingValues = true;
+    });
+
+    renderStep("back_to_metadata", []() { setActiveScreen(SCREEN_METADATA); });
+
+    Serial.printf("{\"render\":\"done\",\"failures\":%u}\n", (unsigned)harnessFailures);
+}
+
+#endif
+
+
+//------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------
+void setup(void)
+{
+    Serial.begin(115200);
+    Serial.println("AmpliPi System Startup");
+
+    // Keypads in the same house shouldn't poll in step. The low bytes of the MAC are the same
+    //  vendor prefix on every unit, so seed from the device-specific bytes above it.
+    pollScheduler.seed((uint32_t)(ESP.getEfuseMac() >> 24) ^ esp_random());
+
+    // The file system and the screen come up side by side, then the icons load in the
+    //  background while the screen is calibrated. Anything that draws stays on this task.
+    bootPipeline.begin();
+    bootPipeline.start(BOOT_STORAGE, "storage", loadStorage);
+    bootPipeline.run(BOOT_DISPLAY, "display", initDisplay);
+    bootPipeline.start(BOOT_ASSETS, "assets", preloadIcons, BOOT_STORAGE);
+
+    // Call screen calibration
+    bootPipeline.run(BOOT_CALIBRATE, "calibrate", touch_calibrate, BOOT_STORAGE);
+    amplipiZone2Enabled = (atoi(amplipiZone2) >= 0);
+
+#if RENDER_HARNESS
+    bootPipeline.wait(BOOT_ASSETS);
+    runRenderHarness();
+#if NATIVE_HOST
+    NativeHost::stop(harnessFailures ? 1 : 0);
+    return;
+#else
+    while (true) { delay(1000); }
+#endif
+#endif
+
+#if NATIVE_HOST
+    NativeHost::onExit(onHostExit);
+#endif
+
+    // Show the last known state straight away if we have one, otherwise a welcome screen
+    uint8_t snapshotPhase = bootTiming.begin("snapshot");
+    bool instantOn = restoreSnapshot();
+    bootTiming.end(snapshotPhase);
+    if (!instantOn)
+    {
+        // clear screen
+        tft.fillScreen(TFT_BLACK);
+        tft.setTextDatum(TL_DATUM);
+        tft.setCursor(60, 40, 2);
+        tft.setFreeFont(FSS18);
+
+        tft.print("Ampli");
+        tft.setTextColor(TFT_RED, TFT_BLACK);
+        tft.println("Pi");
+        tft.setTextColor(TFT_WHITE, TFT_BLACK);
+        tft.setFreeFont(FSS12);
+        tft.setCursor(70, 100, 2);
+        tft.println("Welcome");
+        tft.println("");
+    }
+
+    // The WiFiManager parameters start out with the config.json settings. If none have been
+    //  set, it starts the web server so the settings can be configured.
+    uint8_t configPhase = bootTiming.begin("config");
     ESPAsync_WMParameter custom_amplipiHost ("amplipiHost",  "amplipiHost",  amplipiHost,  AMPLIPIHOST_LEN + 1);
     ESPAsync_WMParameter custom_amplipiZone1("amplipiZone1", "amplipiZone1", amplipiZone1, AMPLIPIZONE_LEN + 1);
     ESPAsync_WMParameter custom_amplipiZone2("amplipiZone2", "amplipiZone2", amplipiZone2, AMPLIPIZONE_LEN + 1);
     ESPAsync_WMParameter custom_amplipiSource("amplipiSource", "amplipiSource", amplipiSource, AMPLIPIZONE_LEN + 1);
-    unsigned long startedAt = millis();
     
     //Local intialization. Once its business is done, there is no need to keep it around
     // Use this to default DHCP hostname to ESP8266-XXXXXX or ESP32-XXXXXX
@@ -1736,13 +2941,16 @@ void setup(void)
     if ( (Router_SSID != "") && (Router_Pass != "") )
     {
         //LOGERROR3(F("* Add SSID = "), Router_SSID, F(", PW = "), Router_Pass);
-        wifiMulti.addAP(Router_SSID.c_str(), Router_Pass.c_str());
+        addWiFiCredential(Router_SSID.c_str(), Router_Pass.c_str());
 
         ESPAsync_wifiManager.setConfigPortalTimeout(120); //If no access point name has been previously entered disable timeout.
         Serial.println(F("Got ESP Self-Stored Credentials. Timeout 120s for Config Portal"));
-        tft.setCursor(10, 300, 2);
-        tft.setFreeFont(FSS9);
-        tft.println("Connecting to the network");
+        if (!instantOn)
+        {
+            tft.setCursor(10, 300, 2);
+            tft.setFreeFont(FSS9);
+            tft.println("Connecting to the network");
+        }
     }
     else if (loadConfigData())
     {
@@ -1750,9 +2958,12 @@ void setup(void)
 
         ESPAsync_wifiManager.setConfigPortalTimeout(120); //If no access point name has been previously entered disable timeout.
         Serial.println(F("Got stored Credentials. Timeout 120s for Config Portal")); 
-        tft.setCursor(10, 300, 2);
-        tft.setFreeFont(FSS9);
-        tft.println("Connecting to the network");
+        if (!instantOn)
+        {
+            tft.setCursor(10, 300, 2);
+            tft.setFreeFont(FSS9);
+            tft.println("Connecting to the network");
+        }
     }
     else
     {
@@ -1769,6 +2980,8 @@ void setup(void)
         //tft.println(AP_PASS.c_str());
     }
 
+    bootTiming.end(configPhase);
+
     if (initialConfig)
     {
         Serial.println(F("We don't have any access point credentials, so get them now"));
@@ -1807,7 +3020,7 @@ void setup(void)
             if ( (String(WM_config.WiFi_Creds[i].wifi_ssid) != "") && (strlen(WM_config.WiFi_Creds[i].wifi_pw) >= MIN_AP_PASSWORD_SIZE) )
             {
                 //LOGERROR3(F("* Add SSID = "), WM_config.WiFi_Creds[i].wifi_ssid, F(", PW = "), WM_config.WiFi_Creds[i].wifi_pw );
-                wifiMulti.addAP(WM_config.WiFi_Creds[i].wifi_ssid, WM_config.WiFi_Creds[i].wifi_pw);
+                addWiFiCredential(WM_config.WiFi_Creds[i].wifi_ssid, WM_config.WiFi_Creds[i].wifi_pw);
             }
         }
 
@@ -1815,11 +3028,9 @@ void setup(void)
     }
     else
     {
-        wifiMulti.addAP(Router_SSID.c_str(), Router_Pass.c_str());
+        addWiFiCredential(Router_SSID.c_str(), Router_Pass.c_str());
     }
 
-    startedAt = millis();
-
     if (!initialConfig)
     {
         // Load stored data, the addAP ready for MultiWiFi reconnection
@@ -1832,30 +3043,9 @@ void setup(void)
             if ( (String(WM_config.WiFi_Creds[i].wifi_ssid) != "") && (strlen(WM_config.WiFi_Creds[i].wifi_pw) >= MIN_AP_PASSWORD_SIZE) )
             {
                 //LOGERROR3(F("* Add SSID = "), WM_config.WiFi_Creds[i].wifi_ssid, F(", PW = "), WM_config.WiFi_Creds[i].wifi_pw );
-                wifiMulti.addAP(WM_config.WiFi_Creds[i].wifi_ssid, WM_config.WiFi_Creds[i].wifi_pw);
+                addWiFiCredential(WM_config.WiFi_Creds[i].wifi_ssid, WM_config.WiFi_Creds[i].wifi_pw);
             }
         }
-
-        if ( WiFi.status() != WL_CONNECTED ) 
-        {
-            Serial.println(F("ConnectMultiWiFi in setup"));
-
-            connectMultiWiFi();
-        }
-    }
-
-    Serial.print(F("After waiting "));
-    Serial.print((float) (millis() - startedAt) / 1000L);
-    Serial.print(F(" secs more in setup(), connection result is "));
-
-    if (WiFi.status() == WL_CONNECTED)
-    {
-        Serial.print(F("connected. Local IP: "));
-        Serial.println(WiFi.localIP());
-    }
-    else
-    {
-        Serial.println(ESPAsync_wifiManager.getStatus(WiFi.status()));
     }
 
     //read updated parameters
@@ -1872,29 +3062,69 @@ void setup(void)
     if (atoi(amplipiZone2) >= 0) { amplipiZone2Enabled = true; }
     else { amplipiZone2Enabled = false; }
 
-    //save the custom parameters to FS
+    //save the custom parameters
     if (shouldSaveConfig)
     {
-        saveFileFSConfigFile();
+        saveSettings();
     }
 
+    // Start the network task that runs requests to AmpliPi
+    apiJobs.begin(runApiJob);
 
-    // Clear screen
-    tft.fillScreen(TFT_BLACK);
-    tft.setCursor(0, 20, 2);
+    // Wait for whatever is still running in the background
+    bootPipeline.wait(BOOT_ASSETS);
+
+    // Start connecting, unless the config portal already has. From here on check_WiFi() in
+    // loop() moves the connection along, so the screen takes touches while it associates.
+    if (WiFi.status() != WL_CONNECTED) { wifiBootPhase = bootTiming.begin("wifi"); }
+    wifiLink.begin();
+
+    // Clear screen. A restored state stays up, unless the config portal drew over it.
+    if (!instantOn || initialConfig)
+    {
+        tft.fillScreen(TFT_BLACK);
+        tft.setCursor(0, 20, 2);
+        redrawScreen = true;
+        updateSource = true;
+    }
+
+#if TOUCH_RECORD
+    beginTouchRecord();
+#endif
 }
 //------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------
 void loop()
 {
+    TRACE_ITERATION("loop");
+    uint32_t loopStartedUs = micros();
     uint16_t x, y;
+
+    // The metrics server starts once setup()'s config portal server is gone, as they share a port
+    static bool metricsStarted = false;
+    if (!metricsStarted)
+    {
+        beginMetrics();
+        metricsStarted = true;
+    }
     
-    // WiFiManager status check
-    check_status();
+    // WiFi status check, never blocks
+    check_WiFi();
 
-    // See if there's any touch data for us
-    if (tft.getTouch(&x, &y))
+    // See if there's any touch data for us, ignoring touches until the debounce time has passed
+    static unsigned long lastTouchTime = 0;
+    bool debounced = (millis() - lastTouchTime >= settings.touchDebounce);
+#if TOUCH_RECORD
+    // Read every pass while recording, so the touches the debounce drops are recorded too
+    bool pressed = tft.getTouch(&x, &y);
+    recordTouch(pressed, x, y);
+    if (debounced && pressed)
+#else
+    if (debounced && tft.getTouch(&x, &y))
+#endif
     {
+        lastTouchTime = millis();
+
         // Draw a block spot to show where touch was calculated to be
         //tft.fillCircle(x, y, 2, TFT_BLUE);
         Serial.print("X: ");
@@ -1903,336 +3133,66 @@ void loop()
         Serial.println(y);
 
         // Touch screen control
+        const ScreenLayout &layout = screenLayouts[activeScreen];
+        Serial.print("Current screen: ");
+        Serial.println(layout.name);
 
-        // Main Metadata screen
-        if (activeScreen == "metadata")
+        const HitRegion *region = hitTest(layout, x, y);
+        if (region)
         {
-            Serial.println("Current screen: metadata");
-
-            // Source Select
-            if ((x > SRCBUTTON_X) && (x < (SRCBUTTON_X + SRCBUTTON_W)))
-            {
-                if ((y > SRCBUTTON_Y) && (y <= (SRCBUTTON_Y + SRCBUTTON_H)))
-                {
-                    activeScreen = "source";
-                    drawSourceSelection();
-                }
-            }
-
-            // Mute button
-            if ((x > MUTE_X) && (x < (MUTE_X + MUTE_W)))
-            {
-                if (amplipiZone2Enabled && (y > MUTE1_Y) && (y <= (MUTE1_Y + MUTE_H)))
-                {
-                    // Two Zone Mode, upper section
-                    if (muteZone1) { muteZone1 = false; }
-                    else { muteZone1 = true; }
-                    updateMute1 = true;
-                    updateVol1 = true;
-                    drawMuteBtn(1);
-                    sendMuteUpdate(1);
-                }
-                else if ((y > MUTE2_Y) && (y <= (MUTE2_Y + MUTE_H)))
-                {
-                    if (amplipiZone2Enabled) {
-                        // Two Zone Mode, lower section
-                        if (muteZone2) { muteZone2 = false; }
-                        else { muteZone2 = true; }
-                        updateMute2 = true;
-                        updateVol2 = true;
-                        drawMuteBtn(2);
-                        sendMuteUpdate(2);
-                    }
-                    else {
-                        // One Zone Mode
-                        if (muteZone1) { muteZone1 = false; }
-                        else { muteZone1 = true; }
-                        updateMute1 = true;
-                        updateVol1 = true;
-                        drawMuteBtn(1);
-                        sendMuteUpdate(1);
-                    }
-                }
-                Serial.print("Mute button hit.");
-            }
-
-            // Volume control
-            if ((x > VOLBARZONE_X) && (x < (VOLBARZONE_X + VOLBARZONE_W)))
-            {
-                if (amplipiZone2Enabled && (y > VOLBARZONE1_Y) && (y <= (VOLBARZONE1_Y + VOLBARZONE_H)))
-                {
-                    // Two Zone Mode, upper section
-                    updateVol1 = true;
-                    volPercent1 = (x - 35) / 1.5;
-                    drawVolume(x, 1);
-                    sendVolUpdate(1);
-                }
-                else if ((y > VOLBARZONE2_Y) && (y <= (VOLBARZONE2_Y + VOLBARZONE_H)))
-                {
-                    if (amplipiZone2Enabled) {
-                        // Two Zone Mode, lower section
-                        updateVol2 = true;
-                        volPercent2 = (x - 35) / 1.5;
-                        drawVolume(x, 2);
-                        sendVolUpdate(2);
-                    }
-                    else {
-                        // One Zone Mode
-                        updateVol1 = true;
-                        volPercent1 = (x - 35) / 1.5;
-                        drawVolume(x, 1);
-                        sendVolUpdate(1);
-                    }
-                }
-                Serial.print("Volume control hit.");
-            }
-            
-            delay(200); // Debounce
+            interactions.begin(micros(), x, y, layout.name);
+            region->handler(x, y);
+            interactions.handled(micros());
+            pollScheduler.interaction(millis()); // Someone's here, keep what they see fresh
         }
-        else if (activeScreen == "source")
-        {
-            // Source Selection screen
-            Serial.println("Current screen: source");
-            
-            // Source Select button (cancel source select)
-            if ((x > SRCBUTTON_X) && (x < (SRCBUTTON_X + SRCBUTTON_W)))
-            {
-                if ((y > SRCBUTTON_Y) && (y <= (SRCBUTTON_Y + SRCBUTTON_H)))
-                {
-                    // Reload main metadata screen
-                    activeScreen = "metadata";
-                    metadata_refresh = true;
-                    updateMute1 = true;
-                    updateMute2 = true;
-                    updateAlbumart = true;
-                    updateVol1 = true;
-                    updateVol2 = true;
-                    currentSourceOffset = 0;
-
-                    clearMainArea();
-                    if (amplipiZone2Enabled) {
-                        drawMuteBtn(1);
-                        drawMuteBtn(2);
-                    }
-                    else {
-                        drawMuteBtn(1);
-                    }
-                    drawMetadata();
-                    drawAlbumart();
-                }
-            }
-
-            // Select source (anything between source bar and Prev/Next buttons)
-            if ((y > 36) && (y <= RIGHTBUTTON_Y))
-            {
-                selectSource(y);
-
-                // Reload main metadata screen
-                activeScreen = "metadata";
-                metadata_refresh = true;
-                updateMute1 = true;
-                updateMute2 = true;
-                updateAlbumart = true;
-                updateVol1 = true;
-                updateVol2 = true;
-                currentSourceOffset = 0;
-
-                clearMainArea();
-                if (amplipiZone2Enabled) {
-                    drawMuteBtn(1);
-                    drawMuteBtn(2);
-                }
-                else {
-                    drawMuteBtn(1);
-                }
-                drawMetadata();
-                drawAlbumart();
-            }
-            
-            // Previous list of sources
-            if ((x > LEFTBUTTON_X) && (x < (LEFTBUTTON_X + LEFTBUTTON_W)))
-            {
-                if ((y > LEFTBUTTON_Y) && (y <= (LEFTBUTTON_Y + LEFTBUTTON_H)))
-                {
-                    // Show previous set of streams
-                    currentSourceOffset = currentSourceOffset - 6;
-                    if (currentSourceOffset < 0) { currentSourceOffset = 0; }
-                    drawSourceSelection();
-                }
-            }
-            
-            // Next list of sources
-            if ((x > RIGHTBUTTON_X) && (x < (RIGHTBUTTON_X + RIGHTBUTTON_W)))
-            {
-                if ((y > RIGHTBUTTON_Y) && (y <= (RIGHTBUTTON_Y + RIGHTBUTTON_H)))
-                {
-                    // Show next set of streams
-                    currentSourceOffset = currentSourceOffset + 6;
-                    drawSourceSelection();
-                }
-            }
-
-            // Settings screen
-            if ((x > SETTINGBUTTON_X) && (x < (SETTINGBUTTON_X + SETTINGBUTTON_W)))
-            {
-                if ((y > SETTINGBUTTON_Y) && (y <= (SETTINGBUTTON_Y + SETTINGBUTTON_H)))
-                {
-                    // Show settings screen
-                    activeScreen = "setting";
-                    drawSettings();
-                }
-            }
-
-            delay(200); // Debounce
-        }
-        else if (activeScreen == "setting")
-        {
-            // Zone 1 Change
-            if ((y > 40) && (y <= 80))
-            {
-                if ((x > 160) && (x < 200)) { --newAmplipiZone1; } // Decrement zone number
-                else if ((x > 200) && (x < 240)) { ++newAmplipiZone1; } // Increment zone number
-
-                if (newAmplipiZone1 < 0) { newAmplipiZone1 = 0; }
-                else if (newAmplipiZone1 > 3) { newAmplipiZone1 = 3; }
+    }
+    interactions.report(Serial, micros());
 
-                tft.fillRect(0, 41, 160, 38, TFT_BLACK);
-                tft.drawString("Zone 1: " + String(newAmplipiZone1), 5, 50);
-            }
-            // Zone 2 Change
-            else if ((y > 80) && (y <= 120))
-            {
-                if ((x > 160) && (x < 200)) { --newAmplipiZone2; } // Decrement zone number
-                else if ((x > 200) && (x < 240)) { ++newAmplipiZone2; } // Increment zone number
-
-                if (newAmplipiZone2 < -1) { newAmplipiZone2 = -1; }
-                else if (newAmplipiZone2 > 3) { newAmplipiZone2 = 3; }
-                
-                String thisZone;
-                if (newAmplipiZone2 < 0) { thisZone = "None"; }
-                else { thisZone = String(newAmplipiZone2); }
-
-                tft.fillRect(0, 81, 160, 38, TFT_BLACK);
-                tft.drawString("Zone 2: " + thisZone, 5, 90);
-            }
-            // Source Change
-            else if ((y > 120) && (y <= 160))
-            {
-                if ((x > 160) && (x < 200)) { --newAmplipiSource; } // Decrement source number
-                else if ((x > 200) && (x < 240)) { ++newAmplipiSource; } // Increment source number
+#if TRACE
+    // Print the trace buffer on request, for chrome://tracing or Perfetto
+    if (Serial.available() && (Serial.read() == 't')) { TRACE_DUMP(Serial); }
+#endif
 
-                if (newAmplipiSource < 0) { newAmplipiSource = 0; }
-                else if (newAmplipiSource > 3) { newAmplipiSource = 3; }
+    // Metadata refresh loop, whenever any resource is due a poll
+    if (refreshNow)
+    {
+        pollScheduler.pollNow(millis());
+        refreshNow = false;
+    }
+    if (metadata_refresh && !refreshFlow.flow.active && wifiLink.connected() && pollScheduler.anyDue(millis()))
+    {
+        FLOW_START(refreshFlow.flow);
+    }
 
-                tft.fillRect(0, 121, 160, 38, TFT_BLACK);
-                tft.drawString("Source: " + String(newAmplipiSource), 5, 130);
-            }
+    // Move any multi-step interactions along
+    runFlows();
 
-            // Reset WiFi & AmpliPi URL
-            if ((y >= 190) && (y < 230))
-            {
-                // Delete WiFi and Config settings file and reboot
-                if (SPIFFS.exists(configFileName))
-                {
-                    // Delete if we want to re-calibrate
-                    SPIFFS.remove(configFileName);
-                }
-                WiFi.disconnect();
-                ESP.restart();
-            }
+    // Write the last known state to flash once it has settled
+    stateSnapshot.tick(millis(), stateStore.current());
 
-            // Re-calibrate Touchscreen
-            if ((y >= 230) && (y <= 270))
-            {
-                // Delete TouchCalData file and reboot
-                if (SPIFFS.exists(CALIBRATION_FILE))
-                {
-                    // Delete if we want to re-calibrate
-                    SPIFFS.remove(CALIBRATION_FILE);
-                }
-                ESP.restart();
-            }
-
-            // Save Changes
-            if ((x > LEFTBUTTON_X) && (x < (LEFTBUTTON_X + LEFTBUTTON_W)))
-            {
-                if ((y > LEFTBUTTON_Y) && (y <= (LEFTBUTTON_Y + LEFTBUTTON_H)))
-                {
-                    // Save Settings
-                    sprintf(amplipiZone1, "%d", newAmplipiZone1);
-                    sprintf(amplipiZone2, "%d", newAmplipiZone2);
-                    sprintf(amplipiSource, "%d", newAmplipiSource);
-                    saveFileFSConfigFile();
-                    
-                    // If amplipiZone2 is 0 or great, Zone 2 should be enabled
-                    if (newAmplipiSource >= 0) { amplipiZone2Enabled = true; }
-                    else { amplipiZone2Enabled = false; }
-
-                    // Reload main metadata screen
-                    activeScreen = "metadata";
-                    metadata_refresh = true;
-                    updateMute1 = true;
-                    updateMute2 = true;
-                    updateAlbumart = true;
-                    updateVol1 = true;
-                    updateVol2 = true;
-                    currentSourceOffset = 0;
-
-                    clearMainArea();
-                    if (amplipiZone2Enabled) {
-                        drawMuteBtn(1);
-                        drawMuteBtn(2);
-                    }
-                    else {
-                        drawMuteBtn(1);
-                    }
-                    drawMetadata();
-                    drawAlbumart();
-                }
-            }
-            
-            // Cancel Changes
-            if ((x > RIGHTBUTTON_X) && (x < (RIGHTBUTTON_X + RIGHTBUTTON_W)))
-            {
-                if ((y > RIGHTBUTTON_Y) && (y <= (RIGHTBUTTON_Y + RIGHTBUTTON_H)))
-                {
-                    // Reload main metadata screen
-                    activeScreen = "metadata";
-                    metadata_refresh = true;
-                    updateMute1 = true;
-                    updateMute2 = true;
-                    updateAlbumart = true;
-                    updateVol1 = true;
-                    updateVol2 = true;
-                    currentSourceOffset = 0;
-
-                    clearMainArea();
-                    if (amplipiZone2Enabled) {
-                        drawMuteBtn(1);
-                        drawMuteBtn(2);
-                    }
-                    else {
-                        drawMuteBtn(1);
-                    }
-                    drawMetadata();
-                    drawAlbumart();
-                }
-            }
-            delay(200); // Debounce
-        }
+    // Draw whatever changed, once per frame
+    if (frameScheduler.frameDue(millis()))
+    {
+        renderFrame();
     }
 
-    // Metadata refresh loop
-    static unsigned long lastRefreshTime = 0;
-    if (millis() - lastRefreshTime >= REFRESH_INTERVAL)
+    if (heapMonitor.due(millis())) { heapMonitor.sample(millis(), ESP.getFreeHeap(), ESP.getMaxAllocHeap(), Serial); }
+
+    static unsigned long lastFrameStatsTime = 0;
+    if (millis() - lastFrameStatsTime >= FRAME_STATS_INTERVAL)
     {
-        if (metadata_refresh) {
-            Serial.println("Refreshing metadata");
-            getZone();
-            getStream(String(amplipiSource));
-        }
-        lastRefreshTime += REFRESH_INTERVAL;
+        printFrameStats();
+        printPollStats();
+        netTimings.report(Serial);
+        heapMonitor.report(Serial);
+#if HEAP_PROFILE
+        heapProfileReport.print(Serial);
+#endif
+        loopStats.resetPeak();
+        lastFrameStatsTime += FRAME_STATS_INTERVAL;
     }
 
+    loopStats.add(micros() - loopStartedUs);
+
 }
 //------------------------------------------------------------------------------------------
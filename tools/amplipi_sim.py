@@ -0,0 +1,452 @@
+#!/usr/bin/env python3
+"""Local AmpliPi stand-in for testing keypads under stress
+
+Serves the parts of the AmpliPi API the keypad uses:
+
+    GET   /api/                     full status
+    GET   /api/zones/<id>
+    GET   /api/sources/<id>
+    GET   /api/streams/<id>
+    GET   /api/streams/image/<id>   album art as a 24-bit BMP
+    PATCH /api/zones/<id>
+    PATCH /api/sources/<id>
+
+Responses carry an ETag and honour If-None-Match, and are gzipped when the client asks.
+MessagePack is spoken only if the msgpack module is installed; without it a MessagePack
+PATCH gets 422, which is what stock AmpliPi answers a body it can't read as JSON.
+
+Faults are injected per request: fixed latency plus jitter, connection resets, stalls
+(the request is read and never answered) and oversized bodies padded with a junk field.
+They can be set on the command line, changed on the fly by PATCHing /sim/faults, or
+played from a scenario file of timed phases:
+
+    [{"at": 0, "latency_ms": 0},
+     {"at": 30, "latency_ms": 400, "jitter_ms": 200, "reset_rate": 0.05},
+     {"at": 90, "oversize_rate": 0.5, "oversize_bytes": 20000, "paths": "^/api/streams/"}]
+
+GET /sim/stats reports what the server has seen: requests, faults and errors per
+endpoint class, with latency percentiles. POST /sim/reset clears them.
+
+Run it next to the native build with
+
+    tools/amplipi_sim.py --port 8080 --streams 100 --latency-ms 200 --jitter-ms 100
+    .pio/build/native/program --amplipi localhost:8080
+
+or point a keypad's AmpliPi host at this machine.
+"""
+
+import argparse
+import functools
+import gzip
+import hashlib
+import http.server
+import json
+import random
+import re
+import socket
+import struct
+import sys
+import threading
+import time
+
+try:
+    import msgpack
+except ImportError:
+    msgpack = None
+
+FAULT_KEYS = ('latency_ms', 'jitter_ms', 'reset_rate', 'stall_rate', 'stall_ms',
+              'oversize_rate', 'oversize_bytes', 'error_rate', 'paths')
+
+STREAM_TYPES = ('airplay', 'pandora', 'spotify', 'dlna', 'internetradio', 'bluetooth')
+
+SONGS = (('Bonobo', 'Migration', 'Kerala'),
+         ('Tycho', 'Awake', 'Awake'),
+         ('Boards of Canada', 'Music Has the Right to Children', 'Roygbiv'),
+         ('Nightmares on Wax', 'Carboot Soul', 'Les Nuits'),
+         ('Thievery Corporation', 'The Mirror Conspiracy', 'Lebanese Blonde'))
+
+
+class Faults:
+    """Fault settings, swapped in whole so a request never sees half of an update"""
+
+    def __init__(self, **settings):
+        self.latency_ms = 0
+        self.jitter_ms = 0
+        self.reset_rate = 0.0
+        self.stall_rate = 0.0
+        self.stall_ms = 30000
+        self.oversize_rate = 0.0
+        self.oversize_bytes = 32768
+        self.error_rate = 0.0
+        self.paths = ''
+        self.update(settings)
+
+    def update(self, settings):
+        for key, value in settings.items():
+            if key not in FAULT_KEYS:
+                raise ValueError('unknown fault setting ' + key)
+            setattr(self, key, type(getattr(self, key))(value))
+        self.path_match = re.compile(self.paths) if self.paths else None
+
+    def applies(self, path):
+        return self.path_match is None or self.path_match.search(path) is not None
+
+    def as_dict(self):
+        return {key: getattr(self, key) for key in FAULT_KEYS}
+
+
+class Stats:
+    """Per endpoint class counters and service times"""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with self.lock:
+            self.started = time.monotonic()
+            self.classes = {}
+
+    def record(self, endpoint, outcome, elapsed_ms):
+        with self.lock:
+            entry = self.classes.setdefault(endpoint, {'requests': 0, 'outcomes': {}, 'ms': []})
+            entry['requests'] += 1
+            entry['outcomes'][outcome] = entry['outcomes'].get(outcome, 0) + 1
+            entry['ms'].append(elapsed_ms)
+
+    def report(self):
+        with self.lock:
+            seconds = max(time.monotonic() - self.started, 0.001)
+            classes = {}
+            total = 0
+            for endpoint, entry in sorted(self.classes.items()):
+                total += entry['requests']
+                errors = sum(n for outcome, n in entry['outcomes'].items() if outcome not in ('200', '304'))
+                classes[endpoint] = {
+                    'requests': entry['requests'],
+                    'rate_per_s': round(entry['requests'] / seconds, 2),
+                    'error_rate': round(errors / entry['requests'], 4),
+                    'outcomes': entry['outcomes'],
+                    'latency_ms': percentiles(entry['ms']),
+                }
+            return {'seconds': round(seconds, 1), 'requests': total,
+                    'rate_per_s': round(total / seconds, 2), 'endpoints': classes}
+
+
+def percentiles(samples):
+    if not samples:
+        return {}
+    ordered = sorted(samples)
+
+    def at(fraction):
+        return round(ordered[min(len(ordered) - 1, int(fraction * len(ordered)))], 1)
+
+    return {'p50': at(0.50), 'p90': at(0.90), 'p99': at(0.99), 'max': round(ordered[-1], 1)}
+
+
+def endpoint_class(path):
+    """Which kind of request a path is, for the stats: status, zones, sources, streams, image"""
+    parts = path.split('?')[0].strip('/').split('/')
+    if parts[:1] != ['api']:
+        return 'other'
+    if len(parts) == 1 or parts[1] == '':
+        return 'status'
+    if parts[1] == 'streams' and len(parts) > 2 and parts[2] == 'image':
+        return 'image'
+    return parts[1]
+
+
+@functools.lru_cache(maxsize=256)
+def make_bmp(size, seed):
+    """A size x size 24-bit bottom-up BMP, a colour gradient picked by seed"""
+    rng = random.Random(seed)
+    base = [rng.randrange(256) for _ in range(3)]
+    padding = (4 - (size * 3) % 4) % 4
+    rows = []
+    for y in range(size):
+        row = bytearray()
+        for x in range(size):
+            row += bytes(((base[0] + x) & 0xFF, (base[1] + y) & 0xFF, (base[2] + x + y) & 0xFF))
+        rows.append(bytes(row) + b'\0' * padding)
+    pixels = b''.join(rows)
+    header = struct.pack('<2sIHHI', b'BM', 54 + len(pixels), 0, 0, 54)
+    info = struct.pack('<IiiHHIIiiII', 40, size, size, 1, 24, 0, len(pixels), 2835, 2835, 0, 0)
+    return header + info + pixels
+
+
+class AmpliPi:
+    """The system state, built like a real install and changed by PATCHes"""
+
+    def __init__(self, stream_count, song_seconds):
+        self.lock = threading.Lock()
+        self.song_seconds = song_seconds
+        self.started = time.monotonic()
+        self.streams = []
+        for n in range(stream_count):
+            kind = STREAM_TYPES[n % len(STREAM_TYPES)]
+            name = 'Stream %d' % (n + 1) if n >= 6 else ('Kitchen AirPlay', 'Kitchen Pandora', 'Spotify',
+                                                        'DLNA', 'Groove Salad', 'Patio Bluetooth')[n]
+            self.streams.append({'id': 1000 + n, 'name': name, 'type': kind, 'status': 'playing',
+                                 'info': {'name': '%s - %s' % (name, kind), 'state': 'playing'},
+                                 'browsable': False})
+        first = self.streams[0]['id'] if self.streams else 0
+        self.sources = [{'id': n, 'name': 'Input %d' % (n + 1),
+                         'input': 'stream=%d' % (first + n) if n < stream_count else 'local',
+                         'info': {}} for n in range(4)]
+        names = ('Living Room', 'Kitchen', 'Dining Room', 'Patio', 'Office', 'Garage')
+        self.zones = [{'id': n, 'name': names[n], 'source_id': 0, 'mute': False, 'disabled': False,
+                       'vol': -40, 'vol_f': 0.4936709, 'vol_min': -79, 'vol_max': 0} for n in range(6)]
+
+    def song(self, stream_id):
+        """What a stream is playing now. Songs change every song_seconds, at different times per stream."""
+        turn = int((time.monotonic() - self.started + stream_id * 7) / self.song_seconds)
+        artist, album, song = SONGS[(turn + stream_id) % len(SONGS)]
+        return {'artist': artist, 'album': album, 'song': song,
+                'img_url': 'static/imgs/%d-%d.bmp' % (stream_id, turn)}
+
+    def stream(self, stream_id):
+        for stream in self.streams:
+            if stream['id'] == stream_id:
+                found = json.loads(json.dumps(stream))
+                found['info'].update(self.song(stream_id))
+                return found
+        return None
+
+    def source(self, source_id):
+        if not 0 <= source_id < len(self.sources):
+            return None
+        source = json.loads(json.dumps(self.sources[source_id]))
+        if source['input'].startswith('stream='):
+            stream = self.stream(int(source['input'][7:]))
+            if stream is not None:
+                source['info'] = stream['info']
+        return source
+
+    def zone(self, zone_id):
+        return self.zones[zone_id] if 0 <= zone_id < len(self.zones) else None
+
+    def status(self):
+        return {'sources': [self.source(n) for n in range(len(self.sources))],
+                'zones': self.zones, 'groups': [],
+                'streams': [self.stream(s['id']) for s in self.streams],
+                'presets': [], 'info': {'version': '0.4.0', 'mock_ctrl': True, 'mock_streams': True,
+                                        'online': True}}
+
+    def patch(self, kind, item_id, changes):
+        with self.lock:
+            if kind == 'zones' and self.zone(item_id) is not None:
+                zone = self.zones[item_id]
+                for key in ('mute', 'vol', 'source_id', 'name', 'disabled'):
+                    if key in changes:
+                        zone[key] = changes[key]
+                if 'vol' in changes:
+                    zone['vol_f'] = round((zone['vol'] - zone['vol_min']) / (zone['vol_max'] - zone['vol_min']), 7)
+                return True
+            if kind == 'sources' and 0 <= item_id < len(self.sources):
+                for key in ('input', 'name'):
+                    if key in changes:
+                        self.sources[item_id][key] = changes[key]
+                return True
+        return False
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    server_version = 'AmpliPiSim/1.0'
+
+    def log_message(self, fmt, *args):
+        if self.server.verbose:
+            sys.stderr.write('%s %s\n' % (self.address_string(), fmt % args))
+
+    def do_GET(self):
+        self.handle_request('GET')
+
+    def do_PATCH(self):
+        self.handle_request('PATCH')
+
+    def do_POST(self):
+        self.handle_request('POST')
+
+    def handle_request(self, method):
+        started = time.monotonic()
+        path = self.path.split('?')[0]
+        endpoint = endpoint_class(path)
+        body = self.rfile.read(int(self.headers.get('Content-Length') or 0))
+
+        if path.startswith('/sim/'):
+            self.control(method, path, body)
+            return
+
+        faults = self.server.faults
+        outcome = self.inject(faults, path)
+        if outcome is None:
+            status, content, content_type = self.route(method, path, body)
+            if status == 200 and faults.applies(path) and random.random() < faults.oversize_rate:
+                content = self.oversize(content, content_type, faults.oversize_bytes)
+                outcome = 'oversize'
+            status = self.send(status, content, content_type)
+            outcome = outcome or str(status)
+        self.server.stats.record(endpoint, outcome, (time.monotonic() - started) * 1000.0)
+
+    def inject(self, faults, path):
+        """Apply latency, resets, stalls and errors. Returns the outcome if the request ends here."""
+        if not faults.applies(path):
+            return None
+        delay = faults.latency_ms + random.uniform(-faults.jitter_ms, faults.jitter_ms)
+        if delay > 0:
+            time.sleep(delay / 1000.0)
+        if random.random() < faults.reset_rate:
+            # Close with a zero linger so the client sees a reset rather than a clean close
+            self.connection.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack('ii', 1, 0))
+            self.close_connection = True
+            return 'reset'
+        if random.random() < faults.stall_rate:
+            time.sleep(faults.stall_ms / 1000.0)
+            self.close_connection = True
+            return 'stall'
+        if random.random() < faults.error_rate:
+            self.send(503, b'{"detail":"injected"}', 'application/json')
+            return '503'
+        return None
+
+    def route(self, method, path, body):
+        parts = path.strip('/').split('/')
+        sim = self.server.amplipi
+        if parts[:1] != ['api']:
+            return 404, b'{"detail":"Not Found"}', 'application/json'
+
+        if method == 'PATCH':
+            if len(parts) != 3 or not parts[2].isdigit():
+                return 404, b'{"detail":"Not Found"}', 'application/json'
+            content_type = self.headers.get('Content-Type', 'application/json')
+            if 'msgpack' in content_type:
+                if msgpack is None:
+                    return 422, b'{"detail":[{"msg":"value is not a valid dict","type":"type_error.dict"}]}', 'application/json'
+                changes = msgpack.unpackb(body)
+            else:
+                changes = json.loads(body or b'{}')
+            if not sim.patch(parts[1], int(parts[2]), changes):
+                return 404, b'{"detail":"Not Found"}', 'application/json'
+            return self.encode(sim.status())
+
+        if method != 'GET':
+            return 405, b'{"detail":"Method Not Allowed"}', 'application/json'
+        if len(parts) == 1:
+            return self.encode(sim.status())
+        if len(parts) == 4 and parts[1:3] == ['streams', 'image'] and parts[3].isdigit():
+            stream_id = int(parts[3])
+            if sim.stream(stream_id) is None:
+                return 404, b'{"detail":"Not Found"}', 'application/json'
+            # New art with every song, like a radio stream's cover changing
+            return 200, make_bmp(self.server.art_size, sim.stream(stream_id)['info']['img_url']), 'image/bmp'
+        if len(parts) == 3 and parts[2].isdigit():
+            found = {'zones': sim.zone, 'sources': sim.source, 'streams': sim.stream}.get(parts[1], lambda _: None)(int(parts[2]))
+            if found is not None:
+                return self.encode(found)
+        return 404, b'{"detail":"Not Found"}', 'application/json'
+
+    def encode(self, document):
+        accept = self.headers.get('Accept', '')
+        if msgpack is not None and 'application/msgpack' in accept:
+            return 200, msgpack.packb(document), 'application/msgpack'
+        return 200, json.dumps(document, separators=(',', ':')).encode(), 'application/json'
+
+    @staticmethod
+    def oversize(content, content_type, size):
+        if content_type != 'application/json':
+            return content + b'\0' * size
+        document = json.loads(content)
+        document['padding'] = 'x' * size
+        return json.dumps(document, separators=(',', ':')).encode()
+
+    def send(self, status, content, content_type):
+        etag = '"%s"' % hashlib.sha1(content).hexdigest()[:16]
+        if status == 200 and self.server.etags and self.headers.get('If-None-Match') == etag:
+            status, content = 304, b''
+        self.send_response(status)
+        self.send_header('Content-Type', content_type)
+        if status in (200, 304) and self.server.etags:
+            self.send_header('ETag', etag)
+        if content and self.server.gzip and 'gzip' in self.headers.get('Accept-Encoding', ''):
+            content = gzip.compress(content)
+            self.send_header('Content-Encoding', 'gzip')
+        self.send_header('Content-Length', str(len(content)))
+        self.end_headers()
+        if self.command != 'HEAD':
+            self.wfile.write(content)
+        return status
+
+    def control(self, method, path, body):
+        if path == '/sim/faults' and method == 'PATCH':
+            try:
+                faults = Faults(**self.server.faults.as_dict())
+                faults.update(json.loads(body or b'{}'))
+            except (ValueError, re.error) as error:
+                self.send(400, json.dumps({'detail': str(error)}).encode(), 'application/json')
+                return
+            self.server.faults = faults
+        if path == '/sim/reset' and method == 'POST':
+            self.server.stats.reset()
+        if path == '/sim/stats':
+            self.send(200, json.dumps(self.server.stats.report(), indent=1).encode(), 'application/json')
+            return
+        self.send(200, json.dumps(self.server.faults.as_dict()).encode(), 'application/json')
+
+
+class Server(http.server.ThreadingHTTPServer):
+    daemon_threads = True
+    request_queue_size = 256  # A fleet of keypads connects in bursts; the default of 5 drops SYNs
+
+
+def run_scenario(server, phases):
+    """Apply each phase's fault settings at its time, on top of the settings before it"""
+    started = time.monotonic()
+    for phase in sorted(phases, key=lambda p: p['at']):
+        time.sleep(max(0.0, phase['at'] - (time.monotonic() - started)))
+        faults = Faults(**server.faults.as_dict())
+        faults.update({k: v for k, v in phase.items() if k != 'at'})
+        server.faults = faults
+        print('t=%ss faults %s' % (phase['at'], json.dumps(faults.as_dict())), flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Local AmpliPi stand-in with fault injection')
+    parser.add_argument('--host', default='0.0.0.0')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--streams', type=int, default=6, help='streams in the install')
+    parser.add_argument('--song-seconds', type=float, default=60, help='how often each stream changes song')
+    parser.add_argument('--art-size', type=int, default=120, help='album art width and height')
+    parser.add_argument('--no-gzip', dest='gzip', action='store_false')
+    parser.add_argument('--no-etag', dest='etags', action='store_false')
+    parser.add_argument('--scenario', help='JSON file of timed fault phases')
+    parser.add_argument('--verbose', action='store_true', help='log every request')
+    for key in FAULT_KEYS:
+        default = getattr(Faults(), key)
+        parser.add_argument('--' + key.replace('_', '-'), type=type(default), default=default)
+    args = parser.parse_args()
+
+    server = Server((args.host, args.port), Handler)
+    server.amplipi = AmpliPi(args.streams, args.song_seconds)
+    server.faults = Faults(**{key: getattr(args, key) for key in FAULT_KEYS})
+    server.stats = Stats()
+    server.art_size = args.art_size
+    server.gzip = args.gzip
+    server.etags = args.etags
+    server.verbose = args.verbose
+
+    if args.scenario:
+        with open(args.scenario) as f:
+            phases = json.load(f)
+        threading.Thread(target=run_scenario, args=(server, phases), daemon=True).start()
+
+    print('AmpliPi simulator on %s:%d, %d streams%s' % (args.host, args.port, args.streams,
+          '' if msgpack else ', JSON only'), flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(json.dumps(server.stats.report(), indent=1))
+
+
+if __name__ == '__main__':
+    main()
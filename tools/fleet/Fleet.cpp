@@ -0,0 +1,511 @@
+// Fleet load generator: many virtual keypads polling one AmpliPi
+//
+//   pio run -e fleet
+//   FLEET_KEYPADS=50 FLEET_STRATEGY=etag .pio/build/fleet/program --amplipi localhost:8080 --run-ms 300000
+//
+// Each virtual keypad runs the keypad's refresh logic on a task of its own: a PollScheduler
+// decides what is due, zones and source are fetched together with AsyncHttpGet, the stream
+// with the same headers as requestAPI(), and the album art whenever the stream's art
+// changes. The requests, poll intervals and limits are the keypad's own, from
+// include/ApiClient.h. Touches arrive at random, most of them a volume PATCH and the rest a look at
+// the source list, and each one speeds up polling like a real touch does.
+//
+// Settings come from the environment:
+//   FLEET_KEYPADS          how many virtual keypads (10)
+//   FLEET_STRATEGY         fixed: everything every REFRESH_INTERVAL, like the original firmware
+//                          adaptive: the keypad's PollScheduler intervals, without ETags
+//                          etag: adaptive with If-None-Match, like the current firmware (default)
+//   FLEET_RAMP_MS          start the keypads evenly over this long, to find the knee (0)
+//   FLEET_TOUCHES_PER_HOUR per keypad (6)
+//   FLEET_ZONES            zones the keypads are spread over (6)
+//   FLEET_SOURCES          sources the keypads are spread over (4)
+//   FLEET_REPORT_MS        time between report lines (10000)
+//
+// Every report is one JSON line: the keypads running, then requests, rate, errors and
+// latency percentiles for each endpoint class over the last period. The last line covers
+// the whole run. When the target is tools/amplipi_sim.py its own /sim/stats are printed
+// as well, which is the load as the server saw it.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <math.h>
+#include <mutex>
+#include <random>
+#include <vector>
+#include <ApiClient.h>
+#include <ApiText.h>
+#include "NativeHost.h"
+
+#define FLEET_STEP_MS 10        // How often each virtual keypad checks for work
+#define FLEET_SOURCE_VIEWS 5    // One touch in this many opens the source list instead of changing volume
+#define FLEET_STACK 16384
+
+
+/*********/
+/* Stats */
+/*********/
+
+enum Endpoint : uint8_t
+{
+    EP_STATUS,
+    EP_ZONES,
+    EP_SOURCES,
+    EP_STREAMS,
+    EP_IMAGE,
+    EP_PATCH,
+    ENDPOINTS
+};
+
+static const char *endpointNames[ENDPOINTS] = {"status", "zones", "sources", "streams", "image", "patch"};
+
+struct EndpointStats
+{
+    uint32_t requests;
+    uint32_t errors;
+    uint32_t notModified;
+    uint64_t bytes;
+    std::vector<float> ms;
+};
+
+// Results from every keypad, kept per report period and for the whole run
+class FleetStats
+{
+public:
+    void record(Endpoint e, bool ok, bool notModified, size_t bytes, uint32_t ms)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (EndpointStats *s : {&period[e], &run[e]})
+        {
+            ++s->requests;
+            if (!ok) { ++s->errors; }
+            if (notModified) { ++s->notModified; }
+            s->bytes += bytes;
+            s->ms.push_back((float)ms);
+        }
+    }
+
+    // Print one report line and start a new period
+    void report(uint32_t now, int keypads, bool final)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EndpointStats *stats = final ? run : period;
+        uint32_t since = final ? runStart : periodStart;
+        float seconds = max(0.001f, (now - since) / 1000.0f);
+
+        uint32_t total = 0, errors = 0;
+        String line = "{\"t_ms\":" + String(now) + ",\"final\":" + String(final ? "true" : "false") + ",\"keypads\":" + String(keypads) + ",\"endpoints\":{";
+        bool first = true;
+        for (int e = 0; e < ENDPOINTS; e++)
+        {
+            EndpointStats &s = stats[e];
+            total += s.requests;
+            errors += s.errors;
+            if (s.requests == 0)
+                continue;
+            std::sort(s.ms.begin(), s.ms.end());
+            char entry[256];
+            snprintf(entry, sizeof(entry),
+                     "%s\"%s\":{\"requests\":%u,\"rate_per_s\":%.2f,\"error_rate\":%.4f,\"not_modified\":%u,\"kb_per_s\":%.1f,\"p50_ms\":%.0f,\"p90_ms\":%.0f,\"p99_ms\":%.0f,\"max_ms\":%.0f}",
+                     first ? "" : ",", endpointNames[e], (unsigned)s.requests, s.requests / seconds, (float)s.errors / s.requests,
+                     (unsigned)s.notModified, s.bytes / 1024.0f / seconds, percentile(s.ms, 0.50f), percentile(s.ms, 0.90f),
+                     percentile(s.ms, 0.99f), s.ms.back());
+            line += entry;
+            first = false;
+        }
+        char totals[128];
+        snprintf(totals, sizeof(totals), "},\"requests\":%u,\"rate_per_s\":%.2f,\"error_rate\":%.4f}", (unsigned)total, total / seconds,
+                 total ? (float)errors / total : 0.0f);
+        line += totals;
+        Serial.println(line);
+
+        for (EndpointStats &s : period) { s = EndpointStats{}; }
+        periodStart = now;
+    }
+
+    void start(uint32_t now)
+    {
+        runStart = now;
+        periodStart = now;
+    }
+
+private:
+    static float percentile(const std::vector<float> &sorted, float fraction)
+    {
+        size_t i = (size_t)(fraction * sorted.size());
+        return sorted[min(i, sorted.size() - 1)];
+    }
+
+    std::mutex mutex;
+    EndpointStats period[ENDPOINTS];
+    EndpointStats run[ENDPOINTS];
+    uint32_t runStart = 0;
+    uint32_t periodStart = 0;
+};
+
+FleetStats fleetStats;
+
+
+/************/
+/* Settings */
+/************/
+
+enum Strategy : uint8_t
+{
+    STRATEGY_FIXED,
+    STRATEGY_ADAPTIVE,
+    STRATEGY_ETAG,
+};
+
+struct FleetSettings
+{
+    int keypads;
+    Strategy strategy;
+    uint32_t rampMs;
+    float touchesPerHour;
+    int zones;
+    int sources;
+    uint32_t reportMs;
+};
+
+FleetSettings fleet;
+String amplipiHost;
+ApiCodec apiCodec(API_MSGPACK);
+
+static long envNumber(const char *name, long fallback)
+{
+    const char *value = getenv(name);
+    return value ? atol(value) : fallback;
+}
+
+
+/*******************/
+/* Virtual keypads */
+/*******************/
+
+struct VirtualKeypad
+{
+    int index;
+    int zone;
+    int source;
+    PollScheduler scheduler;
+    ResponseFingerprint zoneSeen, sourceSeen, streamSeen;
+    AsyncHttpGet zoneGet, sourceGet;
+    String streamID;
+    String albumArt; // Art reference the stream last showed
+    int volume;
+    uint32_t nextTouch;
+    std::mt19937 rng;
+};
+
+std::vector<VirtualKeypad *> keypads;
+std::atomic<int> keypadsRunning(0);
+
+// GET with the headers requestAPI() sends. Returns the HTTP status, or a negative error.
+static int fleetGet(Endpoint e, const String &resource, String &payload)
+{
+    HTTPClient http;
+    uint32_t startedAt = millis();
+    http.begin(apiUrl(amplipiHost.c_str(), resource));
+    apiPrepareGet(http, apiCodec);
+
+    int httpCode = http.GET();
+    payload = "";
+    if (httpCode == HTTP_CODE_OK)
+    {
+        int size = http.getSize();
+        if (!apiReadBody(http, apiCodec, payload)) { httpCode = HTTPC_ERROR_ENCODING; }
+        fleetStats.record(e, httpCode == HTTP_CODE_OK, false, size > 0 ? size : payload.length(), millis() - startedAt);
+    }
+    else
+    {
+        fleetStats.record(e, false, false, 0, millis() - startedAt);
+    }
+    http.end();
+    return httpCode;
+}
+
+// Download album art the way downloadAlbumart() does, reading it a buffer at a time
+static void fleetDownload(const String &streamID)
+{
+    HTTPClient http;
+    uint32_t startedAt = millis();
+    http.setConnectTimeout(API_TIMEOUT);
+    http.setTimeout(API_TIMEOUT);
+    http.begin(apiUrl(amplipiHost.c_str(), "streams/image/" + streamID));
+
+    int httpCode = http.GET();
+    size_t bytes = 0;
+    if (httpCode == HTTP_CODE_OK)
+    {
+        int len = http.getSize();
+        uint8_t buff[128];
+        WiFiClient *stream = http.getStreamPtr();
+        while (http.connected() && (len > 0 || len == -1))
+        {
+            int n = stream->readBytes(buff, min(sizeof(buff), (size_t)(len > 0 ? len : sizeof(buff))));
+            if (n <= 0)
+                break;
+            bytes += n;
+            if (len > 0) { len -= n; }
+        }
+        if (len > 0) { httpCode = HTTPC_ERROR_CONNECTION_LOST; }
+    }
+    http.end();
+    fleetStats.record(EP_IMAGE, httpCode == HTTP_CODE_OK, false, bytes, millis() - startedAt);
+}
+
+// PATCH the way patchAPI() does, falling back to JSON if AmpliPi refuses MessagePack
+static bool fleetPatch(const String &resource, const String &payload)
+{
+    HTTPClient http;
+    uint32_t startedAt = millis();
+    uint8_t packed[API_PACKED_MAX];
+    http.begin(apiUrl(amplipiHost.c_str(), resource));
+    size_t packedSize = apiPreparePatch(http, apiCodec, payload, packed);
+    int httpCode = apiSendPatch(http, payload, packed, packedSize);
+    size_t bytes = (httpCode > 0) ? http.getString().length() : 0;
+    http.end();
+    fleetStats.record(EP_PATCH, httpCode == HTTP_CODE_OK, false, bytes, millis() - startedAt);
+
+    if (packedSize && apiCodec.refused(httpCode)) { return fleetPatch(resource, payload); }
+    return httpCode == HTTP_CODE_OK;
+}
+
+// Start a polled GET, conditional if the strategy uses ETags
+static void startPoll(AsyncHttpGet &get, const ResponseFingerprint &seen, const String &request)
+{
+    apiStartPoll(get, amplipiHost.c_str(), apiCodec, seen, request, fleet.strategy == STRATEGY_ETAG);
+}
+
+// Collect a polled GET, the way takePolledGet() does
+static ResponseChange takePoll(Endpoint e, AsyncHttpGet &get, ResponseFingerprint &seen, const String &request, String &json)
+{
+    return apiTakePoll(get, seen, request, json, [e](AsyncHttpGet &poll, const String & /*request*/, String &body) {
+        uint32_t ms = poll.elapsed();
+        bool notModified = poll.notModified();
+        bool ok = poll.take(body);
+        fleetStats.record(e, ok, notModified, body.length(), ms);
+        if (ok) { apiCodec.received(body); }
+        return ok;
+    });
+}
+
+static uint32_t nextTouchDelay(VirtualKeypad &k)
+{
+    if (fleet.touchesPerHour <= 0)
+        return UINT32_MAX / 2;
+    std::exponential_distribution<float> gap(fleet.touchesPerHour / 3600000.0f);
+    return (uint32_t)min(gap(k.rng), (float)(UINT32_MAX / 2));
+}
+
+static void touch(VirtualKeypad &k, uint32_t now)
+{
+    k.scheduler.interaction(now);
+    k.nextTouch = now + nextTouchDelay(k);
+
+    if (k.rng() % FLEET_SOURCE_VIEWS == 0)
+    {
+        String json;
+        fleetGet(EP_STATUS, "", json);
+        return;
+    }
+
+    k.volume = constrain(k.volume + (int)(k.rng() % 11) - 5, -79, 0);
+    fleetPatch("zones/" + String(k.zone), volumePayload(k.volume));
+    k.zoneSeen.forget();
+}
+
+// One pass of the keypad's refresh flow: zones and source together, then the stream and art
+static void refresh(VirtualKeypad &k)
+{
+    String json;
+    String zonePath = "zones/" + String(k.zone);
+    String sourcePath = "sources/" + String(k.source);
+
+    bool fetchZones = k.scheduler.due(POLL_ZONES, millis());
+    bool fetchSource = k.scheduler.due(POLL_SOURCE, millis());
+    if (fetchZones) { startPoll(k.zoneGet, k.zoneSeen, zonePath); }
+    if (fetchSource) { startPoll(k.sourceGet, k.sourceSeen, sourcePath); }
+    while ((fetchZones && !k.zoneGet.finished()) || (fetchSource && !k.sourceGet.finished()))
+    {
+        delay(1);
+    }
+
+    if (fetchZones)
+    {
+        ResponseChange change = takePoll(EP_ZONES, k.zoneGet, k.zoneSeen, zonePath, json);
+        k.scheduler.polled(POLL_ZONES, millis(), change == RESPONSE_NEW);
+    }
+    String streamID;
+    if (fetchSource)
+    {
+        switch (takePoll(EP_SOURCES, k.sourceGet, k.sourceSeen, sourcePath, json))
+        {
+        case RESPONSE_NEW:
+        {
+            DynamicJsonDocument doc(API_SOURCE_DOC_SIZE);
+            if (!ApiCodec::deserialize(doc, json))
+            {
+                String input = doc["input"].as<String>();
+                streamID = (input == "local") ? "0" : getValue(input, '=', 1);
+            }
+            break;
+        }
+        case RESPONSE_UNCHANGED: streamID = k.streamID; break;
+        default: break;
+        }
+    }
+
+    if (!followSource(k.scheduler, millis(), fetchSource, streamID, k.streamID))
+        return;
+    if (!k.scheduler.due(POLL_STREAM, millis()))
+        return;
+    if (k.streamID == "0")
+    {
+        // Local input, nothing to poll
+        k.scheduler.setPlaying(false);
+        k.scheduler.reschedule(POLL_STREAM, millis());
+        return;
+    }
+
+    String streamPath = "streams/" + k.streamID;
+    if ((fleetGet(EP_STREAMS, streamPath, json) != HTTP_CODE_OK) || k.streamSeen.same(streamPath, json))
+    {
+        k.scheduler.polled(POLL_STREAM, millis(), false);
+        return;
+    }
+
+    DynamicJsonDocument doc(API_STREAM_DOC_SIZE);
+    bool changed = false;
+    if (!ApiCodec::deserialize(doc, json))
+    {
+        k.scheduler.setPlaying(doc["status"].as<String>() == "playing");
+        String art = doc["info"]["img_url"].as<String>();
+        if (art != k.albumArt)
+        {
+            k.albumArt = art;
+            changed = true;
+            k.scheduler.trackChanged(millis());
+            fleetDownload(k.streamID);
+        }
+    }
+    k.scheduler.polled(POLL_STREAM, millis(), changed);
+}
+
+void keypadTask(void *parameter)
+{
+    VirtualKeypad &k = *static_cast<VirtualKeypad *>(parameter);
+    ++keypadsRunning;
+    k.nextTouch = millis() + nextTouchDelay(k);
+    k.scheduler.pollNow(millis());
+
+    for (;;)
+    {
+        uint32_t now = millis();
+        if ((int32_t)(now - k.nextTouch) >= 0) { touch(k, now); }
+        if (k.scheduler.anyDue(millis())) { refresh(k); }
+        delay(FLEET_STEP_MS);
+    }
+}
+
+
+/*********/
+/* Setup */
+/*********/
+
+// Ask the AmpliPi simulator for its own view of the load. Any other server just says 404.
+static void serverStats(const char *method)
+{
+    HTTPClient http;
+    http.setConnectTimeout(2000);
+    http.begin("http://" + amplipiHost + "/sim/" + String(strcmp(method, "POST") ? "stats" : "reset"));
+    int httpCode = http.sendRequest(method);
+    if ((httpCode == HTTP_CODE_OK) && (strcmp(method, "GET") == 0))
+    {
+        String stats = http.getString();
+        stats.replace("\n", "");
+        Serial.println("{\"server\":" + stats + "}");
+    }
+    http.end();
+}
+
+static void finalReport()
+{
+    fleetStats.report(millis(), keypadsRunning, true);
+    serverStats("GET");
+}
+
+uint32_t startedAt;
+uint32_t nextReport;
+int keypadsStarted = 0;
+
+void setup()
+{
+    Serial.begin(115200);
+
+    WiFi.begin("fleet"); // The host's network, always up
+
+    const char *host = getenv("KEYPAD_AMPLIPIHOST");
+    amplipiHost = host ? host : "127.0.0.1:8080";
+
+    fleet.keypads = envNumber("FLEET_KEYPADS", 10);
+    String strategy = getenv("FLEET_STRATEGY") ? getenv("FLEET_STRATEGY") : "etag";
+    fleet.strategy = (strategy == "fixed") ? STRATEGY_FIXED : (strategy == "adaptive") ? STRATEGY_ADAPTIVE : STRATEGY_ETAG;
+    fleet.rampMs = envNumber("FLEET_RAMP_MS", 0);
+    fleet.touchesPerHour = envNumber("FLEET_TOUCHES_PER_HOUR", 6);
+    fleet.zones = max(1L, envNumber("FLEET_ZONES", 6));
+    fleet.sources = max(1L, envNumber("FLEET_SOURCES", 4));
+    fleet.reportMs = max(100L, envNumber("FLEET_REPORT_MS", 10000));
+
+    Serial.printf("Fleet of %d keypads on %s, %s polling\n", fleet.keypads, amplipiHost.c_str(),
+                  fleet.strategy == STRATEGY_FIXED ? "fixed" : fleet.strategy == STRATEGY_ADAPTIVE ? "adaptive" : "etag");
+
+    for (int i = 0; i < fleet.keypads; i++)
+    {
+        VirtualKeypad *k = new VirtualKeypad();
+        k->index = i;
+        k->zone = i % fleet.zones;
+        k->source = i % fleet.sources;
+        k->volume = -40;
+        k->rng.seed(i + 1);
+        k->scheduler.seed(0x9E3779B9u * (i + 1));
+        if (fleet.strategy == STRATEGY_FIXED)
+        {
+            for (uint8_t r = 0; r < POLL_RESOURCES; r++)
+                k->scheduler.configure((PollResource)r, PollIntervals{REFRESH_INTERVAL, REFRESH_INTERVAL, REFRESH_INTERVAL});
+        }
+        else
+        {
+            configurePolling(k->scheduler, REFRESH_INTERVAL);
+        }
+        keypads.push_back(k);
+    }
+
+    serverStats("POST");
+    NativeHost::onExit(finalReport);
+    startedAt = millis();
+    nextReport = startedAt + fleet.reportMs;
+    fleetStats.start(startedAt);
+}
+
+void loop()
+{
+    uint32_t now = millis();
+
+    // Keypads power up spread over the ramp
+    while ((keypadsStarted < fleet.keypads) &&
+           ((fleet.rampMs == 0) || ((uint64_t)(now - startedAt) * fleet.keypads >= (uint64_t)keypadsStarted * fleet.rampMs)))
+    {
+        xTaskCreate(keypadTask, "keypad", FLEET_STACK, keypads[keypadsStarted], 1, nullptr);
+        ++keypadsStarted;
+    }
+
+    if ((int32_t)(now - nextReport) >= 0)
+    {
+        fleetStats.report(now, keypadsRunning, false);
+        nextReport += fleet.reportMs;
+    }
+    delay(10);
+}